@@ -0,0 +1,665 @@
+// Microbenchmarks of the simulation kernels: times each simulation's update
+// across grid sizes, worker counts and backends (engines, update schemes,
+// samplers) with warmup and repeated trials, and reports throughput in the
+// kernel's own unit (cell-updates/s, spin-flips/s, samples/s, integrator
+// steps/s) as JSON. Built with SIM_HEADLESS like batch.c.
+//
+//   sim_bench --out baseline.json
+//   sim_bench --compare baseline.json --tolerance 10
+//
+// With --compare every case is matched against the baseline's by kernel,
+// backend, size and threads; medians more than the tolerance below the
+// baseline are flagged and the exit status is 1.
+#include "sokol_time.h"
+
+#include "simulations/simulations.h"
+#include "simulations/workers.h"
+#include "simulations/rng.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SEED 12345
+#define BENCH_MAX_SIZES 4
+#define BENCH_MAX_BACKENDS 6
+#define BENCH_MAX_TRIALS 64
+#define BENCH_MAX_THREADS 16           // Entries in the thread count list
+#define BENCH_PENDULUM_SUBSTEPS 4      // Integrator steps per update
+#define BENCH_STR_(x) #x
+#define BENCH_STR(x) BENCH_STR_(x)
+
+typedef struct bench_obs_t {
+    sim_observable_t values[SIM_MAX_OBSERVABLES];
+    int count;
+} bench_obs_t;
+
+// Work done by `updates` calls of update at `size`, in the kernel's unit
+typedef double (*bench_work_fn)(int size, long updates, const bench_obs_t* before, const bench_obs_t* after);
+
+typedef struct bench_backend_t {
+    const char* name;
+    const char* settings;              // "Name=value;Name=value"
+    bool parallel;                     // Runs on the worker pool, so thread counts matter
+} bench_backend_t;
+
+typedef struct bench_kernel_t {
+    const char* name;
+    simulation_id_t sim;
+    const char* unit;
+    const char* size_setting;
+    int sizes[BENCH_MAX_SIZES];        // 0-terminated
+    int quick_sizes[BENCH_MAX_SIZES];
+    const char* settings;              // For every case of the kernel
+    bench_backend_t backends[BENCH_MAX_BACKENDS];   // Up to the first without a name
+    bench_work_fn work;
+} bench_kernel_t;
+
+static double bench_obs(const bench_obs_t* obs, const char* name) {
+    return sim_observable_find(obs->values, obs->count, name, 0.0);
+}
+
+// Generations advanced times the cells of the Grid Size square (the
+// unbounded engines are credited with the square they were seeded with)
+static double bench_gol_work(int size, long updates, const bench_obs_t* before, const bench_obs_t* after) {
+    (void)updates;
+    return (bench_obs(after, "generation") - bench_obs(before, "generation")) * (double)size * size;
+}
+
+// One sweep per update: every spin attempted once on average
+static double bench_ising_work(int size, long updates, const bench_obs_t* before, const bench_obs_t* after) {
+    (void)before;
+    (void)after;
+    return (double)updates * size * size;
+}
+
+static double bench_mcpi_work(int size, long updates, const bench_obs_t* before, const bench_obs_t* after) {
+    (void)size;
+    (void)updates;
+    return bench_obs(after, "samples") - bench_obs(before, "samples");
+}
+
+// Substeps of every update, times every pendulum in the ensemble
+static double bench_pendulum_work(int size, long updates, const bench_obs_t* before, const bench_obs_t* after) {
+    (void)before;
+    (void)after;
+    return (double)updates * BENCH_PENDULUM_SUBSTEPS * size;
+}
+
+static const bench_kernel_t bench_kernels[] = {
+    { "gol", SIM_GOL, "cell-updates/s", "Grid Size", {256, 1024, 4096}, {256, 1024}, "",
+      { {"bitgrid", "Engine=0", true},
+        {"chunks", "Engine=2", true},
+        {"hashlife", "Engine=1;Step 2^k Generations=0", false} },
+      bench_gol_work },
+    { "ising", SIM_ISING, "spin-flips/s", "Grid Size", {256, 1024, 4096}, {256, 1024}, "Temperature=2.269",
+      { {"checkerboard", "Update=0", true},
+        {"multispin", "Update=2", true},
+        {"wolff", "Update=3", false},
+        {"swendsen_wang", "Update=4", true} },
+      bench_ising_work },
+    { "mcpi", SIM_MCPI, "samples/s", NULL, {0}, {0}, "Chunks per Update=4;Compare All Samplers=false",
+      { {"random", "Mode=1;Sampler=0", false},
+        {"sobol", "Mode=1;Sampler=1", false},
+        {"halton", "Mode=1;Sampler=2", false},
+        {"stratified", "Mode=1;Sampler=3", false},
+        {"parallel", "Mode=2", true} },
+      bench_mcpi_work },
+    { "pendulum", SIM_PENDULUM, "integrator-steps/s", "Pendulums", {1024, 16384, 131072}, {1024, 16384},
+      "Mode=1;Substeps=" BENCH_STR(BENCH_PENDULUM_SUBSTEPS),
+      { {"single", "Double Pendulums=false", true},
+        {"double", "Double Pendulums=true", true} },
+      bench_pendulum_work },
+};
+#define BENCH_KERNEL_COUNT ((int)(sizeof(bench_kernels) / sizeof(bench_kernels[0])))
+
+typedef struct bench_options_t {
+    const char* kernels;               // Comma-separated names, NULL for all
+    int threads[BENCH_MAX_THREADS];
+    int thread_count;
+    int trials;
+    double warmup_ms;
+    double trial_ms;
+    bool quick;
+    bool list;
+    const char* out;
+    const char* compare;
+    double tolerance;                  // Percent
+} bench_options_t;
+
+typedef struct bench_result_t {
+    const char* kernel;
+    const char* backend;
+    const char* unit;
+    int size;
+    int threads;
+    int trial_count;
+    double trials[BENCH_MAX_TRIALS];   // Throughput per trial
+    double median, mean, stddev, min, max;
+    double updates_per_sec;            // Median
+    bool compared;
+    double baseline;                   // Baseline median when compared
+} bench_result_t;
+
+// -----------------------------------------------------------------------------
+// Settings
+// -----------------------------------------------------------------------------
+// Every setting's default, restored before each case so cases do not leak
+// into each other; sized from the registry
+typedef struct bench_default_t {
+    void* target;
+    size_t size;
+    union { float f; int i; bool b; } value;
+} bench_default_t;
+static bench_default_t* bench_defaults = NULL;
+static int bench_default_count = 0;
+
+static void bench_save_defaults(void) {
+    int total = 0;
+    for (int s = 0; s < SIM_COUNT; s++) {
+        int16_t count;
+        sim_runtime_get((simulation_id_t)s)->settings(&count);
+        total += count;
+    }
+    bench_defaults = calloc((size_t)(total > 0 ? total : 1), sizeof(bench_default_t));
+    for (int s = 0; s < SIM_COUNT; s++) {
+        int16_t count;
+        sim_parameter_t* params = sim_runtime_get((simulation_id_t)s)->settings(&count);
+        for (int16_t i = 0; i < count; i++) {
+            sim_parameter_t* p = &params[i];
+            bench_default_t* d = &bench_defaults[bench_default_count++];
+            d->target = p->value_ptr;
+            d->size = p->type == SIM_PARAM_FLOAT ? sizeof(float) : p->type == SIM_PARAM_INT ? sizeof(int) : sizeof(bool);
+            memcpy(&d->value, p->value_ptr, d->size);
+        }
+    }
+}
+
+static void bench_restore_defaults(void) {
+    for (int i = 0; i < bench_default_count; i++) {
+        memcpy(bench_defaults[i].target, &bench_defaults[i].value, bench_defaults[i].size);
+    }
+}
+
+// Apply "Name=value;Name=value"; exits on a bad setting, since that is a
+// bug in the case table
+static void bench_apply(const sim_runtime_t* sim, const char* settings) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", settings);
+    for (char* item = strtok(buffer, ";"); item; item = strtok(NULL, ";")) {
+        char error[256];
+        if (!sim_runtime_set(sim, item, error, sizeof(error))) {
+            fprintf(stderr, "sim_bench: %s\n", error);
+            exit(2);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Measurement
+// -----------------------------------------------------------------------------
+static int bench_compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double bench_median(const double* values, int count) {
+    double sorted[BENCH_MAX_TRIALS];
+    memcpy(sorted, values, (size_t)count * sizeof(double));
+    qsort(sorted, (size_t)count, sizeof(double), bench_compare_double);
+    return (count % 2) ? sorted[count / 2] : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+}
+
+// Update until at least `ms` have passed; returns the seconds taken
+static double bench_run(const sim_runtime_t* sim, double ms, long* updates) {
+    uint64_t start = stm_now();
+    long n = 0;
+    do {
+        sim->update(sim->timestep);
+        n++;
+    } while (stm_ms(stm_since(start)) < ms);
+    *updates = n;
+    return stm_sec(stm_since(start));
+}
+
+static void bench_case(const bench_kernel_t* kernel, const bench_backend_t* backend, int size, int threads,
+                       const bench_options_t* opt, bench_result_t* result) {
+    const sim_runtime_t* sim = sim_runtime_get(kernel->sim);
+    bench_restore_defaults();
+    bench_apply(sim, kernel->settings);
+    bench_apply(sim, backend->settings);
+    if (kernel->size_setting) {
+        char assignment[128];
+        snprintf(assignment, sizeof(assignment), "%s=%d", kernel->size_setting, size);
+        bench_apply(sim, assignment);
+    }
+    sim_workers_set_count(threads);
+    sim_rng_set_seed(BENCH_SEED);
+    sim->init();
+
+    // Warmup: caches, page faults, lazily built tables, the parallel mode's
+    // calibration
+    long updates;
+    bench_run(sim, opt->warmup_ms, &updates);
+
+    *result = (bench_result_t){
+        .kernel = kernel->name, .backend = backend->name, .unit = kernel->unit,
+        .size = size, .threads = threads, .trial_count = opt->trials,
+    };
+    double rates[BENCH_MAX_TRIALS];
+    for (int t = 0; t < opt->trials; t++) {
+        bench_obs_t before, after;
+        before.count = sim->observe(before.values);
+        double seconds = bench_run(sim, opt->trial_ms, &updates);
+        after.count = sim->observe(after.values);
+        result->trials[t] = kernel->work(size, updates, &before, &after) / seconds;
+        rates[t] = (double)updates / seconds;
+    }
+    sim->destroy();
+
+    double sum = 0.0, sum2 = 0.0;
+    result->min = result->max = result->trials[0];
+    for (int t = 0; t < opt->trials; t++) {
+        double v = result->trials[t];
+        sum += v;
+        result->min = fmin(result->min, v);
+        result->max = fmax(result->max, v);
+    }
+    result->mean = sum / opt->trials;
+    for (int t = 0; t < opt->trials; t++) {
+        double d = result->trials[t] - result->mean;
+        sum2 += d * d;
+    }
+    result->stddev = opt->trials > 1 ? sqrt(sum2 / (opt->trials - 1)) : 0.0;
+    result->median = bench_median(result->trials, opt->trials);
+    result->updates_per_sec = bench_median(rates, opt->trials);
+}
+
+// -----------------------------------------------------------------------------
+// Baseline comparison
+// -----------------------------------------------------------------------------
+// Baselines are files this program wrote, one result object per line, so a
+// key lookup per line is all the JSON parsing needed
+typedef struct bench_baseline_t {
+    char kernel[32];
+    char backend[32];
+    int size;
+    int threads;
+    double median;
+} bench_baseline_t;
+
+static const char* bench_json_value(const char* line, const char* key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char* at = strstr(line, pattern);
+    if (!at) {
+        return NULL;
+    }
+    at += strlen(pattern);
+    while (*at == ' ') {
+        at++;
+    }
+    return at;
+}
+
+static bool bench_json_string(const char* line, const char* key, char* out, size_t size) {
+    const char* at = bench_json_value(line, key);
+    if (!at || *at != '"') {
+        return false;
+    }
+    const char* end = strchr(++at, '"');
+    if (!end || (size_t)(end - at) >= size) {
+        return false;
+    }
+    memcpy(out, at, (size_t)(end - at));
+    out[end - at] = '\0';
+    return true;
+}
+
+static bool bench_json_number(const char* line, const char* key, double* out) {
+    const char* at = bench_json_value(line, key);
+    char* end;
+    if (!at) {
+        return false;
+    }
+    *out = strtod(at, &end);
+    return end != at;
+}
+
+// Every result line of an open baseline; NULL with *count 0 when none parse
+static bench_baseline_t* bench_load_baseline(FILE* f, int* count) {
+    bench_baseline_t* entries = NULL;
+    int capacity = 0;
+    *count = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        bench_baseline_t e;
+        double size, threads;
+        if (!bench_json_string(line, "kernel", e.kernel, sizeof(e.kernel)) ||
+            !bench_json_string(line, "backend", e.backend, sizeof(e.backend)) ||
+            !bench_json_number(line, "size", &size) || !bench_json_number(line, "threads", &threads) ||
+            !bench_json_number(line, "median", &e.median)) {
+            continue;
+        }
+        e.size = (int)size;
+        e.threads = (int)threads;
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            entries = realloc(entries, (size_t)capacity * sizeof(bench_baseline_t));
+        }
+        entries[(*count)++] = e;
+    }
+    return entries;
+}
+
+static const bench_baseline_t* bench_find_baseline(const bench_baseline_t* entries, int count, const bench_result_t* r) {
+    for (int i = 0; i < count; i++) {
+        const bench_baseline_t* e = &entries[i];
+        if (strcmp(e->kernel, r->kernel) == 0 && strcmp(e->backend, r->backend) == 0 &&
+            e->size == r->size && e->threads == r->threads) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Output
+// -----------------------------------------------------------------------------
+static void bench_write_json(FILE* out, const bench_options_t* opt, const bench_result_t* results, int count) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"version\": 1,\n");
+    fprintf(out, "  \"hardware_threads\": %d,\n", sim_workers_hardware_count());
+    fprintf(out, "  \"trials\": %d,\n", opt->trials);
+    fprintf(out, "  \"warmup_ms\": %g,\n", opt->warmup_ms);
+    fprintf(out, "  \"trial_ms\": %g,\n", opt->trial_ms);
+    fprintf(out, "  \"results\": [\n");
+    for (int i = 0; i < count; i++) {
+        const bench_result_t* r = &results[i];
+        fprintf(out, "    {\"kernel\": \"%s\", \"backend\": \"%s\", \"size\": %d, \"threads\": %d, \"unit\": \"%s\", "
+                     "\"median\": %.6g, \"mean\": %.6g, \"stddev\": %.6g, \"min\": %.6g, \"max\": %.6g, "
+                     "\"updates_per_sec\": %.6g, \"trials\": [",
+                r->kernel, r->backend, r->size, r->threads, r->unit,
+                r->median, r->mean, r->stddev, r->min, r->max, r->updates_per_sec);
+        for (int t = 0; t < r->trial_count; t++) {
+            fprintf(out, "%s%.6g", t ? ", " : "", r->trials[t]);
+        }
+        fprintf(out, "]");
+        if (r->compared) {
+            fprintf(out, ", \"baseline\": %.6g, \"change\": %.4f", r->baseline, r->median / r->baseline - 1.0);
+        }
+        fprintf(out, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void bench_print_row(const bench_result_t* r) {
+    fprintf(stderr, "%-9s %-14s %7d %3dt  %11.4g %-19s +-%5.1f%%  %9.1f upd/s",
+            r->kernel, r->backend, r->size, r->threads, r->median, r->unit,
+            r->mean > 0.0 ? 100.0 * r->stddev / r->mean : 0.0, r->updates_per_sec);
+}
+
+// -----------------------------------------------------------------------------
+// Options
+// -----------------------------------------------------------------------------
+static void bench_usage(FILE* f) {
+    fprintf(f,
+        "usage: sim_bench [options]\n"
+        "  --kernel LIST       comma-separated kernels: gol,ising,mcpi,pendulum (default all)\n"
+        "  --threads LIST      comma-separated worker counts (default: powers of two up to\n"
+        "                      the hardware threads, and the hardware threads)\n"
+        "  --trials N          timed trials per case (default 5)\n"
+        "  --warmup-ms MS      untimed updates before the trials (default 100)\n"
+        "  --trial-ms MS       minimum length of a trial (default 200)\n"
+        "  --quick             skip the largest size of every kernel\n"
+        "  --out FILE          write JSON to FILE instead of stdout\n"
+        "  --compare FILE      flag cases slower than the baseline JSON FILE\n"
+        "  --tolerance PCT     slowdown allowed by --compare (default 10)\n"
+        "  --list              list the cases that would run\n");
+}
+
+static bool bench_list_has(const char* list, const char* name) {
+    if (!list) {
+        return true;
+    }
+    size_t len = strlen(name);
+    for (const char* at = list; *at; ) {
+        const char* end = strchr(at, ',');
+        size_t n = end ? (size_t)(end - at) : strlen(at);
+        if (n == len && strncmp(at, name, len) == 0) {
+            return true;
+        }
+        at += n + (end ? 1 : 0);
+    }
+    return false;
+}
+
+// Comma-separated worker counts; returns how many, 0 if malformed
+static int bench_parse_threads(const char* text, int* threads) {
+    int count = 0;
+    for (const char* at = text; *at; ) {
+        char* end;
+        long n = strtol(at, &end, 10);
+        if (end == at || n < 1 || n > SIM_WORKERS_MAX || count == BENCH_MAX_THREADS) {
+            return 0;
+        }
+        threads[count++] = (int)n;
+        if (*end == ',') {
+            end++;
+        } else if (*end) {
+            return 0;
+        }
+        at = end;
+    }
+    return count;
+}
+
+static void bench_default_threads(bench_options_t* opt) {
+    int hardware = sim_workers_hardware_count();
+    opt->thread_count = 0;
+    for (int n = 1; n < hardware && opt->thread_count < BENCH_MAX_THREADS - 1; n *= 2) {
+        opt->threads[opt->thread_count++] = n;
+    }
+    opt->threads[opt->thread_count++] = hardware;
+}
+
+static bool bench_parse(int argc, char** argv, bench_options_t* opt) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--quick") == 0) {
+            opt->quick = true;
+            continue;
+        }
+        if (strcmp(arg, "--list") == 0) {
+            opt->list = true;
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            bench_usage(stdout);
+            exit(0);
+        }
+        if (!value) {
+            fprintf(stderr, "sim_bench: unknown option or missing value: %s\n", arg);
+            return false;
+        }
+        i++;
+        char* end;
+        double x = strtod(value, &end);
+        bool number = end != value && *end == '\0';
+        int thread_count;
+        if (strcmp(arg, "--kernel") == 0) {
+            opt->kernels = value;
+        } else if (strcmp(arg, "--threads") == 0 && (thread_count = bench_parse_threads(value, opt->threads)) > 0) {
+            opt->thread_count = thread_count;
+        } else if (strcmp(arg, "--trials") == 0 && number && x >= 1 && x <= BENCH_MAX_TRIALS) {
+            opt->trials = (int)x;
+        } else if (strcmp(arg, "--warmup-ms") == 0 && number && x >= 0) {
+            opt->warmup_ms = x;
+        } else if (strcmp(arg, "--trial-ms") == 0 && number && x > 0) {
+            opt->trial_ms = x;
+        } else if (strcmp(arg, "--out") == 0) {
+            opt->out = value;
+        } else if (strcmp(arg, "--compare") == 0) {
+            opt->compare = value;
+        } else if (strcmp(arg, "--tolerance") == 0 && number && x >= 0 && x < 100) {
+            opt->tolerance = x;
+        } else {
+            fprintf(stderr, "sim_bench: bad option: %s %s\n", arg, value);
+            return false;
+        }
+    }
+    for (const char* at = opt->kernels; at && *at; ) {
+        const char* end = strchr(at, ',');
+        size_t n = end ? (size_t)(end - at) : strlen(at);
+        bool found = false;
+        for (int k = 0; k < BENCH_KERNEL_COUNT; k++) {
+            found |= strlen(bench_kernels[k].name) == n && strncmp(at, bench_kernels[k].name, n) == 0;
+        }
+        if (!found) {
+            fprintf(stderr, "sim_bench: unknown kernel in --kernel %s\n", opt->kernels);
+            return false;
+        }
+        at += n + (end ? 1 : 0);
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Main
+// -----------------------------------------------------------------------------
+// Calls `fn` for every selected case, in table order
+typedef void (*bench_case_fn)(const bench_kernel_t* kernel, const bench_backend_t* backend, int size, int threads, void* user);
+
+static void bench_for_each_case(const bench_options_t* opt, bench_case_fn fn, void* user) {
+    for (int k = 0; k < BENCH_KERNEL_COUNT; k++) {
+        const bench_kernel_t* kernel = &bench_kernels[k];
+        if (!bench_list_has(opt->kernels, kernel->name)) {
+            continue;
+        }
+        const int* sizes = opt->quick ? kernel->quick_sizes : kernel->sizes;
+        int size_count = 0;
+        while (size_count < BENCH_MAX_SIZES && sizes[size_count] > 0) {
+            size_count++;
+        }
+        for (int s = 0; s < (size_count ? size_count : 1); s++) {
+            for (int b = 0; b < BENCH_MAX_BACKENDS && kernel->backends[b].name; b++) {
+                const bench_backend_t* backend = &kernel->backends[b];
+                for (int t = 0; t < opt->thread_count; t++) {
+                    // Serial backends only run once, on one worker
+                    if (!backend->parallel && t > 0) {
+                        break;
+                    }
+                    fn(kernel, backend, size_count ? sizes[s] : 0, backend->parallel ? opt->threads[t] : 1, user);
+                }
+            }
+        }
+    }
+}
+
+static void bench_list_case(const bench_kernel_t* kernel, const bench_backend_t* backend, int size, int threads, void* user) {
+    (void)user;
+    printf("%-9s %-14s %7d %3dt\n", kernel->name, backend->name, size, threads);
+}
+
+typedef struct bench_run_t {
+    const bench_options_t* opt;
+    bench_result_t* results;
+    int count;
+    int capacity;
+} bench_run_t;
+
+static void bench_run_case(const bench_kernel_t* kernel, const bench_backend_t* backend, int size, int threads, void* user) {
+    bench_run_t* run = user;
+    if (run->count == run->capacity) {
+        run->capacity = run->capacity ? run->capacity * 2 : 32;
+        run->results = realloc(run->results, (size_t)run->capacity * sizeof(bench_result_t));
+    }
+    bench_result_t* r = &run->results[run->count++];
+    bench_case(kernel, backend, size, threads, run->opt, r);
+    bench_print_row(r);
+    fputc('\n', stderr);
+}
+
+int main(int argc, char** argv) {
+    bench_options_t opt = { .trials = 5, .warmup_ms = 100.0, .trial_ms = 200.0, .tolerance = 10.0 };
+    if (!bench_parse(argc, argv, &opt)) {
+        bench_usage(stderr);
+        return 2;
+    }
+    if (opt.thread_count == 0) {
+        bench_default_threads(&opt);
+    }
+    if (opt.list) {
+        bench_for_each_case(&opt, bench_list_case, NULL);
+        return 0;
+    }
+
+    bench_baseline_t* baseline = NULL;
+    int baseline_count = 0;
+    if (opt.compare) {
+        FILE* f = fopen(opt.compare, "r");
+        if (!f) {
+            fprintf(stderr, "sim_bench: cannot open baseline %s\n", opt.compare);
+            return 2;
+        }
+        baseline = bench_load_baseline(f, &baseline_count);
+        fclose(f);
+        if (baseline_count == 0) {
+            fprintf(stderr, "sim_bench: no results in baseline %s (not written by sim_bench?)\n", opt.compare);
+            return 2;
+        }
+    }
+    FILE* out = opt.out ? fopen(opt.out, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "sim_bench: cannot open %s\n", opt.out);
+        free(baseline);
+        return 2;
+    }
+
+    stm_setup();
+    int max_threads = 1;
+    for (int t = 0; t < opt.thread_count; t++) {
+        max_threads = opt.threads[t] > max_threads ? opt.threads[t] : max_threads;
+    }
+    sim_workers_init(max_threads);
+    bench_save_defaults();
+
+    bench_run_t run = { .opt = &opt };
+    bench_for_each_case(&opt, bench_run_case, &run);
+    bench_restore_defaults();
+    free(bench_defaults);
+    sim_workers_shutdown();
+
+    int slower = 0, missing = 0;
+    if (opt.compare) {
+        fprintf(stderr, "\ncompared with %s (tolerance %g%%):\n", opt.compare, opt.tolerance);
+        for (int i = 0; i < run.count; i++) {
+            bench_result_t* r = &run.results[i];
+            const bench_baseline_t* e = bench_find_baseline(baseline, baseline_count, r);
+            if (!e || e->median <= 0.0) {
+                missing++;
+                continue;
+            }
+            r->compared = true;
+            r->baseline = e->median;
+            double change = r->median / e->median - 1.0;
+            const char* verdict = change < -opt.tolerance * 0.01 ? "SLOWER" : change > opt.tolerance * 0.01 ? "faster" : NULL;
+            if (verdict) {
+                bench_print_row(r);
+                fprintf(stderr, "  %+6.1f%% %s\n", 100.0 * change, verdict);
+            }
+            slower += change < -opt.tolerance * 0.01;
+        }
+        fprintf(stderr, "%d of %d cases slower, %d not in the baseline\n", slower, run.count, missing);
+    }
+
+    bench_write_json(out, &opt, run.results, run.count);
+    if (out != stdout) {
+        fclose(out);
+    }
+    free(run.results);
+    free(baseline);
+    return slower ? 1 : 0;
+}
@@ -2,6 +2,7 @@
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
 #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #include "cimgui.h"
 #include "./util/sokol_imgui.h"
@@ -20,6 +21,7 @@ static state_t state;
 static simulation_id_t current_sim = SIM_NONE;
 
 static void init(void) {
+    stm_setup();
     sg_setup(&(sg_desc){
         .environment = sglue_environment(),
         .logger.func = slog_func,
@@ -49,7 +51,8 @@ static void init(void) {
 static void frame(void) {
     float dt = (float)sapp_frame_duration();
 
-    if (state.sim && state.sim->update) state.sim->update(dt);
+    // As many fixed-timestep updates as the scheduler allows this frame
+    simulations_run_frame(state.sim, dt);
 
     simgui_new_frame(&(simgui_frame_desc_t){
         .width = sapp_width(),
@@ -68,17 +71,19 @@ static void frame(void) {
             bool selected = (i == (int)current_sim);
 
             if (igSelectable_Bool(simulations_get((simulation_id_t)i)->name, selected,0,(ImVec2){0.f,0.f})) {
-                // Switch simulations
-                // Destroy old simulation
-                if (state.sim && state.sim->destroy) state.sim->destroy();
+                // Switch simulations: destroy the old one, init the new one
                 current_sim = (simulation_id_t)i;
-                state.sim = simulations_get(current_sim);
-                if (state.sim && state.sim->init) state.sim->init();
+                state.sim = simulations_switch(state.sim, current_sim);
             }
             if (selected) igSetItemDefaultFocus();
         }
         igEndCombo();
     }
+    simulations_draw_workers_ui();
+    simulations_draw_seed_ui();
+    simulations_draw_switch_ui();
+    simulations_draw_scheduler_ui();
+    simulations_draw_thread_ui(state.sim);
 
     // Draw parameters (if simulation uses param arrays, set them in its init)
     // If the simulation just uses its params_ui for sliders, call that:
@@ -105,6 +110,7 @@ static void frame(void) {
 }
 
 static void cleanup(void) {
+    simulations_stop_thread();
     if (state.sim && state.sim->destroy) state.sim->destroy();
 
     simulations_shutdown_registry();
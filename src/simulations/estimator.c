@@ -0,0 +1,162 @@
+#include "estimator.h"
+#include <string.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+void sim_estimator_init(sim_estimator_t *est, int channel_count) {
+    if (channel_count > SIM_ESTIMATOR_MAX_CHANNELS) channel_count = SIM_ESTIMATOR_MAX_CHANNELS;
+    est->channel_count = channel_count;
+    sim_estimator_clear(est);
+}
+
+void sim_estimator_clear(sim_estimator_t *est) {
+    int channels = est->channel_count;
+    memset(est, 0, sizeof(*est));
+    est->channel_count = channels;
+    est->block_size = 1;
+}
+
+// -----------------------------------------------------------------------------
+// Push
+// -----------------------------------------------------------------------------
+void sim_estimator_push(sim_estimator_t *est, const double *values) {
+    const int channels = est->channel_count;
+    double v[SIM_ESTIMATOR_MAX_CHANNELS];
+    for (int c = 0; c < channels; c++) {
+        v[c] = values[c];
+    }
+    est->count++;
+
+    // Blocking: record at this level, then either park the value or pair it
+    // with the parked one and carry the mean up a level
+    for (int k = 0; k < SIM_ESTIMATOR_LEVELS; k++) {
+        est->level_count[k]++;
+        for (int c = 0; c < channels; c++) {
+            est->level_sum[k][c] += v[c];
+            est->level_sum2[k][c] += v[c] * v[c];
+        }
+        uint32_t bit = 1u << k;
+        if (!(est->pending_mask & bit)) {
+            memcpy(est->pending[k], v, (size_t)channels * sizeof(double));
+            est->pending_mask |= bit;
+            break;
+        }
+        est->pending_mask &= ~bit;
+        for (int c = 0; c < channels; c++) {
+            v[c] = 0.5 * (est->pending[k][c] + v[c]);
+        }
+    }
+
+    // Jackknife blocks: halve the count by merging pairs once all are full
+    for (int c = 0; c < channels; c++) {
+        est->block_sum[est->block_count][c] += values[c];
+    }
+    if (++est->block_fill < est->block_size) {
+        return;
+    }
+    est->block_fill = 0;
+    if (++est->block_count < SIM_ESTIMATOR_BLOCKS) {
+        return;
+    }
+    for (int b = 0; b < SIM_ESTIMATOR_BLOCKS / 2; b++) {
+        for (int c = 0; c < channels; c++) {
+            est->block_sum[b][c] = est->block_sum[2 * b][c] + est->block_sum[2 * b + 1][c];
+        }
+    }
+    memset(est->block_sum[SIM_ESTIMATOR_BLOCKS / 2], 0,
+           sizeof(est->block_sum) / 2);
+    est->block_count = SIM_ESTIMATOR_BLOCKS / 2;
+    est->block_size *= 2;
+}
+
+// -----------------------------------------------------------------------------
+// Queries
+// -----------------------------------------------------------------------------
+double sim_estimator_mean(const sim_estimator_t *est, int channel) {
+    return est->count > 0 ? est->level_sum[0][channel] / (double)est->count : 0.0;
+}
+
+double sim_estimator_level_error(const sim_estimator_t *est, int channel, int level) {
+    double n = (double)est->level_count[level];
+    if (n < 2.0) {
+        return 0.0;
+    }
+    double sum = est->level_sum[level][channel];
+    double var = (est->level_sum2[level][channel] - sum * sum / n) / (n - 1.0);
+    return var > 0.0 ? sqrt(var / n) : 0.0;
+}
+
+int sim_estimator_plateau_level(const sim_estimator_t *est) {
+    int level = 0;
+    while (level + 1 < SIM_ESTIMATOR_LEVELS && est->level_count[level + 1] >= SIM_ESTIMATOR_MIN_BINS) {
+        level++;
+    }
+    return level;
+}
+
+double sim_estimator_error(const sim_estimator_t *est, int channel) {
+    return sim_estimator_level_error(est, channel, sim_estimator_plateau_level(est));
+}
+
+double sim_estimator_tau_int(const sim_estimator_t *est, int channel) {
+    double e0 = sim_estimator_level_error(est, channel, 0);
+    if (e0 <= 0.0) {
+        return 0.5;
+    }
+    double ratio = sim_estimator_error(est, channel) / e0;
+    double tau = 0.5 * ratio * ratio;
+    return tau > 0.5 ? tau : 0.5;
+}
+
+double sim_estimator_effective_samples(const sim_estimator_t *est, int channel) {
+    return (double)est->count / (2.0 * sim_estimator_tau_int(est, channel));
+}
+
+void sim_estimator_jackknife(const sim_estimator_t *est, sim_estimator_fn fn, void *ctx,
+                             double *value, double *error) {
+    const int channels = est->channel_count;
+    const int blocks = est->block_count;
+    double total[SIM_ESTIMATOR_MAX_CHANNELS] = {0};
+    double means[SIM_ESTIMATOR_MAX_CHANNELS];
+    *error = 0.0;
+    if (blocks == 0) {
+        for (int c = 0; c < channels; c++) {
+            means[c] = sim_estimator_mean(est, c);
+        }
+        *value = fn(means, ctx);
+        return;
+    }
+
+    for (int b = 0; b < blocks; b++) {
+        for (int c = 0; c < channels; c++) {
+            total[c] += est->block_sum[b][c];
+        }
+    }
+    const double size = (double)est->block_size;
+    for (int c = 0; c < channels; c++) {
+        means[c] = total[c] / (size * blocks);
+    }
+    *value = fn(means, ctx);
+    if (blocks < 2) {
+        return;
+    }
+
+    // Leave each block out in turn
+    double f[SIM_ESTIMATOR_BLOCKS];
+    double f_mean = 0.0;
+    for (int b = 0; b < blocks; b++) {
+        for (int c = 0; c < channels; c++) {
+            means[c] = (total[c] - est->block_sum[b][c]) / (size * (blocks - 1));
+        }
+        f[b] = fn(means, ctx);
+        f_mean += f[b];
+    }
+    f_mean /= blocks;
+    double var = 0.0;
+    for (int b = 0; b < blocks; b++) {
+        var += (f[b] - f_mean) * (f[b] - f_mean);
+    }
+    *error = sqrt(var * (blocks - 1) / blocks);
+}
@@ -0,0 +1,72 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Streaming estimators for correlated Monte Carlo samples
+//
+// Every sample is a vector of up to SIM_ESTIMATOR_MAX_CHANNELS observables.
+// Memory is constant however long the run.
+//
+// Blocking (Flyvbjerg-Petersen): level k sees the means of 2^k consecutive
+// samples, formed on the fly as pairs complete, and keeps their count, sum
+// and sum of squares. The naive error of the mean grows with k until the
+// blocks are longer than the correlation time and then levels off; the
+// plateau is the honest error, and its ratio to the level 0 error gives the
+// integrated autocorrelation time, tau = (err_k / err_0)^2 / 2, in samples.
+// The plateau is taken at the highest level that still has
+// SIM_ESTIMATOR_MIN_BINS blocks.
+//
+// Jackknife: samples are also summed into SIM_ESTIMATOR_BLOCKS blocks that
+// merge pairwise and double in length when they run out, the same way the
+// plot series buckets do. Quantities that are nonlinear in the channel means
+// (Binder cumulant, susceptibility) get their error bars from those blocks.
+// -----------------------------------------------------------------------------
+
+#define SIM_ESTIMATOR_MAX_CHANNELS 8
+#define SIM_ESTIMATOR_LEVELS 32        // Blocks up to 2^31 samples
+#define SIM_ESTIMATOR_BLOCKS 64        // Jackknife blocks
+#define SIM_ESTIMATOR_MIN_BINS 32      // Blocks a level needs to count as a plateau
+
+typedef struct sim_estimator_t {
+    int channel_count;
+    uint64_t count;                    // Samples pushed since the last clear
+    // Blocking levels
+    uint64_t level_count[SIM_ESTIMATOR_LEVELS];
+    double level_sum[SIM_ESTIMATOR_LEVELS][SIM_ESTIMATOR_MAX_CHANNELS];
+    double level_sum2[SIM_ESTIMATOR_LEVELS][SIM_ESTIMATOR_MAX_CHANNELS];
+    double pending[SIM_ESTIMATOR_LEVELS][SIM_ESTIMATOR_MAX_CHANNELS];
+    uint32_t pending_mask;             // Bit k: level k holds the first of a pair
+    // Jackknife blocks; block_count are complete, the next one is filling
+    double block_sum[SIM_ESTIMATOR_BLOCKS][SIM_ESTIMATOR_MAX_CHANNELS];
+    int block_count;
+    uint64_t block_size;               // Samples per block, doubles on merge
+    uint64_t block_fill;
+} sim_estimator_t;
+
+// Derived quantity from channel means, for the jackknife
+typedef double (*sim_estimator_fn)(const double *means, void *ctx);
+
+void sim_estimator_init(sim_estimator_t *est, int channel_count);
+void sim_estimator_clear(sim_estimator_t *est);
+// values holds one double per channel
+void sim_estimator_push(sim_estimator_t *est, const double *values);
+
+double sim_estimator_mean(const sim_estimator_t *est, int channel);
+// Naive error of the mean at one blocking level; 0 with fewer than two blocks
+double sim_estimator_level_error(const sim_estimator_t *est, int channel, int level);
+// Highest level with at least SIM_ESTIMATOR_MIN_BINS blocks (0 if none has)
+int sim_estimator_plateau_level(const sim_estimator_t *est);
+// Error of the mean, accounting for autocorrelation
+double sim_estimator_error(const sim_estimator_t *est, int channel);
+// Integrated autocorrelation time in samples (0.5 for independent samples)
+double sim_estimator_tau_int(const sim_estimator_t *est, int channel);
+// count / (2 tau)
+double sim_estimator_effective_samples(const sim_estimator_t *est, int channel);
+// fn of the means over the complete jackknife blocks, and its error; the
+// error is 0 until there are two blocks
+void sim_estimator_jackknife(const sim_estimator_t *est, sim_estimator_fn fn, void *ctx,
+                             double *value, double *error);
+
+#endif /* ESTIMATOR_H */
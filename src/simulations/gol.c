@@ -1,5 +1,12 @@
 #include "gol.h"
+#include "gol_bitgrid.h"
+#include "gol_hashlife.h"
+#include "gol_chunks.h"
+#include "gol_pattern.h"
 #include "simulations.h"
+#include "rng.h"
+#ifndef SIM_HEADLESS
+#include "lattice_view.h"
 #ifndef CIMGUI_DEFINE_ENUMS_AND_STRUCTS
     #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #endif
@@ -9,8 +16,10 @@
 #include "sokol_app.h"
 #include "./util/sokol_imgui.h"
 #include "sokol_glue.h"
+#endif
+#include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -25,138 +34,371 @@
 static int gol_grid_size = 64; // Default grid size
 static int gol_grid_size_new = 64; // Default grid size
 
-static int *gol_grid = NULL;         // Current grid state: 0 dead, 1 alive
-static int *gol_grid_buffer = NULL;  // Buffer for next generation
+// Engines: a bit-packed torus (see gol_bitgrid.h), or an unbounded HashLife
+// (see gol_hashlife.h) or chunked (see gol_chunks.h) universe seeded with the
+// same Grid Size soup
+typedef enum { GOL_ENGINE_BITGRID, GOL_ENGINE_HASHLIFE, GOL_ENGINE_CHUNKS, GOL_ENGINE_COUNT } gol_engine_t;
+static int gol_engine = GOL_ENGINE_BITGRID;
+
+static gol_bitgrid_t gol_grid;
+static gol_hashlife_t gol_hashlife;
+static gol_chunks_t gol_chunks;
+static int gol_step_log2 = 0;        // HashLife advances 2^k generations per update
+static uint64_t gol_generation = 0;
+static uint64_t gol_population = 0; // Live cells after the last update
+static bool gol_seed_random = true;  // Start from a soup (off while loading a pattern)
+
+// R8 state texture for rendering the grid, colored on the GPU (see
+// lattice_view.h). Large grids are reduced so the texture never exceeds
+// GOL_MAX_TEXTURE_SIZE; each texel then holds the live fraction of a
+// gol_texture_block x gol_texture_block square of cells. The texels are
+// published with each snapshot; render sizes the view to match and uploads
+// snapshots it has not seen.
+#define GOL_MAX_TEXTURE_SIZE 1024
+#define GOL_VIEW_LOG2 9              // Texture of the unbounded engines' view
+#define GOL_VIEW_SIZE (1 << GOL_VIEW_LOG2)
+#define GOL_VIEW_MAX_ZOOM (GOL_HL_MAX_LEVEL - GOL_VIEW_LOG2)
+#define GOL_IMAGE_SIZE 256.0f        // On-screen size of the grid image
+#ifndef SIM_HEADLESS
+static lattice_view_t gol_lattice;
+static uint64_t gol_lattice_sequence = 0; // Snapshot last uploaded
+#endif
+static int gol_texture_size = 0;
+static int gol_texture_block = 1;
 
-// Texture and sampler for rendering the grid
-static sg_image gol_image;
-static sg_sampler gol_sampler;
-static unsigned char *gol_pixels = NULL; // Pixel buffer for texture updates
+// Window into the unbounded plane: center cell and 2^zoom cells per texel.
+// With fit enabled it follows the pattern, dragging or scrolling the image
+// takes over.
+typedef struct gol_view_t {
+    double x, y;
+    int zoom;
+    bool fit;
+} gol_view_t;
+static gol_view_t gol_view = { 0.0, 0.0, 0, true };
 
-// Plot data for live ratio over time
-#define GOL_BUFFER_LEN 600
-static float gol_time_data[GOL_BUFFER_LEN];
-static float gol_live_data[GOL_BUFFER_LEN];
-static int gol_data_count = 0;
-static float gol_sim_time = 0.0f;
+// Plot data for live ratio over time (see gol_live_ratio)
+static sim_series_t gol_live_series;
+static double gol_sim_time = 0.0;
 
-// Simulation parameter: grid size slider (min: 16, max: 128)
-static sim_parameter_t gol_params[] = {
-    { "Grid Size", &gol_grid_size_new, SIM_PARAM_INT, 0, 0, 16, 128 }
+// Every setting by name (see simulations.h), also drawn by the parameters
+// UI; Engine is GOL_ENGINE_*
+enum { GOL_SETTING_GRID_SIZE, GOL_SETTING_ENGINE, GOL_SETTING_STEP_LOG2, GOL_SETTING_COUNT };
+static sim_parameter_t gol_settings[GOL_SETTING_COUNT] = {
+    [GOL_SETTING_GRID_SIZE] = { "Grid Size", &gol_grid_size_new, SIM_PARAM_INT, 0, 0, 16, 8192 },
+    [GOL_SETTING_ENGINE]    = { "Engine", &gol_engine, SIM_PARAM_INT, 0, 0, 0, GOL_ENGINE_COUNT - 1 },
+    [GOL_SETTING_STEP_LOG2] = { "Step 2^k Generations", &gol_step_log2, SIM_PARAM_INT, 0, 0, 0, GOL_HL_MAX_STEP_LOG2 }
 };
 
+// Live cells of the current engine, for states that did not come from a step
+static uint64_t gol_engine_population(void) {
+    switch (gol_engine) {
+        case GOL_ENGINE_HASHLIFE: return gol_hashlife_population(&gol_hashlife);
+        case GOL_ENGINE_CHUNKS:   return gol_chunks.population;
+        default:                  return gol_bitgrid_population(&gol_grid);
+    }
+}
+
+// Live fraction of the torus, or for the unbounded engines of the live
+// cells' bounding box, the only finite area they have
+static double gol_live_ratio(void) {
+    int64_t x0, y0, x1, y1;
+    switch (gol_engine) {
+        case GOL_ENGINE_HASHLIFE:
+            if (!gol_hashlife_live_bounds(&gol_hashlife, &x0, &y0, &x1, &y1)) return 0.0;
+            break;
+        case GOL_ENGINE_CHUNKS:
+            if (!gol_chunks_live_bounds(&gol_chunks, &x0, &y0, &x1, &y1)) return 0.0;
+            break;
+        default:
+            return (double)gol_population / ((double)gol_grid_size * gol_grid_size);
+    }
+    return (double)gol_population / ((double)(x1 - x0) * (double)(y1 - y0));
+}
 
-void sim_gol_init(void) {
-    // Allocate grid arrays
-    gol_grid = (int*)malloc(gol_grid_size * gol_grid_size * sizeof(int));
-    gol_grid_buffer = (int*)malloc(gol_grid_size * gol_grid_size * sizeof(int));
+// Simulation state only, so resets can run on the simulation thread
+static void gol_create(void) {
+    // Allocate the bit-packed grid
+    gol_bitgrid_create(&gol_grid, gol_grid_size);
 
     // Initialize grid with a random state (0 or 1)
-    srand((unsigned int)time(NULL));
-    for (int i = 0; i < gol_grid_size * gol_grid_size; i++) {
-        gol_grid[i] = rand() % 2;
+    if (gol_seed_random) {
+        gol_bitgrid_randomize(&gol_grid, sim_rng_seed());
     }
 
-    // Reset simulation time and plot data count
-    gol_sim_time = 0.0f;
-    gol_data_count = 0;
+    // The unbounded engines take over the soup and the flat grid is no longer needed
+    if (gol_engine == GOL_ENGINE_HASHLIFE) {
+        gol_hashlife_create(&gol_hashlife);
+        gol_hashlife_load_rows(&gol_hashlife, gol_bitgrid_row(&gol_grid, 0), gol_grid.stride, gol_grid.size);
+        gol_bitgrid_destroy(&gol_grid);
+    } else if (gol_engine == GOL_ENGINE_CHUNKS) {
+        gol_chunks_create(&gol_chunks);
+        gol_chunks_load_rows(&gol_chunks, gol_bitgrid_row(&gol_grid, 0), gol_grid.stride, gol_grid.size);
+        gol_bitgrid_destroy(&gol_grid);
+    }
 
-    // Create a dynamic texture that matches the grid dimensions.
-    // Each pixel represents one cell.
-    gol_image = sg_make_image(&(sg_image_desc){
-        .width = gol_grid_size,
-        .height = gol_grid_size,
-        .pixel_format = SG_PIXELFORMAT_RGBA8,
-        .usage = SG_USAGE_DYNAMIC,
-    });
+    // Reset simulation time and plot data count
+    gol_sim_time = 0.0;
+    sim_series_init(&gol_live_series, 1);
+    gol_generation = 0;
+    gol_population = gol_engine_population();
 
-    // Create a sampler with nearest filtering for a crisp grid look
-    gol_sampler = sg_make_sampler(&(sg_sampler_desc){
-        .min_filter = SG_FILTER_NEAREST,
-        .mag_filter = SG_FILTER_NEAREST,
-        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
-        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
-    });
+    // Pick the smallest power-of-two block that keeps the texture in bounds
+    gol_texture_block = 1;
+    while (gol_grid_size / gol_texture_block > GOL_MAX_TEXTURE_SIZE) {
+        gol_texture_block *= 2;
+    }
+    gol_texture_size = (gol_grid_size + gol_texture_block - 1) / gol_texture_block;
+    if (gol_engine != GOL_ENGINE_BITGRID) {
+        gol_texture_size = GOL_VIEW_SIZE;
+        gol_view.x = gol_view.y = 0.0;
+        gol_view.fit = true;
+    }
+}
 
-    // Allocate a pixel buffer (4 bytes per cell for RGBA)
-    gol_pixels = (unsigned char*)malloc(gol_grid_size * gol_grid_size * 4);
+static void gol_free(void) {
+    gol_bitgrid_destroy(&gol_grid);
+    gol_hashlife_destroy(&gol_hashlife);
+    gol_chunks_destroy(&gol_chunks);
 }
 
+void sim_gol_init(void) {
+    gol_grid_size = gol_grid_size_new;
+    gol_create();
+}
 
 void sim_gol_destroy(void) {
-    if (gol_grid) { free(gol_grid); gol_grid = NULL; }
-    if (gol_grid_buffer) { free(gol_grid_buffer); gol_grid_buffer = NULL; }
-    if (gol_pixels) { free(gol_pixels); gol_pixels = NULL; }
-    sg_destroy_image(gol_image);
-    sg_destroy_sampler(gol_sampler);
+    gol_free();
+#ifndef SIM_HEADLESS
+    lattice_view_destroy(&gol_lattice);
+    gol_lattice_sequence = 0;
+#endif
 }
 
 
 void sim_gol_update(float dt) {
-    int live_count = 0;
-    for (int y = 0; y < gol_grid_size; y++) {
-        for (int x = 0; x < gol_grid_size; x++) {
-            int idx = y * gol_grid_size + x;
-            int neighbors = 0;
-            // Check all 8 neighbors
-            for (int j = -1; j <= 1; j++) {
-                for (int i = -1; i <= 1; i++) {
-                    if (i == 0 && j == 0) continue;
-                    int nx = (x + i + gol_grid_size) % gol_grid_size;
-                    int ny = (y + j + gol_grid_size) % gol_grid_size;
-                    neighbors += gol_grid[ny * gol_grid_size + nx];
-                }
-            }
-            // Apply the Game of Life rules
-            if (gol_grid[idx] == 1) {
-                gol_grid_buffer[idx] = (neighbors == 2 || neighbors == 3) ? 1 : 0;
-            } else {
-                gol_grid_buffer[idx] = (neighbors == 3) ? 1 : 0;
-            }
-            if (gol_grid_buffer[idx] == 1) {
-                live_count++;
-            }
-        }
+    uint64_t live_count;
+    if (gol_engine == GOL_ENGINE_HASHLIFE) {
+        // Jump 2^k generations; the population is cached in the root node
+        gol_hashlife_set_step(&gol_hashlife, gol_step_log2);
+        gol_hashlife_step(&gol_hashlife);
+        gol_generation = gol_hashlife.generation;
+        live_count = gol_hashlife_population(&gol_hashlife);
+    } else if (gol_engine == GOL_ENGINE_CHUNKS) {
+        // Only chunks next to last generation's changes are recomputed
+        live_count = gol_chunks_step(&gol_chunks);
+        gol_generation = gol_chunks.generation;
+    } else {
+        // Advance one generation, 64 cells per word
+        live_count = gol_bitgrid_step(&gol_grid);
+        gol_generation++;
     }
-    // Swap the grids (the new generation becomes the current state)
-    int *temp = gol_grid;
-    gol_grid = gol_grid_buffer;
-    gol_grid_buffer = temp;
 
     // Update simulation time and record the live-cell ratio for plotting
     gol_sim_time += dt;
-    if (gol_data_count < GOL_BUFFER_LEN) {
-        gol_time_data[gol_data_count] = gol_sim_time;
-        gol_live_data[gol_data_count] = (float)live_count / (gol_grid_size * gol_grid_size);
-        gol_data_count++;
-    }
-
-    // Update the pixel buffer: each cell is rendered as a single pixel.
-    // Alive cells are white; dead cells are black.
-    for (int y = 0; y < gol_grid_size; y++) {
-        for (int x = 0; x < gol_grid_size; x++) {
-            int idx = y * gol_grid_size + x;
-            int pixel_idx = idx * 4;
-            if (gol_grid[idx] == 1) {
-                gol_pixels[pixel_idx + 0] = 255;
-                gol_pixels[pixel_idx + 1] = 255;
-                gol_pixels[pixel_idx + 2] = 255;
-                gol_pixels[pixel_idx + 3] = 255;
-            } else {
-                gol_pixels[pixel_idx + 0] = 0;
-                gol_pixels[pixel_idx + 1] = 0;
-                gol_pixels[pixel_idx + 2] = 0;
-                gol_pixels[pixel_idx + 3] = 255;
-            }
-        }
+    gol_population = live_count;
+    float live_ratio = (float)gol_live_ratio();
+    sim_series_push(&gol_live_series, gol_sim_time, &live_ratio);
+}
+
+sim_parameter_t *sim_gol_settings(int16_t *count) {
+    *count = GOL_SETTING_COUNT;
+    return gol_settings;
+}
+
+int sim_gol_observe(sim_observable_t *out) {
+    out[0] = (sim_observable_t){ "generation", (double)gol_generation };
+    out[1] = (sim_observable_t){ "population", (double)gol_population };
+    out[2] = (sim_observable_t){ "live_ratio", gol_live_ratio() };
+    return 3;
+}
+
+#ifndef SIM_HEADLESS
+// -----------------------------------------------------------------------------
+// UI state; the rest of the file is compiled out of headless builds
+// -----------------------------------------------------------------------------
+static const char *gol_engine_names[GOL_ENGINE_COUNT] = { "Bit-packed torus", "HashLife", "Unbounded chunks" };
+static int gol_engine_ui = GOL_ENGINE_BITGRID; // Combo value, posted with a reset
+static gol_view_t gol_view_ui = { 0.0, 0.0, 0, true }; // Edited by the UI and posted to gol_view
+
+// Pattern files (see gol_pattern.h): RLE or Macrocell in, RLE (Macrocell for
+// HashLife) out, placed at an offset from the origin. The UI edits path and
+// offset and posts them with the load or save.
+typedef struct gol_pattern_message_t {
+    char path[256];
+    int offset_x, offset_y;
+} gol_pattern_message_t;
+static gol_pattern_message_t gol_pattern_ui = { "pattern.rle", 0, 0 };
+static char gol_pattern_status[192] = "";
+
+// What plot_ui and render show besides texels and series
+typedef struct gol_stats_t {
+    int engine;
+    uint64_t generation;
+    int tile_count, tile_rows;
+    uint64_t population;
+    uint32_t live_nodes, gc_runs;
+    int chunk_count, change_count;
+    gol_view_t view;
+    char pattern_status[192];
+} gol_stats_t;
+_Static_assert(sizeof(gol_stats_t) <= SIM_SNAPSHOT_STATS, "GoL stats do not fit a snapshot");
+
+// Fit the view to the HashLife root node or to the allocated chunks, one
+// texel per cell while the pattern fits
+static void gol_view_fit_pattern(void) {
+    int64_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    if (gol_engine == GOL_ENGINE_HASHLIFE) {
+        int64_t half = (int64_t)1 << (gol_hashlife_root_level(&gol_hashlife) - 1);
+        x0 = y0 = -half;
+        x1 = y1 = half;
+    } else if (!gol_chunks_bounds(&gol_chunks, &x0, &y0, &x1, &y1)) {
+        return;
     }
-    // Update the dynamic texture with the new pixel data
-    sg_update_image(gol_image, &(sg_image_data){
-        .subimage[0][0] = {
-            .ptr = gol_pixels,
-            .size = (size_t)(gol_grid_size * gol_grid_size * 4)
-        }
-    });
+    int64_t extent = (x1 - x0 > y1 - y0) ? x1 - x0 : y1 - y0;
+    gol_view.zoom = 0;
+    while (((int64_t)GOL_VIEW_SIZE << gol_view.zoom) < extent && gol_view.zoom < GOL_VIEW_MAX_ZOOM) {
+        gol_view.zoom++;
+    }
+    gol_view.x = 0.5 * ((double)x0 + (double)x1);
+    gol_view.y = 0.5 * ((double)y0 + (double)y1);
+}
+
+static void gol_render_view(unsigned char *texels) {
+    if (gol_view.fit) gol_view_fit_pattern();
+    double half = 0.5 * ldexp((double)GOL_VIEW_SIZE, gol_view.zoom);
+    int64_t x0 = (int64_t)floor(gol_view.x - half);
+    int64_t y0 = (int64_t)floor(gol_view.y - half);
+    if (gol_engine == GOL_ENGINE_HASHLIFE) {
+        gol_hashlife_render_r8(&gol_hashlife, texels, gol_texture_size, x0, y0, gol_view.zoom);
+    } else {
+        gol_chunks_render_r8(&gol_chunks, texels, gol_texture_size, x0, y0, gol_view.zoom);
+    }
+}
+
+// Drag the image to pan, scroll over it to zoom around the center; returns
+// true when the view moved
+static bool gol_view_input(void) {
+    if (!igIsItemHovered(0)) return false;
+    ImGuiIO *io = igGetIO();
+    double cells_per_pixel = ldexp((double)GOL_VIEW_SIZE, gol_view_ui.zoom) / GOL_IMAGE_SIZE;
+    bool moved = false;
+    if (igIsMouseDragging(0, -1.0f)) {
+        gol_view_ui.x -= io->MouseDelta.x * cells_per_pixel;
+        gol_view_ui.y -= io->MouseDelta.y * cells_per_pixel;
+        moved = true;
+    }
+    if (io->MouseWheel > 0.0f && gol_view_ui.zoom > 0) {
+        gol_view_ui.zoom--;
+        moved = true;
+    } else if (io->MouseWheel < 0.0f && gol_view_ui.zoom < GOL_VIEW_MAX_ZOOM) {
+        gol_view_ui.zoom++;
+        moved = true;
+    }
+    if (moved) gol_view_ui.fit = false;
+    return moved;
+}
+
+// -----------------------------------------------------------------------------
+// Pattern files
+// -----------------------------------------------------------------------------
+static gol_pattern_target_t gol_pattern_target(void) {
+    switch (gol_engine) {
+        case GOL_ENGINE_HASHLIFE: return (gol_pattern_target_t){ .hashlife = &gol_hashlife };
+        case GOL_ENGINE_CHUNKS:   return (gol_pattern_target_t){ .chunks = &gol_chunks };
+        default:                  return (gol_pattern_target_t){ .bitgrid = &gol_grid };
+    }
+}
+
+// Restart the current engine empty and decode the pattern file into it
+static void gol_load_pattern_message(const void *payload) {
+    const gol_pattern_message_t *msg = (const gol_pattern_message_t*)payload;
+    gol_grid_size = gol_grid_size_new;
+    gol_free();
+    gol_seed_random = false;
+    gol_create();
+    gol_seed_random = true;
+
+    gol_pattern_stats_t stats;
+    if (!gol_pattern_load(msg->path, gol_pattern_target(), msg->offset_x, msg->offset_y, &stats)) {
+        snprintf(gol_pattern_status, sizeof(gol_pattern_status), "%s", stats.error);
+        return;
+    }
+    gol_generation = stats.generation;
+    gol_hashlife.generation = stats.generation;
+    gol_chunks.generation = stats.generation;
+    gol_population = gol_engine_population();
+    snprintf(gol_pattern_status, sizeof(gol_pattern_status),
+             "Loaded %s: %.1f MB in %.3f s (%.0f MB/s), %llu cells",
+             stats.format == GOL_PATTERN_MACROCELL ? "Macrocell" : "RLE",
+             (double)stats.bytes / 1e6, stats.seconds, stats.mb_per_s,
+             (unsigned long long)stats.cells);
+}
+
+static void gol_save_pattern_message(const void *payload) {
+    const gol_pattern_message_t *msg = (const gol_pattern_message_t*)payload;
+    gol_pattern_stats_t stats;
+    if (!gol_pattern_save(msg->path, gol_pattern_target(), gol_generation, &stats)) {
+        snprintf(gol_pattern_status, sizeof(gol_pattern_status), "%s", stats.error);
+        return;
+    }
+    snprintf(gol_pattern_status, sizeof(gol_pattern_status),
+             "Saved %s: %.1f MB in %.3f s (%.0f MB/s)",
+             stats.format == GOL_PATTERN_MACROCELL ? "Macrocell" : "RLE",
+             (double)stats.bytes / 1e6, stats.seconds, stats.mb_per_s);
+}
+
+// -----------------------------------------------------------------------------
+// Messages from the UI, run on the thread stepping the simulation
+// -----------------------------------------------------------------------------
+// Restart with the engine in the payload and the Grid Size slider's size
+static void gol_reset_message(const void *payload) {
+    gol_engine = *(const int*)payload;
+    gol_grid_size = gol_grid_size_new;
+    gol_free();
+    gol_create();
+}
+
+static void gol_view_message(const void *payload) {
+    gol_view = *(const gol_view_t*)payload;
+}
+
+// Resets refit the unbounded engines' view, the UI copy follows
+static void gol_post_reset(void) {
+    gol_view_ui.fit = true;
+    simulations_post(gol_reset_message, &gol_engine_ui, sizeof(gol_engine_ui));
+}
+
+// -----------------------------------------------------------------------------
+// Publish: texels, live ratio series and stats for the UI (see simulations.h)
+// -----------------------------------------------------------------------------
+void sim_gol_publish(sim_snapshot_t *snap) {
+    // State texels: 255 for a live cell, reduced blocks by their live
+    // fraction; once per snapshot however many generations were stepped
+    unsigned char *texels = sim_snapshot_pixels(snap, gol_texture_size, gol_texture_size);
+    if (gol_engine != GOL_ENGINE_BITGRID) {
+        gol_render_view(texels);
+    } else {
+        gol_bitgrid_render_r8(&gol_grid, texels, gol_texture_size, gol_texture_block);
+    }
+    snap->series = gol_live_series;
+
+    gol_stats_t *stats = (gol_stats_t*)snap->stats;
+    stats->engine = gol_engine;
+    stats->generation = gol_generation;
+    stats->tile_count = gol_grid.tile_count;
+    stats->tile_rows = gol_grid.tile_rows;
+    stats->population = 0;
+    if (gol_engine == GOL_ENGINE_HASHLIFE) {
+        stats->population = gol_hashlife_population(&gol_hashlife);
+    } else if (gol_engine == GOL_ENGINE_CHUNKS) {
+        stats->population = gol_chunks.population;
+    }
+    stats->live_nodes = gol_hashlife.live_nodes;
+    stats->gc_runs = gol_hashlife.gc_runs;
+    stats->chunk_count = gol_chunks.chunk_count;
+    stats->change_count = gol_chunks.change_count;
+    stats->view = gol_view;
+    memcpy(stats->pattern_status, gol_pattern_status, sizeof(stats->pattern_status));
 }
 
 // -----------------------------------------------------------------------------
@@ -164,27 +406,56 @@ void sim_gol_update(float dt) {
 // -----------------------------------------------------------------------------
 void sim_gol_params_ui(void) {
     if (igButton("Reset Simulation", (ImVec2){0,0})) {
-        if (gol_grid_size != gol_grid_size_new) {
-            gol_grid_size = gol_grid_size_new;
-        } 
         // On reset, destroy the current simulation and reinitialize it
-        sim_gol_destroy();
-        sim_gol_init();
+        gol_post_reset();
+    }
+    // Switching engines restarts from a fresh soup
+    if (igCombo_Str_arr("Engine", &gol_engine_ui, gol_engine_names, GOL_ENGINE_COUNT, -1)) {
+        gol_post_reset();
+    }
+    simulations_draw_params(&gol_settings[GOL_SETTING_GRID_SIZE], 1);
+    if (gol_engine_ui == GOL_ENGINE_HASHLIFE) {
+        simulations_draw_params(&gol_settings[GOL_SETTING_STEP_LOG2], 1);
+    }
+    if (gol_engine_ui != GOL_ENGINE_BITGRID) {
+        bool view_changed = igCheckbox("Fit View", &gol_view_ui.fit);
+        view_changed |= igSliderInt("View Zoom 2^k", &gol_view_ui.zoom, 0, GOL_VIEW_MAX_ZOOM, "%d", ImGuiSliderFlags_None);
+        if (view_changed) {
+            simulations_post(gol_view_message, &gol_view_ui, sizeof(gol_view_ui));
+        }
+    }
+
+    // Load replaces the universe (the torus keeps the Grid Size), save writes
+    // the current state
+    igInputText("Pattern File", gol_pattern_ui.path, sizeof(gol_pattern_ui.path), ImGuiInputTextFlags_None, NULL, NULL);
+    igInputInt("Offset X", &gol_pattern_ui.offset_x, 1, 64, ImGuiInputTextFlags_None);
+    igInputInt("Offset Y", &gol_pattern_ui.offset_y, 1, 64, ImGuiInputTextFlags_None);
+    if (igButton("Load Pattern", (ImVec2){0,0})) {
+        gol_view_ui.fit = true;
+        simulations_post(gol_load_pattern_message, &gol_pattern_ui, sizeof(gol_pattern_ui));
+    }
+    igSameLine(0.0f, -1.0f);
+    if (igButton("Save Pattern", (ImVec2){0,0})) {
+        simulations_post(gol_save_pattern_message, &gol_pattern_ui, sizeof(gol_pattern_ui));
+    }
+    const sim_snapshot_t *snap = simulations_snapshot();
+    const gol_stats_t *stats = snap ? (const gol_stats_t*)snap->stats : NULL;
+    if (stats && stats->pattern_status[0]) {
+        igTextWrapped("%s", stats->pattern_status);
     }
-    simulations_draw_params(gol_params, 1);
 }
 
 // -----------------------------------------------------------------------------
 // Plot UI: display a time-series plot of the live-cell ratio over time
 // -----------------------------------------------------------------------------
 void sim_gol_plot_ui(void) {
-    if (gol_data_count < 2)
+    const sim_snapshot_t *snap = simulations_snapshot();
+    double min_time, max_time;
+    if (!snap || !sim_series_x_range(&snap->series, &min_time, &max_time))
         return;
-    float max_time = gol_time_data[gol_data_count - 1];
-    float min_time = 0.0f;
     ImPlot_SetNextAxesLimits(min_time, max_time, 0.0f, 1.0f, ImPlotCond_Always);
     if (ImPlot_BeginPlot("Live Ratio Over Time", (ImVec2){0,0}, ImPlotFlags_None)) {
-        ImPlot_PlotLine_FloatPtrFloatPtr("Live Ratio", gol_time_data, gol_live_data, gol_data_count, 0, 0, sizeof(float));
+        sim_series_plot_line(&snap->series, 0, "Live Ratio");
         ImPlot_EndPlot();
     }
 }
@@ -193,12 +464,56 @@ void sim_gol_plot_ui(void) {
 // Render UI: display the offscreen texture using an OpenGL sampler and show stats
 // -----------------------------------------------------------------------------
 void sim_gol_render(void) {
+    const sim_snapshot_t *snap = simulations_snapshot();
+    if (!snap) return;
+    const gol_stats_t *stats = (const gol_stats_t*)snap->stats;
     ImVec4 white = {1.0f, 1.0f, 1.0f, 1.0f};
-    ImVec2 size = {256,256};
+    ImVec2 size = {GOL_IMAGE_SIZE, GOL_IMAGE_SIZE};
     ImVec2 uv0 = {0,0};
     ImVec2 uv1 = {1,1};
-    ImTextureID tex_id = simgui_imtextureid_with_sampler(gol_image, gol_sampler);
+    // State texture matching the (reduced) grid: each texel is one cell, or
+    // one block of cells on large grids. Dead is black, alive is white.
+    if (gol_lattice.width != snap->width || gol_lattice.height != snap->height) {
+        lattice_view_destroy(&gol_lattice);
+        lattice_view_create(&gol_lattice, snap->width, snap->height,
+                            (float[4]){0.0f, 0.0f, 0.0f, 1.0f}, (float[4]){1.0f, 1.0f, 1.0f, 1.0f});
+        gol_lattice_sequence = 0;
+    }
+    if (snap->sequence != gol_lattice_sequence) {
+        lattice_view_update(&gol_lattice, snap->pixels);
+        gol_lattice_sequence = snap->sequence;
+    }
+    ImTextureID tex_id = simgui_imtextureid_with_sampler(gol_lattice.color_img, gol_lattice.color_smp);
     igImage(tex_id, size, uv0, uv1, white, (ImVec4){0,0,0,0});
-    float current_ratio = (gol_data_count > 0) ? gol_live_data[gol_data_count - 1] : 0.0f;
-    igText("Live Ratio: %.2f", current_ratio);
-}
\ No newline at end of file
+    if (stats->engine != GOL_ENGINE_BITGRID) {
+        // While fitting, panning and zooming start from where the fit put the view
+        if (gol_view_ui.fit) {
+            gol_view_ui.x = stats->view.x;
+            gol_view_ui.y = stats->view.y;
+            gol_view_ui.zoom = stats->view.zoom;
+        }
+        if (gol_view_input()) {
+            simulations_post(gol_view_message, &gol_view_ui, sizeof(gol_view_ui));
+        }
+    }
+    float current_ratio = sim_series_last(&snap->series, 0);
+    igText(stats->engine == GOL_ENGINE_BITGRID ? "Live Ratio: %.2f" : "Live Ratio (bounding box): %.2f", current_ratio);
+    igText("Generation: %llu", (unsigned long long)stats->generation);
+    if (stats->engine == GOL_ENGINE_BITGRID) {
+        igText("Tiles: %d x %d rows", stats->tile_count, stats->tile_rows);
+    }
+    if (stats->engine == GOL_ENGINE_HASHLIFE) {
+        igText("Population: %llu", (unsigned long long)stats->population);
+        igText("Nodes: %u (GC runs: %u)", stats->live_nodes, stats->gc_runs);
+    }
+    if (stats->engine == GOL_ENGINE_CHUNKS) {
+        igText("Population: %llu", (unsigned long long)stats->population);
+        igText("Chunks: %d (%d changed)", stats->chunk_count, stats->change_count);
+    }
+    if (stats->engine != GOL_ENGINE_BITGRID) {
+        igText("View: (%.0f, %.0f), %llu cells/texel", stats->view.x, stats->view.y,
+               (unsigned long long)1 << stats->view.zoom);
+    }
+}
+
+#endif /* SIM_HEADLESS */
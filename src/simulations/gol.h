@@ -1,6 +1,12 @@
 #ifndef GOL_H
 #define GOL_H
 
+#include <stdint.h>
+
+struct sim_snapshot_t;
+struct sim_parameter_t;
+struct sim_observable_t;
+
 
 
 void sim_gol_init(void);
@@ -9,6 +15,9 @@ void sim_gol_update(float dt);
 void sim_gol_params_ui(void);
 void sim_gol_plot_ui(void);
 void sim_gol_render(void);
+struct sim_parameter_t *sim_gol_settings(int16_t *count);
+int sim_gol_observe(struct sim_observable_t *out);
+void sim_gol_publish(struct sim_snapshot_t *snap);
 
 
 
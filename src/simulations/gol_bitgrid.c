@@ -0,0 +1,175 @@
+#include "gol_bitgrid.h"
+#include "workers.h"
+#include "rng.h"
+#include <stdlib.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+void gol_bitgrid_create(gol_bitgrid_t *grid, int size) {
+    grid->size = size;
+    grid->words = (size + GOL_BITGRID_WORD_BITS - 1) / GOL_BITGRID_WORD_BITS;
+    grid->stride = grid->words + 2;
+    int last_bits = size - (grid->words - 1) * GOL_BITGRID_WORD_BITS;
+    grid->tail_mask = (last_bits == 64) ? ~0ULL : ((1ULL << last_bits) - 1);
+    size_t count = (size_t)(size + 2) * (size_t)grid->stride;
+    grid->cells = (uint64_t*)calloc(count, sizeof(uint64_t));
+    grid->next = (uint64_t*)calloc(count, sizeof(uint64_t));
+
+    // Bands of rows whose three-row working set of both buffers fits a tile
+    int row_bytes = grid->stride * (int)sizeof(uint64_t);
+    grid->tile_rows = GOL_BITGRID_TILE_BYTES / row_bytes;
+    if (grid->tile_rows < 4) grid->tile_rows = 4;
+    grid->tile_count = (size + grid->tile_rows - 1) / grid->tile_rows;
+    grid->tile_live = (uint64_t*)calloc((size_t)grid->tile_count, sizeof(uint64_t));
+}
+
+void gol_bitgrid_destroy(gol_bitgrid_t *grid) {
+    if (grid->cells) { free(grid->cells); grid->cells = NULL; }
+    if (grid->next) { free(grid->next); grid->next = NULL; }
+    if (grid->tile_live) { free(grid->tile_live); grid->tile_live = NULL; }
+    grid->size = 0;
+    grid->words = 0;
+    grid->tile_count = 0;
+}
+
+void gol_bitgrid_randomize(gol_bitgrid_t *grid, uint64_t seed) {
+    for (int y = 0; y < grid->size; y++) {
+        uint64_t *row = gol_bitgrid_row(grid, y);
+        sim_rng_t rng;
+        sim_rng_init(&rng, seed, SIM_RNG_STREAM_GOL + (uint64_t)y);
+        for (int w = 0; w < grid->words; w++) {
+            row[w] = sim_rng_u64(&rng);
+        }
+        row[grid->words - 1] &= grid->tail_mask;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Halo exchange: copy the wrapped-around cells next to the edges they touch.
+// The west halo word holds cell size-1 in its top bit. The east neighbor of
+// the last cell is cell 0, stored in the first bit past the edge: in the last
+// word when the row does not fill it, otherwise in the east halo word.
+// -----------------------------------------------------------------------------
+static void gol_bitgrid_exchange_halos(gol_bitgrid_t *grid) {
+    const int words = grid->words;
+    const int last_bits = grid->size - (words - 1) * GOL_BITGRID_WORD_BITS;
+    for (int y = 0; y < grid->size; y++) {
+        uint64_t *row = gol_bitgrid_row(grid, y);
+        uint64_t first = row[0] & 1;
+        uint64_t last = (row[words - 1] >> (last_bits - 1)) & 1;
+        row[-1] = last << 63;
+        if (last_bits < 64) {
+            row[words - 1] |= first << last_bits;
+            row[words] = 0;
+        } else {
+            row[words] = first;
+        }
+    }
+    const size_t row_bytes = (size_t)grid->stride * sizeof(uint64_t);
+    memcpy(gol_bitgrid_row(grid, -1) - 1, gol_bitgrid_row(grid, grid->size - 1) - 1, row_bytes);
+    memcpy(gol_bitgrid_row(grid, grid->size) - 1, gol_bitgrid_row(grid, 0) - 1, row_bytes);
+}
+
+// -----------------------------------------------------------------------------
+// Update: one generation over whole words, one band of rows per task. With
+// the halos in place every word, edge or not, is the same straight-line bit
+// logic.
+// -----------------------------------------------------------------------------
+static void gol_bitgrid_step_tile(void *ctx, int task, int worker) {
+    (void)worker;
+    gol_bitgrid_t *grid = (gol_bitgrid_t*)ctx;
+    const int words = grid->words;
+    const int stride = grid->stride;
+    const int y_end = (task + 1) * grid->tile_rows < grid->size ? (task + 1) * grid->tile_rows : grid->size;
+    uint64_t live = 0;
+
+    for (int y = task * grid->tile_rows; y < y_end; y++) {
+        const uint64_t *rb = gol_bitgrid_row(grid, y);
+        const uint64_t *ra = rb - stride;
+        const uint64_t *rc = rb + stride;
+        uint64_t *out = grid->next + (rb - grid->cells);
+
+        for (int w = 0; w < words; w++) {
+            out[w] = gol_bitgrid_rule((ra[w] << 1) | (ra[w - 1] >> 63), ra[w], (ra[w] >> 1) | (ra[w + 1] << 63),
+                                      (rb[w] << 1) | (rb[w - 1] >> 63), rb[w], (rb[w] >> 1) | (rb[w + 1] << 63),
+                                      (rc[w] << 1) | (rc[w - 1] >> 63), rc[w], (rc[w] >> 1) | (rc[w + 1] << 63));
+        }
+        out[words - 1] &= grid->tail_mask;
+
+        for (int w = 0; w < words; w++) {
+            live += (uint64_t)gol_popcount64(out[w]);
+        }
+    }
+    grid->tile_live[task] = live;
+}
+
+uint64_t gol_bitgrid_step(gol_bitgrid_t *grid) {
+    gol_bitgrid_exchange_halos(grid);
+    sim_workers_run(gol_bitgrid_step_tile, grid, grid->tile_count);
+
+    // Reduce in tile order so the count never depends on the thread count
+    uint64_t live = 0;
+    for (int t = 0; t < grid->tile_count; t++) {
+        live += grid->tile_live[t];
+    }
+
+    // Swap the grids (the new generation becomes the current state)
+    uint64_t *temp = grid->cells;
+    grid->cells = grid->next;
+    grid->next = temp;
+    return live;
+}
+
+uint64_t gol_bitgrid_population(const gol_bitgrid_t *grid) {
+    uint64_t live = 0;
+    for (int y = 0; y < grid->size; y++) {
+        const uint64_t *row = gol_bitgrid_row(grid, y);
+        for (int w = 0; w < grid->words; w++) {
+            live += (uint64_t)gol_popcount64(row[w]);
+        }
+    }
+    return live;
+}
+
+// -----------------------------------------------------------------------------
+// Rendering: reduce block x block squares of cells into one grey pixel
+// -----------------------------------------------------------------------------
+
+// Popcount every block-bit wide field of a word in place (the first steps of a
+// SWAR popcount, stopped once the partial sums are block bits wide)
+static inline uint64_t gol_field_counts(uint64_t v, int block) {
+    if (block >= 2)  v = v - ((v >> 1) & 0x5555555555555555ULL);
+    if (block >= 4)  v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    if (block >= 8)  v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    if (block >= 16) v = (v + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+    if (block >= 32) v = (v + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+    if (block >= 64) v = (v + (v >> 32)) & 0x00000000FFFFFFFFULL;
+    return v;
+}
+
+void gol_bitgrid_render_r8(const gol_bitgrid_t *grid, unsigned char *texels, int tex_size, int block) {
+    const uint64_t field_mask = (block >= 64) ? ~0ULL : ((1ULL << block) - 1);
+    const int fields = GOL_BITGRID_WORD_BITS / block;
+    const int full = block * block;
+    int *counts = (int*)malloc((size_t)tex_size * sizeof(int));
+
+    for (int py = 0; py < tex_size; py++) {
+        memset(counts, 0, (size_t)tex_size * sizeof(int));
+        for (int y = py * block; y < (py + 1) * block && y < grid->size; y++) {
+            const uint64_t *row = gol_bitgrid_row(grid, y);
+            for (int w = 0; w < grid->words; w++) {
+                uint64_t v = gol_field_counts(row[w], block);
+                for (int f = 0; f < fields && w * fields + f < tex_size; f++) {
+                    counts[w * fields + f] += (int)((v >> (f * block)) & field_mask);
+                }
+            }
+        }
+        unsigned char *dst = texels + (size_t)py * tex_size;
+        for (int px = 0; px < tex_size; px++) {
+            dst[px] = (unsigned char)((counts[px] * 255) / full);
+        }
+    }
+    free(counts);
+}
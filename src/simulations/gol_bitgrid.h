@@ -0,0 +1,93 @@
+#ifndef GOL_BITGRID_H
+#define GOL_BITGRID_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Bit-packed Game of Life torus
+//
+// Each row is stored as `words` uint64_t values, 64 cells per word, with cell
+// x of a row living in bit (x % 64) of word (x / 64). Rows are padded with a
+// halo word on either side and the grid with a halo row above and below; the
+// halos are refreshed with the wrapped-around cells before every step so the
+// update kernel never has to special-case the torus edges. Outside a step,
+// halos are stale and bits past the grid edge in the last word are zero.
+//
+// The update runs on the shared worker pool in bands of tile_rows rows sized
+// to stay in cache.
+// -----------------------------------------------------------------------------
+
+#define GOL_BITGRID_WORD_BITS 64
+#define GOL_BITGRID_TILE_BYTES (64 * 1024)
+
+typedef struct gol_bitgrid_t {
+    int size;            // Cells per side of the (square) torus
+    int words;           // uint64_t words of cells per row
+    int stride;          // words plus the two halo words
+    uint64_t tail_mask;  // Valid bits in the last word of each row
+    uint64_t *cells;     // Current generation: (size + 2) * stride words
+    uint64_t *next;      // Next generation scratch buffer
+    int tile_rows;       // Rows per parallel task
+    int tile_count;
+    uint64_t *tile_live; // Live count per task, reduced in task order
+} gol_bitgrid_t;
+
+// First word of cells in row y (-1 and size address the halo rows)
+static inline uint64_t *gol_bitgrid_row(const gol_bitgrid_t *grid, int y) {
+    return grid->cells + (size_t)(y + 1) * grid->stride + 1;
+}
+
+static inline int gol_popcount64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Next state of 64 cells at once. The eight neighbor words are summed with
+// full/half adders into a ones digit (s0) and the count of twos (k); a cell
+// lives iff the total is 3, or 2 and the cell was already alive, i.e. iff
+// k == 1 and (s0 | alive).
+static inline uint64_t gol_bitgrid_rule(uint64_t aw, uint64_t a, uint64_t ae,
+                                        uint64_t bw, uint64_t b, uint64_t be,
+                                        uint64_t cw, uint64_t c, uint64_t ce) {
+    // Column sums: row above and below are 0..3, middle row (without the cell) 0..2
+    uint64_t t0 = aw ^ a ^ ae, t1 = (aw & a) | (ae & (aw ^ a));
+    uint64_t m0 = bw ^ be,     m1 = bw & be;
+    uint64_t u0 = cw ^ c ^ ce, u1 = (cw & c) | (ce & (cw ^ c));
+
+    // Ones digit of the neighbor count and its carry into the twos
+    uint64_t s0 = t0 ^ m0 ^ u0;
+    uint64_t c1 = (t0 & m0) | (u0 & (t0 ^ m0));
+
+    // Exactly one of the four twos must be set
+    uint64_t p = t1 ^ m1 ^ u1;
+    uint64_t q = (t1 & m1) | (u1 & (t1 ^ m1));
+    uint64_t k1 = (p ^ c1) & ~q;
+
+    return k1 & (s0 | b);
+}
+
+void gol_bitgrid_create(gol_bitgrid_t *grid, int size);
+void gol_bitgrid_destroy(gol_bitgrid_t *grid);
+
+// Fill the grid with uniformly random cells, each row from its own stream
+// of seed (see rng.h)
+void gol_bitgrid_randomize(gol_bitgrid_t *grid, uint64_t seed);
+
+// Advance one generation and return the number of live cells in it
+uint64_t gol_bitgrid_step(gol_bitgrid_t *grid);
+
+uint64_t gol_bitgrid_population(const gol_bitgrid_t *grid);
+
+// Reduce the grid into a tex_size x tex_size R8 image where every texel
+// covers a block x block square of cells (block is a power of two <= 64) and
+// holds the live fraction of that square scaled to 0..255.
+void gol_bitgrid_render_r8(const gol_bitgrid_t *grid, unsigned char *texels, int tex_size, int block);
+
+#endif /* GOL_BITGRID_H */
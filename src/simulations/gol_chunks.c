@@ -0,0 +1,410 @@
+#include "gol_chunks.h"
+#include "gol_bitgrid.h"
+#include "workers.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GOL_CHUNKS_INITIAL_BUCKETS 1024
+#define GOL_CHUNKS_PER_TASK 16
+
+// Neighbor directions; a chunk's border bit d faces the neighbor in direction d
+enum { GOL_DIR_N, GOL_DIR_S, GOL_DIR_W, GOL_DIR_E, GOL_DIR_NW, GOL_DIR_NE, GOL_DIR_SW, GOL_DIR_SE, GOL_DIR_COUNT };
+static const int gol_dir_dx[GOL_DIR_COUNT] = { 0, 0, -1, 1, -1, 1, -1, 1 };
+static const int gol_dir_dy[GOL_DIR_COUNT] = { -1, 1, 0, 0, -1, -1, 1, 1 };
+
+// -----------------------------------------------------------------------------
+// Chunk map
+// -----------------------------------------------------------------------------
+static inline uint32_t gol_chunk_hash(int32_t cx, int32_t cy) {
+    uint64_t h = ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy;
+    h *= 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32);
+}
+
+static gol_chunk_t *gol_chunks_find(const gol_chunks_t *u, int32_t cx, int32_t cy) {
+    for (gol_chunk_t *c = u->buckets[gol_chunk_hash(cx, cy) & u->bucket_mask]; c; c = c->hash_next) {
+        if (c->cx == cx && c->cy == cy) return c;
+    }
+    return NULL;
+}
+
+static void gol_chunks_rehash(gol_chunks_t *u, uint32_t bucket_count) {
+    free(u->buckets);
+    u->buckets = (gol_chunk_t**)calloc(bucket_count, sizeof(gol_chunk_t*));
+    u->bucket_mask = bucket_count - 1;
+    for (int i = 0; i < u->chunk_count; i++) {
+        gol_chunk_t *c = u->chunks[i];
+        uint32_t h = gol_chunk_hash(c->cx, c->cy) & u->bucket_mask;
+        c->hash_next = u->buckets[h];
+        u->buckets[h] = c;
+    }
+}
+
+static gol_chunk_t *gol_chunks_get(gol_chunks_t *u, int32_t cx, int32_t cy) {
+    gol_chunk_t *c = gol_chunks_find(u, cx, cy);
+    if (c) return c;
+
+    if (u->free_chunks) {
+        c = u->free_chunks;
+        u->free_chunks = c->hash_next;
+    } else {
+        c = (gol_chunk_t*)malloc(sizeof(gol_chunk_t));
+    }
+    memset(c, 0, sizeof(*c));
+    c->cx = cx;
+    c->cy = cy;
+
+    if (u->chunk_count == u->chunk_capacity) {
+        u->chunk_capacity = u->chunk_capacity ? u->chunk_capacity * 2 : 256;
+        u->chunks = (gol_chunk_t**)realloc(u->chunks, (size_t)u->chunk_capacity * sizeof(gol_chunk_t*));
+    }
+    c->index = u->chunk_count;
+    u->chunks[u->chunk_count++] = c;
+
+    uint32_t h = gol_chunk_hash(cx, cy) & u->bucket_mask;
+    c->hash_next = u->buckets[h];
+    u->buckets[h] = c;
+    if ((uint32_t)u->chunk_count > u->bucket_mask + 1) {
+        gol_chunks_rehash(u, (u->bucket_mask + 1) * 2);
+    }
+    return c;
+}
+
+static void gol_chunks_release(gol_chunks_t *u, gol_chunk_t *c) {
+    gol_chunk_t **link = &u->buckets[gol_chunk_hash(c->cx, c->cy) & u->bucket_mask];
+    while (*link != c) link = &(*link)->hash_next;
+    *link = c->hash_next;
+
+    gol_chunk_t *last = u->chunks[--u->chunk_count];
+    u->chunks[c->index] = last;
+    last->index = c->index;
+
+    c->hash_next = u->free_chunks;
+    u->free_chunks = c;
+}
+
+void gol_chunks_clear(gol_chunks_t *u) {
+    while (u->chunk_count > 0) {
+        gol_chunks_release(u, u->chunks[u->chunk_count - 1]);
+    }
+    u->active_count = 0;
+    u->change_count = 0;
+    u->generation = 0;
+    u->population = 0;
+}
+
+static void gol_chunks_push_change(gol_chunks_t *u, int32_t cx, int32_t cy, uint8_t border_mask) {
+    if (u->change_count == u->change_capacity) {
+        u->change_capacity = u->change_capacity ? u->change_capacity * 2 : 256;
+        u->changes = (gol_chunk_change_t*)realloc(u->changes, (size_t)u->change_capacity * sizeof(gol_chunk_change_t));
+    }
+    u->changes[u->change_count++] = (gol_chunk_change_t){ cx, cy, border_mask };
+}
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+void gol_chunks_create(gol_chunks_t *u) {
+    memset(u, 0, sizeof(*u));
+    u->buckets = (gol_chunk_t**)calloc(GOL_CHUNKS_INITIAL_BUCKETS, sizeof(gol_chunk_t*));
+    u->bucket_mask = GOL_CHUNKS_INITIAL_BUCKETS - 1;
+}
+
+void gol_chunks_destroy(gol_chunks_t *u) {
+    if (u->buckets) gol_chunks_clear(u);
+    while (u->free_chunks) {
+        gol_chunk_t *c = u->free_chunks;
+        u->free_chunks = c->hash_next;
+        free(c);
+    }
+    free(u->buckets);
+    free(u->chunks);
+    free(u->active);
+    free(u->changes);
+    free(u->render_counts);
+    memset(u, 0, sizeof(*u));
+}
+
+// 64 cells of a bit-packed row starting at bit x (any alignment), zero past the edges
+static uint64_t gol_chunks_row_bits(const uint64_t *row, int words, int64_t x) {
+    int64_t wi = (x >= 0) ? x / 64 : -((-x + 63) / 64);
+    int shift = (int)(x - wi * 64);
+    uint64_t lo = (wi >= 0 && wi < words) ? row[wi] : 0;
+    uint64_t hi = (wi + 1 >= 0 && wi + 1 < words) ? row[wi + 1] : 0;
+    return shift ? (lo >> shift) | (hi << (64 - shift)) : lo;
+}
+
+void gol_chunks_load_rows(gol_chunks_t *u, const uint64_t *rows, int stride, int size) {
+    gol_chunks_clear(u);
+    const int words = (size + 63) / 64;
+    const int64_t origin = -(int64_t)(size / 2);
+    const int32_t c0 = (int32_t)(origin >> GOL_CHUNK_LOG2);
+    const int32_t c1 = (int32_t)((origin + size - 1) >> GOL_CHUNK_LOG2);
+
+    for (int32_t cy = c0; cy <= c1; cy++) {
+        for (int32_t cx = c0; cx <= c1; cx++) {
+            gol_chunk_t *c = gol_chunks_get(u, cx, cy);
+            for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+                int64_t by = (int64_t)cy * GOL_CHUNK_SIZE + y - origin;
+                if (by < 0 || by >= size) continue;
+                int64_t bx = (int64_t)cx * GOL_CHUNK_SIZE - origin;
+                c->rows[y] = gol_chunks_row_bits(rows + (size_t)by * stride, words, bx);
+                c->population += (uint32_t)gol_popcount64(c->rows[y]);
+            }
+            u->population += c->population;
+        }
+    }
+    gol_chunks_mark_all_changed(u);
+}
+
+void gol_chunks_set_run(gol_chunks_t *u, int64_t x, int64_t y, int64_t length) {
+    int32_t cy = (int32_t)(y >> GOL_CHUNK_LOG2);
+    int row = (int)(y & (GOL_CHUNK_SIZE - 1));
+    while (length > 0) {
+        int32_t cx = (int32_t)(x >> GOL_CHUNK_LOG2);
+        int bit = (int)(x & (GOL_CHUNK_SIZE - 1));
+        int count = (length < GOL_CHUNK_SIZE - bit) ? (int)length : GOL_CHUNK_SIZE - bit;
+        uint64_t mask = ((count == 64) ? ~0ULL : ((1ULL << count) - 1)) << bit;
+        gol_chunk_t *c = gol_chunks_get(u, cx, cy);
+        uint32_t born = (uint32_t)gol_popcount64(mask & ~c->rows[row]);
+        c->rows[row] |= mask;
+        c->population += born;
+        u->population += born;
+        x += count;
+        length -= count;
+    }
+}
+
+void gol_chunks_mark_all_changed(gol_chunks_t *u) {
+    // Drop chunks that came out empty, everything else is new, so every chunk
+    // and border counts as changed
+    for (int i = u->chunk_count - 1; i >= 0; i--) {
+        if (u->chunks[i]->population == 0) gol_chunks_release(u, u->chunks[i]);
+    }
+    u->change_count = 0;
+    for (int i = 0; i < u->chunk_count; i++) {
+        gol_chunks_push_change(u, u->chunks[i]->cx, u->chunks[i]->cy, 0xFF);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Update
+// -----------------------------------------------------------------------------
+static void gol_chunks_schedule(gol_chunks_t *u, int32_t cx, int32_t cy) {
+    gol_chunk_t *c = gol_chunks_get(u, cx, cy);
+    if (c->stamp == u->stamp) return;
+    c->stamp = u->stamp;
+    if (u->active_count == u->active_capacity) {
+        u->active_capacity = u->active_capacity ? u->active_capacity * 2 : 256;
+        u->active = (gol_chunk_t**)realloc(u->active, (size_t)u->active_capacity * sizeof(gol_chunk_t*));
+    }
+    u->active[u->active_count++] = c;
+}
+
+// Next generation of one chunk into next_rows. Rows -1 and 64 and the
+// columns either side come from the (possibly missing, i.e. empty) neighbors.
+static void gol_chunks_compute(const gol_chunks_t *u, gol_chunk_t *c) {
+    const gol_chunk_t *nb[GOL_DIR_COUNT];
+    for (int d = 0; d < GOL_DIR_COUNT; d++) {
+        nb[d] = gol_chunks_find(u, c->cx + gol_dir_dx[d], c->cy + gol_dir_dy[d]);
+    }
+
+    uint64_t mid[GOL_CHUNK_SIZE + 2], west[GOL_CHUNK_SIZE + 2], east[GOL_CHUNK_SIZE + 2];
+    uint64_t west_bit[GOL_CHUNK_SIZE + 2], east_bit[GOL_CHUNK_SIZE + 2];
+    mid[0]      = nb[GOL_DIR_N]  ? nb[GOL_DIR_N]->rows[GOL_CHUNK_SIZE - 1] : 0;
+    west_bit[0] = nb[GOL_DIR_NW] ? nb[GOL_DIR_NW]->rows[GOL_CHUNK_SIZE - 1] >> 63 : 0;
+    east_bit[0] = nb[GOL_DIR_NE] ? nb[GOL_DIR_NE]->rows[GOL_CHUNK_SIZE - 1] & 1 : 0;
+    for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+        mid[y + 1]      = c->rows[y];
+        west_bit[y + 1] = nb[GOL_DIR_W] ? nb[GOL_DIR_W]->rows[y] >> 63 : 0;
+        east_bit[y + 1] = nb[GOL_DIR_E] ? nb[GOL_DIR_E]->rows[y] & 1 : 0;
+    }
+    mid[GOL_CHUNK_SIZE + 1]      = nb[GOL_DIR_S]  ? nb[GOL_DIR_S]->rows[0] : 0;
+    west_bit[GOL_CHUNK_SIZE + 1] = nb[GOL_DIR_SW] ? nb[GOL_DIR_SW]->rows[0] >> 63 : 0;
+    east_bit[GOL_CHUNK_SIZE + 1] = nb[GOL_DIR_SE] ? nb[GOL_DIR_SE]->rows[0] & 1 : 0;
+
+    for (int i = 0; i < GOL_CHUNK_SIZE + 2; i++) {
+        west[i] = (mid[i] << 1) | west_bit[i];
+        east[i] = (mid[i] >> 1) | (east_bit[i] << 63);
+    }
+    for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+        c->next_rows[y] = gol_bitgrid_rule(west[y], mid[y], east[y],
+                                           west[y + 1], mid[y + 1], east[y + 1],
+                                           west[y + 2], mid[y + 2], east[y + 2]);
+    }
+}
+
+static void gol_chunks_compute_task(void *ctx, int task, int worker) {
+    (void)worker;
+    gol_chunks_t *u = (gol_chunks_t*)ctx;
+    int end = (task + 1) * GOL_CHUNKS_PER_TASK;
+    if (end > u->active_count) end = u->active_count;
+    for (int i = task * GOL_CHUNKS_PER_TASK; i < end; i++) {
+        gol_chunks_compute(u, u->active[i]);
+    }
+}
+
+// Which of the eight borders differ between rows and next_rows
+static uint8_t gol_chunks_border_mask(const gol_chunk_t *c) {
+    uint64_t top = c->rows[0] ^ c->next_rows[0];
+    uint64_t bottom = c->rows[GOL_CHUNK_SIZE - 1] ^ c->next_rows[GOL_CHUNK_SIZE - 1];
+    uint64_t cols = 0;
+    for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+        cols |= c->rows[y] ^ c->next_rows[y];
+    }
+    uint8_t mask = 0;
+    if (top)           mask |= 1 << GOL_DIR_N;
+    if (bottom)        mask |= 1 << GOL_DIR_S;
+    if (cols & 1)      mask |= 1 << GOL_DIR_W;
+    if (cols >> 63)    mask |= 1 << GOL_DIR_E;
+    if (top & 1)       mask |= 1 << GOL_DIR_NW;
+    if (top >> 63)     mask |= 1 << GOL_DIR_NE;
+    if (bottom & 1)    mask |= 1 << GOL_DIR_SW;
+    if (bottom >> 63)  mask |= 1 << GOL_DIR_SE;
+    return mask;
+}
+
+uint64_t gol_chunks_step(gol_chunks_t *u) {
+    // Chunks that changed, and neighbors across a changed border, may change
+    // again; everything else is stable and is skipped
+    u->stamp++;
+    u->active_count = 0;
+    for (int i = 0; i < u->change_count; i++) {
+        const gol_chunk_change_t *ch = &u->changes[i];
+        gol_chunks_schedule(u, ch->cx, ch->cy);
+        for (int d = 0; d < GOL_DIR_COUNT; d++) {
+            if (ch->border_mask & (1 << d)) {
+                gol_chunks_schedule(u, ch->cx + gol_dir_dx[d], ch->cy + gol_dir_dy[d]);
+            }
+        }
+    }
+
+    int tasks = (u->active_count + GOL_CHUNKS_PER_TASK - 1) / GOL_CHUNKS_PER_TASK;
+    sim_workers_run(gol_chunks_compute_task, u, tasks);
+
+    // Commit in schedule order and record what changed for the next generation
+    u->change_count = 0;
+    for (int i = 0; i < u->active_count; i++) {
+        gol_chunk_t *c = u->active[i];
+        uint64_t diff = 0;
+        uint32_t population = 0;
+        for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+            diff |= c->rows[y] ^ c->next_rows[y];
+            population += (uint32_t)gol_popcount64(c->next_rows[y]);
+        }
+        if (!diff) continue;
+        gol_chunks_push_change(u, c->cx, c->cy, gol_chunks_border_mask(c));
+        memcpy(c->rows, c->next_rows, sizeof(c->rows));
+        u->population = u->population - c->population + population;
+        c->population = population;
+    }
+    for (int i = 0; i < u->active_count; i++) {
+        if (u->active[i]->population == 0) gol_chunks_release(u, u->active[i]);
+    }
+    u->active_count = 0;
+    u->generation++;
+    return u->population;
+}
+
+// -----------------------------------------------------------------------------
+// Queries and rendering
+// -----------------------------------------------------------------------------
+int gol_chunks_bounds(const gol_chunks_t *u, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1) {
+    if (u->chunk_count == 0) return 0;
+    int32_t cx0 = INT32_MAX, cy0 = INT32_MAX, cx1 = INT32_MIN, cy1 = INT32_MIN;
+    for (int i = 0; i < u->chunk_count; i++) {
+        const gol_chunk_t *c = u->chunks[i];
+        if (c->cx < cx0) cx0 = c->cx;
+        if (c->cy < cy0) cy0 = c->cy;
+        if (c->cx > cx1) cx1 = c->cx;
+        if (c->cy > cy1) cy1 = c->cy;
+    }
+    *x0 = (int64_t)cx0 * GOL_CHUNK_SIZE;
+    *y0 = (int64_t)cy0 * GOL_CHUNK_SIZE;
+    *x1 = ((int64_t)cx1 + 1) * GOL_CHUNK_SIZE;
+    *y1 = ((int64_t)cy1 + 1) * GOL_CHUNK_SIZE;
+    return 1;
+}
+
+// Chunk extremes first, then cells only in the non-empty chunks on that border
+int gol_chunks_live_bounds(const gol_chunks_t *u, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1) {
+    int32_t cx0 = INT32_MAX, cy0 = INT32_MAX, cx1 = INT32_MIN, cy1 = INT32_MIN;
+    for (int i = 0; i < u->chunk_count; i++) {
+        const gol_chunk_t *c = u->chunks[i];
+        if (c->population == 0) continue;
+        if (c->cx < cx0) cx0 = c->cx;
+        if (c->cy < cy0) cy0 = c->cy;
+        if (c->cx > cx1) cx1 = c->cx;
+        if (c->cy > cy1) cy1 = c->cy;
+    }
+    if (cx0 > cx1) return 0;
+    int64_t bx0 = INT64_MAX, by0 = INT64_MAX, bx1 = INT64_MIN, by1 = INT64_MIN;
+    for (int i = 0; i < u->chunk_count; i++) {
+        const gol_chunk_t *c = u->chunks[i];
+        if (c->population == 0 || (c->cx != cx0 && c->cx != cx1 && c->cy != cy0 && c->cy != cy1)) continue;
+        int64_t ox = (int64_t)c->cx * GOL_CHUNK_SIZE;
+        int64_t oy = (int64_t)c->cy * GOL_CHUNK_SIZE;
+        uint64_t columns = 0;
+        for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+            if (!c->rows[y]) continue;
+            columns |= c->rows[y];
+            if (oy + y < by0) by0 = oy + y;
+            if (oy + y + 1 > by1) by1 = oy + y + 1;
+        }
+        int first = 0, last = GOL_CHUNK_SIZE - 1;
+        while (!((columns >> first) & 1)) first++;
+        while (!((columns >> last) & 1)) last--;
+        if (ox + first < bx0) bx0 = ox + first;
+        if (ox + last + 1 > bx1) bx1 = ox + last + 1;
+    }
+    *x0 = bx0;
+    *y0 = by0;
+    *x1 = bx1;
+    *y1 = by1;
+    return 1;
+}
+
+void gol_chunks_render_r8(gol_chunks_t *u, unsigned char *texels, int tex_size,
+                          int64_t x0, int64_t y0, int zoom) {
+    const int texel_count = tex_size * tex_size;
+    if (u->render_capacity < texel_count) {
+        free(u->render_counts);
+        u->render_counts = (uint32_t*)malloc((size_t)texel_count * sizeof(uint32_t));
+        u->render_capacity = texel_count;
+    }
+    memset(u->render_counts, 0, (size_t)texel_count * sizeof(uint32_t));
+
+    // Texels line up with 2^zoom aligned blocks of cells
+    const int64_t align = ~(((int64_t)1 << zoom) - 1);
+    x0 &= align;
+    y0 &= align;
+    const int64_t view_extent = (int64_t)tex_size << zoom;
+    const int block = (zoom < GOL_CHUNK_LOG2) ? (1 << zoom) : GOL_CHUNK_SIZE;
+    const uint64_t field_mask = (block >= 64) ? ~0ULL : ((1ULL << block) - 1);
+
+    for (int i = 0; i < u->chunk_count; i++) {
+        const gol_chunk_t *c = u->chunks[i];
+        int64_t cx = (int64_t)c->cx * GOL_CHUNK_SIZE;
+        int64_t cy = (int64_t)c->cy * GOL_CHUNK_SIZE;
+        if (cx >= x0 + view_extent || cy >= y0 + view_extent ||
+            cx + GOL_CHUNK_SIZE <= x0 || cy + GOL_CHUNK_SIZE <= y0) {
+            continue;
+        }
+        for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+            if (!c->rows[y]) continue;
+            int64_t ty = (cy + y - y0) >> zoom;
+            if (ty < 0 || ty >= tex_size) continue;
+            for (int f = 0; f < GOL_CHUNK_SIZE; f += block) {
+                int64_t tx = (cx + f - x0) >> zoom;
+                if (tx < 0 || tx >= tex_size) continue;
+                u->render_counts[ty * tex_size + tx] += (uint32_t)gol_popcount64((c->rows[y] >> f) & field_mask);
+            }
+        }
+    }
+
+    const double full = (double)((uint64_t)1 << zoom) * (double)((uint64_t)1 << zoom);
+    for (int i = 0; i < texel_count; i++) {
+        double v = 255.0 * (double)u->render_counts[i] / full;
+        texels[i] = (unsigned char)(v > 255.0 ? 255.0 : v);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef GOL_CHUNKS_H
+#define GOL_CHUNKS_H
+
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Unbounded chunked Game of Life universe
+//
+// Live space is covered by 64x64 chunks (one uint64_t per row, bit x = cell x)
+// kept in a hash map keyed by chunk coordinate. A generation only recomputes
+// chunks that changed in the previous one, plus the neighbors facing a border
+// that changed; every other chunk is known to be stable. Chunks are created
+// when cells may be born in them and released as soon as they are empty.
+// -----------------------------------------------------------------------------
+
+#define GOL_CHUNK_LOG2 6
+#define GOL_CHUNK_SIZE (1 << GOL_CHUNK_LOG2)
+
+typedef struct gol_chunk_t {
+    int32_t cx, cy;                       // Chunk coordinate (cell >> GOL_CHUNK_LOG2)
+    uint64_t rows[GOL_CHUNK_SIZE];
+    uint64_t next_rows[GOL_CHUNK_SIZE];
+    uint32_t population;
+    uint32_t stamp;                       // Generation it was last scheduled in
+    int index;                            // Position in gol_chunks_t.chunks
+    struct gol_chunk_t *hash_next;        // Bucket chain / free list link
+} gol_chunk_t;
+
+// A chunk that changed, with one bit per direction whose shared border changed
+typedef struct gol_chunk_change_t {
+    int32_t cx, cy;
+    uint8_t border_mask;
+} gol_chunk_change_t;
+
+typedef struct gol_chunks_t {
+    gol_chunk_t **buckets;
+    uint32_t bucket_mask;
+
+    gol_chunk_t **chunks;                 // Every allocated chunk
+    int chunk_count, chunk_capacity;
+    gol_chunk_t *free_chunks;             // Released chunks kept for reuse
+
+    gol_chunk_t **active;                 // Chunks updated this generation
+    int active_count, active_capacity;
+    gol_chunk_change_t *changes;          // Chunks that changed last generation
+    int change_count, change_capacity;
+
+    uint32_t *render_counts;              // Texel accumulator for rendering
+    int render_capacity;
+
+    uint32_t stamp;
+    uint64_t generation;
+    uint64_t population;
+} gol_chunks_t;
+
+void gol_chunks_create(gol_chunks_t *u);
+void gol_chunks_destroy(gol_chunks_t *u);
+
+// Replace the universe by a size x size block of bit-packed rows (64 cells
+// per word, rows `stride` words apart), centered on the origin
+void gol_chunks_load_rows(gol_chunks_t *u, const uint64_t *rows, int stride, int size);
+
+// Empty the universe
+void gol_chunks_clear(gol_chunks_t *u);
+
+// Set cells [x, x + length) of row y alive. Edits are not seen by the update
+// until gol_chunks_mark_all_changed is called.
+void gol_chunks_set_run(gol_chunks_t *u, int64_t x, int64_t y, int64_t length);
+void gol_chunks_mark_all_changed(gol_chunks_t *u);
+
+// Advance one generation and return the population
+uint64_t gol_chunks_step(gol_chunks_t *u);
+
+// Cell bounds of all allocated chunks; returns 0 when the universe is empty
+int gol_chunks_bounds(const gol_chunks_t *u, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1);
+
+// Half-open cell bounds of the live cells; returns 0 when the universe is empty
+int gol_chunks_live_bounds(const gol_chunks_t *u, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1);
+
+// Draw a tex_size x tex_size R8 window whose top-left cell is (x0, y0),
+// every texel holding the live fraction (0..255) of 2^zoom x 2^zoom cells
+void gol_chunks_render_r8(gol_chunks_t *u, unsigned char *texels, int tex_size,
+                          int64_t x0, int64_t y0, int zoom);
+
+#endif /* GOL_CHUNKS_H */
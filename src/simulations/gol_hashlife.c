@@ -0,0 +1,610 @@
+#include "gol_hashlife.h"
+#include "gol_bitgrid.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define GOL_HL_INITIAL_NODES (1u << 16)
+#define GOL_HL_INITIAL_GC_THRESHOLD (1u << 22)
+
+// -----------------------------------------------------------------------------
+// Node table: allocation, hash-consing and canonical nodes
+// -----------------------------------------------------------------------------
+static inline uint32_t hl_hash(uint64_t a, uint64_t b) {
+    uint64_t h = a * 0x9E3779B97F4A7C15ULL ^ (b + 0x632BE59BD9B4E019ULL) * 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 31;
+    h *= 0x94D049BB133111EBULL;
+    return (uint32_t)(h ^ (h >> 29));
+}
+
+static inline uint32_t hl_hash_quad(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    return hl_hash(((uint64_t)nw << 32) | ne, ((uint64_t)sw << 32) | se);
+}
+
+static inline uint32_t hl_hash_node(const gol_hl_node_t *n) {
+    if (n->level == GOL_HL_LEAF_LEVEL) return hl_hash(n->bits, 0);
+    return hl_hash_quad(n->quad[0], n->quad[1], n->quad[2], n->quad[3]);
+}
+
+static void hl_rehash(gol_hashlife_t *hl, uint32_t bucket_count) {
+    free(hl->buckets);
+    hl->buckets = (uint32_t*)calloc(bucket_count, sizeof(uint32_t));
+    hl->bucket_mask = bucket_count - 1;
+    for (uint32_t i = 1; i < hl->node_high; i++) {
+        gol_hl_node_t *n = &hl->nodes[i];
+        if (n->level == 0) continue;
+        uint32_t h = hl_hash_node(n) & hl->bucket_mask;
+        n->next = hl->buckets[h];
+        hl->buckets[h] = i;
+    }
+}
+
+// Hand out a node slot. May move hl->nodes, so callers re-fetch pointers.
+static uint32_t hl_alloc(gol_hashlife_t *hl) {
+    uint32_t idx;
+    if (hl->free_list != GOL_HL_NONE) {
+        idx = hl->free_list;
+        hl->free_list = hl->nodes[idx].next;
+    } else {
+        if (hl->node_high == hl->node_capacity) {
+            hl->node_capacity *= 2;
+            hl->nodes = (gol_hl_node_t*)realloc(hl->nodes, hl->node_capacity * sizeof(gol_hl_node_t));
+        }
+        idx = hl->node_high++;
+    }
+    hl->live_nodes++;
+    memset(&hl->nodes[idx], 0, sizeof(gol_hl_node_t));
+    return idx;
+}
+
+static void hl_insert(gol_hashlife_t *hl, uint32_t idx, uint32_t h) {
+    hl->nodes[idx].next = hl->buckets[h];
+    hl->buckets[h] = idx;
+    // Keep the load factor at or below one node per bucket
+    if (hl->live_nodes > hl->bucket_mask + 1) {
+        hl_rehash(hl, (hl->bucket_mask + 1) * 2);
+    }
+}
+
+static uint32_t hl_leaf(gol_hashlife_t *hl, uint64_t bits) {
+    uint32_t h = hl_hash(bits, 0) & hl->bucket_mask;
+    for (uint32_t i = hl->buckets[h]; i != GOL_HL_NONE; i = hl->nodes[i].next) {
+        const gol_hl_node_t *n = &hl->nodes[i];
+        if (n->level == GOL_HL_LEAF_LEVEL && n->bits == bits) return i;
+    }
+    uint32_t idx = hl_alloc(hl);
+    gol_hl_node_t *n = &hl->nodes[idx];
+    n->bits = bits;
+    n->level = GOL_HL_LEAF_LEVEL;
+    n->population = (uint64_t)gol_popcount64(bits);
+    hl_insert(hl, idx, h);
+    return idx;
+}
+
+static uint32_t hl_node(gol_hashlife_t *hl, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    uint32_t h = hl_hash_quad(nw, ne, sw, se) & hl->bucket_mask;
+    uint8_t level = (uint8_t)(hl->nodes[nw].level + 1);
+    for (uint32_t i = hl->buckets[h]; i != GOL_HL_NONE; i = hl->nodes[i].next) {
+        const gol_hl_node_t *n = &hl->nodes[i];
+        if (n->level == level && n->quad[0] == nw && n->quad[1] == ne && n->quad[2] == sw && n->quad[3] == se) {
+            return i;
+        }
+    }
+    uint32_t idx = hl_alloc(hl);
+    gol_hl_node_t *n = &hl->nodes[idx];
+    n->quad[0] = nw;
+    n->quad[1] = ne;
+    n->quad[2] = sw;
+    n->quad[3] = se;
+    n->level = level;
+    n->population = hl->nodes[nw].population + hl->nodes[ne].population +
+                    hl->nodes[sw].population + hl->nodes[se].population;
+    hl_insert(hl, idx, h);
+    return idx;
+}
+
+static void hl_reset_table(gol_hashlife_t *hl) {
+    memset(hl->nodes, 0, sizeof(gol_hl_node_t)); // slot 0 stays unused
+    hl->node_high = 1;
+    hl->live_nodes = 0;
+    hl->free_list = GOL_HL_NONE;
+    memset(hl->buckets, 0, (hl->bucket_mask + 1) * sizeof(uint32_t));
+
+    hl->empty[GOL_HL_LEAF_LEVEL] = hl_leaf(hl, 0);
+    for (int level = GOL_HL_LEAF_LEVEL + 1; level <= GOL_HL_MAX_LEVEL; level++) {
+        uint32_t e = hl->empty[level - 1];
+        hl->empty[level] = hl_node(hl, e, e, e, e);
+    }
+    hl->root = hl->empty[GOL_HL_LEAF_LEVEL + 1];
+    hl->generation = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+void gol_hashlife_create(gol_hashlife_t *hl) {
+    memset(hl, 0, sizeof(*hl));
+    hl->node_capacity = GOL_HL_INITIAL_NODES;
+    hl->nodes = (gol_hl_node_t*)malloc(hl->node_capacity * sizeof(gol_hl_node_t));
+    hl->buckets = (uint32_t*)calloc(GOL_HL_INITIAL_NODES, sizeof(uint32_t));
+    hl->bucket_mask = GOL_HL_INITIAL_NODES - 1;
+    hl->gc_threshold = GOL_HL_INITIAL_GC_THRESHOLD;
+    hl_reset_table(hl);
+}
+
+void gol_hashlife_destroy(gol_hashlife_t *hl) {
+    if (hl->nodes) { free(hl->nodes); hl->nodes = NULL; }
+    if (hl->buckets) { free(hl->buckets); hl->buckets = NULL; }
+    hl->node_capacity = 0;
+    hl->node_high = 0;
+    hl->live_nodes = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Loading from bit-packed rows
+// -----------------------------------------------------------------------------
+static inline int hl_row_bit(const uint64_t *row, int size, int64_t x) {
+    if (x < 0 || x >= size) return 0;
+    return (int)((row[x / 64] >> (x % 64)) & 1);
+}
+
+// Build the node whose top-left corner sits at (bx, by) in row coordinates
+static uint32_t hl_build(gol_hashlife_t *hl, const uint64_t *rows, int stride, int size,
+                         int64_t bx, int64_t by, int level) {
+    int64_t extent = (int64_t)1 << level;
+    if (bx >= size || by >= size || bx + extent <= 0 || by + extent <= 0) {
+        return hl->empty[level];
+    }
+    if (level == GOL_HL_LEAF_LEVEL) {
+        uint64_t bits = 0;
+        for (int y = 0; y < 8; y++) {
+            if (by + y < 0 || by + y >= size) continue;
+            const uint64_t *row = rows + (size_t)(by + y) * stride;
+            for (int x = 0; x < 8; x++) {
+                bits |= (uint64_t)hl_row_bit(row, size, bx + x) << (y * 8 + x);
+            }
+        }
+        return hl_leaf(hl, bits);
+    }
+    int64_t half = extent / 2;
+    uint32_t nw = hl_build(hl, rows, stride, size, bx,        by,        level - 1);
+    uint32_t ne = hl_build(hl, rows, stride, size, bx + half, by,        level - 1);
+    uint32_t sw = hl_build(hl, rows, stride, size, bx,        by + half, level - 1);
+    uint32_t se = hl_build(hl, rows, stride, size, bx + half, by + half, level - 1);
+    return hl_node(hl, nw, ne, sw, se);
+}
+
+void gol_hashlife_load_rows(gol_hashlife_t *hl, const uint64_t *rows, int stride, int size) {
+    hl_reset_table(hl);
+    // The block spans [-size / 2, size - size / 2) around the origin
+    int level = GOL_HL_LEAF_LEVEL + 1;
+    while (((int64_t)1 << (level - 1)) < size - size / 2) {
+        level++;
+    }
+    int64_t origin = -((int64_t)1 << (level - 1)) + size / 2;
+    hl->root = hl_build(hl, rows, stride, size, origin, origin, level);
+}
+
+static uint32_t hl_expand(gol_hashlife_t *hl, uint32_t root);
+
+// -----------------------------------------------------------------------------
+// Importing: canonical nodes and placement at arbitrary cell offsets
+// -----------------------------------------------------------------------------
+void gol_hashlife_clear(gol_hashlife_t *hl) {
+    hl_reset_table(hl);
+}
+
+uint32_t gol_hashlife_leaf(gol_hashlife_t *hl, uint64_t bits) {
+    return hl_leaf(hl, bits);
+}
+
+uint32_t gol_hashlife_node(gol_hashlife_t *hl, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se) {
+    return hl_node(hl, nw, ne, sw, se);
+}
+
+// Union of two nodes of the same level
+static uint32_t hl_or(gol_hashlife_t *hl, uint32_t a, uint32_t b) {
+    if (a == b || hl->nodes[b].population == 0) return a;
+    if (hl->nodes[a].population == 0) return b;
+    if (hl->nodes[a].level == GOL_HL_LEAF_LEVEL) {
+        return hl_leaf(hl, hl->nodes[a].bits | hl->nodes[b].bits);
+    }
+    uint32_t qa[4], qb[4];
+    memcpy(qa, hl->nodes[a].quad, sizeof(qa));
+    memcpy(qb, hl->nodes[b].quad, sizeof(qb));
+    for (int i = 0; i < 4; i++) qa[i] = hl_or(hl, qa[i], qb[i]);
+    return hl_node(hl, qa[0], qa[1], qa[2], qa[3]);
+}
+
+// Move the cells of a leaf by (dx, dy) with |dx|, |dy| < 8, dropping the
+// ones that leave it
+static uint64_t hl_shift_leaf(uint64_t bits, int dx, int dy) {
+    const uint64_t rows = 0x0101010101010101ULL;
+    if (dy > 0) bits <<= 8 * dy;
+    else if (dy < 0) bits >>= 8 * -dy;
+    if (dx > 0) bits = (bits << dx) & (rows * ((0xFFu << dx) & 0xFFu));
+    else if (dx < 0) bits = (bits >> -dx) & (rows * (0xFFu >> -dx));
+    return bits;
+}
+
+// OR node src with top-left (sx, sy) into node dst with top-left (dx, dy),
+// where src is at most as deep as dst
+static uint32_t hl_place(gol_hashlife_t *hl, uint32_t dst, int64_t dx, int64_t dy,
+                         uint32_t src, int64_t sx, int64_t sy) {
+    if (hl->nodes[src].population == 0) return dst;
+    int dl = hl->nodes[dst].level, sl = hl->nodes[src].level;
+    int64_t de = (int64_t)1 << dl, se = (int64_t)1 << sl;
+    if (sx >= dx + de || sy >= dy + de || sx + se <= dx || sy + se <= dy) return dst;
+    if (dl == sl && sx == dx && sy == dy) return hl_or(hl, dst, src);
+    if (dl == GOL_HL_LEAF_LEVEL) {
+        uint64_t bits = hl_shift_leaf(hl->nodes[src].bits, (int)(sx - dx), (int)(sy - dy));
+        return hl_leaf(hl, hl->nodes[dst].bits | bits);
+    }
+
+    int64_t half = de / 2;
+    int64_t qx0 = (sx - dx) / half, qx1 = (sx + se - 1 - dx) / half;
+    int64_t qy0 = (sy - dy) / half, qy1 = (sy + se - 1 - dy) / half;
+    int fits = sx >= dx && sy >= dy && qx0 == qx1 && qy0 == qy1 && qx1 < 2 && qy1 < 2;
+    if (!fits && sl > GOL_HL_LEAF_LEVEL) {
+        // Straddles quadrants: place its children one by one
+        uint32_t q[4];
+        memcpy(q, hl->nodes[src].quad, sizeof(q));
+        int64_t sh = se / 2;
+        for (int i = 0; i < 4; i++) {
+            dst = hl_place(hl, dst, dx, dy, q[i], sx + (i & 1) * sh, sy + (i >> 1) * sh);
+        }
+        return dst;
+    }
+    // Fits one quadrant, or is a leaf that gets shifted into each one it touches
+    uint32_t q[4];
+    memcpy(q, hl->nodes[dst].quad, sizeof(q));
+    for (int i = 0; i < 4; i++) {
+        q[i] = hl_place(hl, q[i], dx + (i & 1) * half, dy + (i >> 1) * half, src, sx, sy);
+    }
+    return hl_node(hl, q[0], q[1], q[2], q[3]);
+}
+
+void gol_hashlife_place(gol_hashlife_t *hl, uint32_t n, int64_t x, int64_t y) {
+    int level = hl->nodes[n].level;
+    int64_t extent = (int64_t)1 << level;
+    uint32_t root = hl->root;
+    for (;;) {
+        int root_level = hl->nodes[root].level;
+        int64_t half = (int64_t)1 << (root_level - 1);
+        if (root_level >= GOL_HL_MAX_LEVEL ||
+            (root_level > level && x >= -half && y >= -half && x + extent <= half && y + extent <= half)) {
+            break;
+        }
+        root = hl_expand(hl, root);
+    }
+    int64_t half = (int64_t)1 << (hl->nodes[root].level - 1);
+    hl->root = hl_place(hl, root, -half, -half, n, x, y);
+}
+
+// -----------------------------------------------------------------------------
+// RESULT: the centered half-size node advanced 2^min(step_log2, level - 2)
+// generations, memoized per node
+// -----------------------------------------------------------------------------
+
+// Brute-force base case: run a 16x16 block (four leaves) for `gens` <= 4
+// generations and return its central 8x8 cells
+static uint64_t hl_base_result(uint64_t nw, uint64_t ne, uint64_t sw, uint64_t se, int gens) {
+    uint64_t rows[16];
+    for (int y = 0; y < 8; y++) {
+        rows[y]     = ((nw >> (y * 8)) & 0xFF) | (((ne >> (y * 8)) & 0xFF) << 8);
+        rows[y + 8] = ((sw >> (y * 8)) & 0xFF) | (((se >> (y * 8)) & 0xFF) << 8);
+    }
+    for (int g = 0; g < gens; g++) {
+        uint64_t next[16];
+        for (int y = 0; y < 16; y++) {
+            uint64_t a = (y > 0) ? rows[y - 1] : 0;
+            uint64_t b = rows[y];
+            uint64_t c = (y < 15) ? rows[y + 1] : 0;
+            next[y] = gol_bitgrid_rule(a << 1, a, a >> 1, b << 1, b, b >> 1, c << 1, c, c >> 1) & 0xFFFF;
+        }
+        memcpy(rows, next, sizeof(rows));
+    }
+    uint64_t bits = 0;
+    for (int y = 0; y < 8; y++) {
+        bits |= ((rows[y + 4] >> 4) & 0xFF) << (y * 8);
+    }
+    return bits;
+}
+
+static uint32_t hl_leaf_level_result(gol_hashlife_t *hl, uint32_t n, int gens) {
+    const gol_hl_node_t *node = &hl->nodes[n];
+    uint64_t bits = hl_base_result(hl->nodes[node->quad[0]].bits, hl->nodes[node->quad[1]].bits,
+                                   hl->nodes[node->quad[2]].bits, hl->nodes[node->quad[3]].bits, gens);
+    return hl_leaf(hl, bits);
+}
+
+// The centered half-size node without advancing time
+static uint32_t hl_center(gol_hashlife_t *hl, uint32_t n) {
+    if (hl->nodes[n].level == GOL_HL_LEAF_LEVEL + 1) {
+        return hl_leaf_level_result(hl, n, 0);
+    }
+    const gol_hl_node_t *node = &hl->nodes[n];
+    uint32_t nw = hl->nodes[node->quad[0]].quad[3];
+    uint32_t ne = hl->nodes[node->quad[1]].quad[2];
+    uint32_t sw = hl->nodes[node->quad[2]].quad[1];
+    uint32_t se = hl->nodes[node->quad[3]].quad[0];
+    return hl_node(hl, nw, ne, sw, se);
+}
+
+static uint32_t hl_result(gol_hashlife_t *hl, uint32_t n) {
+    if (hl->nodes[n].result != GOL_HL_NONE) {
+        return hl->nodes[n].result;
+    }
+    int level = hl->nodes[n].level;
+    uint32_t r;
+    if (hl->nodes[n].population == 0) {
+        r = hl->empty[level - 1];
+    } else if (level == GOL_HL_LEAF_LEVEL + 1) {
+        int gens = 1 << (hl->step_log2 < 2 ? hl->step_log2 : 2);
+        r = hl_leaf_level_result(hl, n, gens);
+    } else {
+        // Copy out children and grandchildren: node creation may move the table
+        uint32_t q[4], g[4][4];
+        for (int i = 0; i < 4; i++) {
+            q[i] = hl->nodes[n].quad[i];
+            for (int j = 0; j < 4; j++) g[i][j] = hl->nodes[q[i]].quad[j];
+        }
+        enum { NW, NE, SW, SE };
+
+        // Nine overlapping sub-nodes one level down
+        uint32_t sub[3][3] = {
+            { q[NW], hl_node(hl, g[NW][NE], g[NE][NW], g[NW][SE], g[NE][SW]), q[NE] },
+            { hl_node(hl, g[NW][SW], g[NW][SE], g[SW][NW], g[SW][NE]),
+              hl_node(hl, g[NW][SE], g[NE][SW], g[SW][NE], g[SE][NW]),
+              hl_node(hl, g[NE][SW], g[NE][SE], g[SE][NW], g[SE][NE]) },
+            { q[SW], hl_node(hl, g[SW][NE], g[SE][NW], g[SW][SE], g[SE][SW]), q[SE] },
+        };
+
+        // At full speed both halves of the jump advance time; for smaller
+        // steps the first half only re-centers and the second does all of it
+        int full_speed = (level - 2 <= hl->step_log2);
+        for (int y = 0; y < 3; y++) {
+            for (int x = 0; x < 3; x++) {
+                sub[y][x] = full_speed ? hl_result(hl, sub[y][x]) : hl_center(hl, sub[y][x]);
+            }
+        }
+        uint32_t a = hl_node(hl, sub[0][0], sub[0][1], sub[1][0], sub[1][1]);
+        uint32_t b = hl_node(hl, sub[0][1], sub[0][2], sub[1][1], sub[1][2]);
+        uint32_t c = hl_node(hl, sub[1][0], sub[1][1], sub[2][0], sub[2][1]);
+        uint32_t d = hl_node(hl, sub[1][1], sub[1][2], sub[2][1], sub[2][2]);
+        a = hl_result(hl, a);
+        b = hl_result(hl, b);
+        c = hl_result(hl, c);
+        d = hl_result(hl, d);
+        r = hl_node(hl, a, b, c, d);
+    }
+    hl->nodes[n].result = r;
+    return r;
+}
+
+// -----------------------------------------------------------------------------
+// Stepping
+// -----------------------------------------------------------------------------
+
+// Wrap the root in a border of empty space, keeping it centered on the origin
+static uint32_t hl_expand(gol_hashlife_t *hl, uint32_t root) {
+    uint32_t e = hl->empty[hl->nodes[root].level - 1];
+    uint32_t q[4];
+    memcpy(q, hl->nodes[root].quad, sizeof(q));
+    uint32_t nw = hl_node(hl, e, e, e, q[0]);
+    uint32_t ne = hl_node(hl, e, e, q[1], e);
+    uint32_t sw = hl_node(hl, e, q[2], e, e);
+    uint32_t se = hl_node(hl, q[3], e, e, e);
+    return hl_node(hl, nw, ne, sw, se);
+}
+
+// True when every live cell lies in the central half of the node
+static int hl_is_centered(const gol_hashlife_t *hl, uint32_t n) {
+    const gol_hl_node_t *node = &hl->nodes[n];
+    static const int outer[4][3] = { {0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3} };
+    for (int i = 0; i < 4; i++) {
+        const gol_hl_node_t *child = &hl->nodes[node->quad[i]];
+        for (int j = 0; j < 3; j++) {
+            if (hl->nodes[child->quad[outer[i][j]]].population != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+void gol_hashlife_set_step(gol_hashlife_t *hl, int step_log2) {
+    if (step_log2 < 0) step_log2 = 0;
+    if (step_log2 > GOL_HL_MAX_STEP_LOG2) step_log2 = GOL_HL_MAX_STEP_LOG2;
+    if (step_log2 == hl->step_log2) return;
+
+    // Nodes up to level min(old, new) + 2 advance the same amount either way
+    int keep_level = ((step_log2 < hl->step_log2) ? step_log2 : hl->step_log2) + 2;
+    for (uint32_t i = 1; i < hl->node_high; i++) {
+        if (hl->nodes[i].level > keep_level) hl->nodes[i].result = GOL_HL_NONE;
+    }
+    hl->step_log2 = step_log2;
+}
+
+void gol_hashlife_step(gol_hashlife_t *hl) {
+    if (hl->live_nodes > hl->gc_threshold) {
+        gol_hashlife_collect(hl);
+    }
+
+    // The root must be deep enough for the jump and leave the pattern room to
+    // grow by one cell per generation without leaving the RESULT window
+    uint32_t root = hl->root;
+    while (hl->nodes[root].level < GOL_HL_MAX_LEVEL - 1 &&
+           (hl->nodes[root].level < hl->step_log2 + 3 ||
+            hl->nodes[root].level < GOL_HL_LEAF_LEVEL + 2 ||
+            !hl_is_centered(hl, root))) {
+        root = hl_expand(hl, root);
+    }
+    root = hl_expand(hl, root);
+    hl->root = hl_result(hl, root);
+    hl->generation += (uint64_t)1 << hl->step_log2;
+}
+
+// -----------------------------------------------------------------------------
+// Garbage collection: mark from the root, sweep the rest into the free list.
+// Memoized results are kept only when their target survives.
+// -----------------------------------------------------------------------------
+static void hl_mark(gol_hashlife_t *hl, uint32_t n) {
+    gol_hl_node_t *node = &hl->nodes[n];
+    if (node->marked) return;
+    node->marked = 1;
+    if (node->level > GOL_HL_LEAF_LEVEL) {
+        for (int i = 0; i < 4; i++) hl_mark(hl, node->quad[i]);
+    }
+}
+
+void gol_hashlife_collect(gol_hashlife_t *hl) {
+    hl_mark(hl, hl->root);
+    for (int level = GOL_HL_LEAF_LEVEL; level <= GOL_HL_MAX_LEVEL; level++) {
+        hl_mark(hl, hl->empty[level]);
+    }
+
+    memset(hl->buckets, 0, (hl->bucket_mask + 1) * sizeof(uint32_t));
+    hl->free_list = GOL_HL_NONE;
+    hl->live_nodes = 0;
+    for (uint32_t i = hl->node_high - 1; i >= 1; i--) {
+        gol_hl_node_t *n = &hl->nodes[i];
+        if (n->level != 0 && n->marked) {
+            if (n->result != GOL_HL_NONE && !hl->nodes[n->result].marked) {
+                n->result = GOL_HL_NONE;
+            }
+            uint32_t h = hl_hash_node(n) & hl->bucket_mask;
+            n->next = hl->buckets[h];
+            hl->buckets[h] = i;
+            hl->live_nodes++;
+        } else {
+            n->level = 0;
+            n->next = hl->free_list;
+            hl->free_list = i;
+        }
+    }
+    for (uint32_t i = 1; i < hl->node_high; i++) {
+        hl->nodes[i].marked = 0;
+    }
+    hl->gc_runs++;
+
+    // Avoid collecting every step when the live set is close to the threshold
+    if (hl->live_nodes > hl->gc_threshold / 2) {
+        hl->gc_threshold *= 2;
+    }
+}
+
+uint64_t gol_hashlife_population(const gol_hashlife_t *hl) {
+    return hl->nodes[hl->root].population;
+}
+
+int gol_hashlife_root_level(const gol_hashlife_t *hl) {
+    return hl->nodes[hl->root].level;
+}
+
+// -----------------------------------------------------------------------------
+// Live bounds: descend only into non-empty nodes that could still grow the box
+// -----------------------------------------------------------------------------
+typedef struct {
+    int64_t x0, y0, x1, y1;      // Half-open; x0 > x1 while nothing was found
+} hl_bounds_t;
+
+static void hl_bounds(const gol_hashlife_t *hl, hl_bounds_t *b, uint32_t n, int64_t x, int64_t y) {
+    const gol_hl_node_t *node = &hl->nodes[n];
+    if (node->population == 0) return;
+    int64_t extent = (int64_t)1 << node->level;
+    if (b->x0 <= b->x1 && x >= b->x0 && y >= b->y0 && x + extent <= b->x1 && y + extent <= b->y1) {
+        return;
+    }
+    if (node->level == GOL_HL_LEAF_LEVEL) {
+        for (int cy = 0; cy < 8; cy++) {
+            for (int cx = 0; cx < 8; cx++) {
+                if (!((node->bits >> (cy * 8 + cx)) & 1)) continue;
+                if (x + cx < b->x0) b->x0 = x + cx;
+                if (y + cy < b->y0) b->y0 = y + cy;
+                if (x + cx + 1 > b->x1) b->x1 = x + cx + 1;
+                if (y + cy + 1 > b->y1) b->y1 = y + cy + 1;
+            }
+        }
+        return;
+    }
+    int64_t half = extent / 2;
+    hl_bounds(hl, b, node->quad[0], x,        y);
+    hl_bounds(hl, b, node->quad[1], x + half, y);
+    hl_bounds(hl, b, node->quad[2], x,        y + half);
+    hl_bounds(hl, b, node->quad[3], x + half, y + half);
+}
+
+int gol_hashlife_live_bounds(const gol_hashlife_t *hl, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1) {
+    if (hl->nodes[hl->root].population == 0) return 0;
+    hl_bounds_t b = { INT64_MAX, INT64_MAX, INT64_MIN, INT64_MIN };
+    int64_t origin = -((int64_t)1 << (hl->nodes[hl->root].level - 1));
+    hl_bounds(hl, &b, hl->root, origin, origin);
+    *x0 = b.x0;
+    *y0 = b.y0;
+    *x1 = b.x1;
+    *y1 = b.y1;
+    return 1;
+}
+
+// -----------------------------------------------------------------------------
+// Rendering: descend only into non-empty nodes that overlap the window
+// -----------------------------------------------------------------------------
+typedef struct {
+    unsigned char *texels;
+    int tex_size;
+    int64_t x0, y0;
+    int zoom;
+} hl_view_t;
+
+static void hl_put_texel(const hl_view_t *view, int64_t x, int64_t y, uint64_t count) {
+    int64_t tx = (x - view->x0) >> view->zoom;
+    int64_t ty = (y - view->y0) >> view->zoom;
+    if (tx < 0 || ty < 0 || tx >= view->tex_size || ty >= view->tex_size) return;
+    double full = (double)((uint64_t)1 << view->zoom) * (double)((uint64_t)1 << view->zoom);
+    double v = 255.0 * (double)count / full;
+    view->texels[(size_t)ty * view->tex_size + (size_t)tx] = (unsigned char)(v > 255.0 ? 255.0 : v);
+}
+
+static void hl_draw(const gol_hashlife_t *hl, const hl_view_t *view, uint32_t n, int64_t x, int64_t y) {
+    const gol_hl_node_t *node = &hl->nodes[n];
+    if (node->population == 0) return;
+    int64_t extent = (int64_t)1 << node->level;
+    int64_t view_extent = (int64_t)view->tex_size << view->zoom;
+    if (x >= view->x0 + view_extent || y >= view->y0 + view_extent ||
+        x + extent <= view->x0 || y + extent <= view->y0) {
+        return;
+    }
+    if (node->level <= view->zoom) {
+        hl_put_texel(view, x, y, node->population);
+        return;
+    }
+    if (node->level == GOL_HL_LEAF_LEVEL) {
+        // Blocks smaller than a leaf: count them straight from the bits
+        int block = 1 << view->zoom;
+        uint64_t row_mask = (1ULL << block) - 1;
+        for (int by = 0; by < 8; by += block) {
+            for (int bx = 0; bx < 8; bx += block) {
+                uint64_t mask = 0;
+                for (int r = 0; r < block; r++) mask |= row_mask << ((by + r) * 8 + bx);
+                hl_put_texel(view, x + bx, y + by, (uint64_t)gol_popcount64(node->bits & mask));
+            }
+        }
+        return;
+    }
+    int64_t half = extent / 2;
+    uint32_t q[4];
+    memcpy(q, node->quad, sizeof(q));
+    hl_draw(hl, view, q[0], x,        y);
+    hl_draw(hl, view, q[1], x + half, y);
+    hl_draw(hl, view, q[2], x,        y + half);
+    hl_draw(hl, view, q[3], x + half, y + half);
+}
+
+void gol_hashlife_render_r8(const gol_hashlife_t *hl, unsigned char *texels, int tex_size,
+                            int64_t x0, int64_t y0, int zoom) {
+    memset(texels, 0, (size_t)tex_size * tex_size);
+    // Texels must line up with 2^zoom aligned nodes
+    int64_t align = ~(((int64_t)1 << zoom) - 1);
+    hl_view_t view = { texels, tex_size, x0 & align, y0 & align, zoom };
+    int level = hl->nodes[hl->root].level;
+    int64_t origin = -((int64_t)1 << (level - 1));
+    hl_draw(hl, &view, hl->root, origin, origin);
+}
@@ -0,0 +1,88 @@
+#ifndef GOL_HASHLIFE_H
+#define GOL_HASHLIFE_H
+
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// HashLife Game of Life engine
+//
+// The (unbounded) universe is a canonical quadtree: every distinct node exists
+// exactly once in a hash-consed node table, so repeated structure is shared
+// in space and, through the memoized RESULT of each node, in time as well.
+// Leaves are 8x8 blocks of cells packed into one uint64_t. The root is always
+// centered on cell (0, 0).
+// -----------------------------------------------------------------------------
+
+#define GOL_HL_LEAF_LEVEL 3      // Leaves are 2^3 x 2^3 cells
+#define GOL_HL_MAX_LEVEL 60
+#define GOL_HL_MAX_STEP_LOG2 (GOL_HL_MAX_LEVEL - 4)
+#define GOL_HL_NONE 0u           // Node index 0 is never a valid node
+
+typedef struct gol_hl_node_t {
+    union {
+        uint32_t quad[4];        // nw, ne, sw, se children (level > GOL_HL_LEAF_LEVEL)
+        uint64_t bits;           // Leaf cells, bit y * 8 + x
+    };
+    uint64_t population;         // Cached live-cell count of the whole node
+    uint32_t result;             // Memoized RESULT or GOL_HL_NONE
+    uint32_t next;               // Hash chain / free list link
+    uint8_t level;               // 0 marks a free slot
+    uint8_t marked;              // Garbage collector mark
+} gol_hl_node_t;
+
+typedef struct gol_hashlife_t {
+    gol_hl_node_t *nodes;
+    uint32_t node_capacity;
+    uint32_t node_high;          // Slots handed out so far (live or free)
+    uint32_t live_nodes;
+    uint32_t free_list;
+    uint32_t *buckets;
+    uint32_t bucket_mask;
+    uint32_t empty[GOL_HL_MAX_LEVEL + 1]; // Canonical empty node per level
+    uint32_t root;
+    int step_log2;               // Memoized results advance 2^step_log2 generations
+    uint32_t gc_threshold;       // Collect once this many nodes are live
+    uint32_t gc_runs;
+    uint64_t generation;
+} gol_hashlife_t;
+
+void gol_hashlife_create(gol_hashlife_t *hl);
+void gol_hashlife_destroy(gol_hashlife_t *hl);
+
+// Replace the universe by a size x size block of bit-packed rows (64 cells
+// per word, rows `stride` words apart), centered on the origin
+void gol_hashlife_load_rows(gol_hashlife_t *hl, const uint64_t *rows, int stride, int size);
+
+// Empty the universe
+void gol_hashlife_clear(gol_hashlife_t *hl);
+
+// Canonical nodes for importers (see gol_pattern.h). Children of a node share
+// a level; GOL_HL_NONE is not a valid child, use hl->empty[level] instead.
+uint32_t gol_hashlife_leaf(gol_hashlife_t *hl, uint64_t bits);
+uint32_t gol_hashlife_node(gol_hashlife_t *hl, uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+
+// OR the cells of node n into the universe with its top-left cell at (x, y).
+// Aligned placements share whole subtrees, unaligned ones are split down to
+// leaves.
+void gol_hashlife_place(gol_hashlife_t *hl, uint32_t n, int64_t x, int64_t y);
+
+// Change the number of generations (2^step_log2) advanced by gol_hashlife_step.
+// Memoized results that are still valid for the new step size are kept.
+void gol_hashlife_set_step(gol_hashlife_t *hl, int step_log2);
+void gol_hashlife_step(gol_hashlife_t *hl);
+
+// Free every node that is not reachable from the root
+void gol_hashlife_collect(gol_hashlife_t *hl);
+
+uint64_t gol_hashlife_population(const gol_hashlife_t *hl);
+int gol_hashlife_root_level(const gol_hashlife_t *hl);
+
+// Half-open cell bounds of the live cells; returns 0 when the universe is empty
+int gol_hashlife_live_bounds(const gol_hashlife_t *hl, int64_t *x0, int64_t *y0, int64_t *x1, int64_t *y1);
+
+// Draw a tex_size x tex_size R8 window whose top-left cell is (x0, y0),
+// every texel holding the live fraction (0..255) of 2^zoom x 2^zoom cells
+void gol_hashlife_render_r8(const gol_hashlife_t *hl, unsigned char *texels, int tex_size,
+                            int64_t x0, int64_t y0, int zoom);
+
+#endif /* GOL_HASHLIFE_H */
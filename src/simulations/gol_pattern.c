@@ -0,0 +1,808 @@
+#include "gol_pattern.h"
+#include "sokol_time.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define GOL_PATTERN_MMAP 1
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#else
+    #define GOL_PATTERN_MMAP 0
+#endif
+
+#define GOL_PATTERN_READ_BLOCK (4 << 20)  // Block size when the file can't be mapped
+#define GOL_PATTERN_LINE_MAX 512          // Longest header / Macrocell line
+#define GOL_PATTERN_RLE_LINE 70           // RLE writer line width
+
+static inline int gol_ctz64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) { v >>= 1; n++; }
+    return n;
+#endif
+}
+
+// Length of the run of ones starting at bit 0 of v
+static inline int gol_ones_run(uint64_t v) {
+    return (v == ~0ULL) ? 64 : gol_ctz64(~v);
+}
+
+// -----------------------------------------------------------------------------
+// Cell sink: live runs of a row written into the target engine
+// -----------------------------------------------------------------------------
+#define GOL_PATTERN_BLOCK_LOG2 6           // HashLife imports 64x64 blocks at a time
+
+typedef struct {
+    int64_t x;                   // Block column (cell x >> GOL_PATTERN_BLOCK_LOG2)
+    int used;
+    uint64_t leaves[64];         // 8x8 leaves, row-major
+} pattern_block_t;
+
+typedef struct {
+    gol_pattern_target_t target;
+    uint64_t cells;
+
+    // HashLife: a band of 64 rows is gathered into blocks of leaves, each
+    // placed as one node
+    int64_t band;
+    pattern_block_t *blocks;
+    uint32_t block_mask;
+    uint32_t block_count;
+} pattern_sink_t;
+
+static void sink_bitgrid_run(gol_bitgrid_t *grid, int64_t x, int64_t y, int64_t length) {
+    const int64_t size = grid->size;
+    if (length > size) length = size;
+    int64_t gy = ((y + size / 2) % size + size) % size;
+    int64_t gx = ((x + size / 2) % size + size) % size;
+    uint64_t *row = gol_bitgrid_row(grid, (int)gy);
+    while (length > 0) {
+        // Up to the torus edge, then wrap to column 0
+        int64_t end = gx + ((length < size - gx) ? length : size - gx);
+        length -= end - gx;
+        while (gx < end) {
+            int bit = (int)(gx % 64);
+            int count = (end - gx < 64 - bit) ? (int)(end - gx) : 64 - bit;
+            row[gx / 64] |= ((count == 64) ? ~0ULL : ((1ULL << count) - 1)) << bit;
+            gx += count;
+        }
+        gx = 0;
+    }
+}
+
+static pattern_block_t *sink_block(pattern_sink_t *s, int64_t x) {
+    if ((s->block_count + 1) * 2 > s->block_mask + 1) {
+        uint32_t old_capacity = s->block_mask + 1;
+        pattern_block_t *old = s->blocks;
+        s->block_mask = old_capacity * 2 - 1;
+        s->blocks = (pattern_block_t*)calloc((size_t)s->block_mask + 1, sizeof(pattern_block_t));
+        s->block_count = 0;
+        for (uint32_t i = 0; i < old_capacity; i++) {
+            if (old[i].used) *sink_block(s, old[i].x) = old[i];
+        }
+        free(old);
+    }
+    uint32_t h = (uint32_t)(((uint64_t)x * 0x9E3779B97F4A7C15ULL) >> 32) & s->block_mask;
+    while (s->blocks[h].used && s->blocks[h].x != x) h = (h + 1) & s->block_mask;
+    if (!s->blocks[h].used) {
+        memset(&s->blocks[h], 0, sizeof(pattern_block_t));
+        s->blocks[h].used = 1;
+        s->blocks[h].x = x;
+        s->block_count++;
+    }
+    return &s->blocks[h];
+}
+
+// Node for the size x size leaves of a block starting at leaf (lx, ly)
+static uint32_t sink_block_node(gol_hashlife_t *hl, const uint64_t *leaves, int lx, int ly, int size) {
+    if (size == 1) return gol_hashlife_leaf(hl, leaves[ly * 8 + lx]);
+    int half = size / 2;
+    uint32_t nw = sink_block_node(hl, leaves, lx,        ly,        half);
+    uint32_t ne = sink_block_node(hl, leaves, lx + half, ly,        half);
+    uint32_t sw = sink_block_node(hl, leaves, lx,        ly + half, half);
+    uint32_t se = sink_block_node(hl, leaves, lx + half, ly + half, half);
+    return gol_hashlife_node(hl, nw, ne, sw, se);
+}
+
+static void sink_hashlife_flush(pattern_sink_t *s) {
+    if (s->block_count == 0) return;
+    gol_hashlife_t *hl = s->target.hashlife;
+    for (uint32_t i = 0; i <= s->block_mask; i++) {
+        pattern_block_t *block = &s->blocks[i];
+        if (!block->used) continue;
+        gol_hashlife_place(hl, sink_block_node(hl, block->leaves, 0, 0, 8),
+                           block->x * ((int64_t)1 << GOL_PATTERN_BLOCK_LOG2),
+                           s->band * ((int64_t)1 << GOL_PATTERN_BLOCK_LOG2));
+        block->used = 0;
+    }
+    s->block_count = 0;
+}
+
+static void sink_hashlife_run(pattern_sink_t *s, int64_t x, int64_t y, int64_t length) {
+    int64_t band = y >> GOL_PATTERN_BLOCK_LOG2;
+    if (band != s->band) {
+        sink_hashlife_flush(s);
+        s->band = band;
+    }
+    int leaf_row = (int)((y >> 3) & 7) * 8;
+    int shift = (int)(y & 7) * 8;
+    pattern_block_t *block = NULL;
+    while (length > 0) {
+        if (!block || block->x != x >> GOL_PATTERN_BLOCK_LOG2) {
+            block = sink_block(s, x >> GOL_PATTERN_BLOCK_LOG2);
+        }
+        int bit = (int)(x & 7);
+        int count = (length < 8 - bit) ? (int)length : 8 - bit;
+        block->leaves[leaf_row + (int)((x >> 3) & 7)] |= (((1ULL << count) - 1) << bit) << shift;
+        x += count;
+        length -= count;
+    }
+}
+
+static void sink_init(pattern_sink_t *s, gol_pattern_target_t target) {
+    memset(s, 0, sizeof(*s));
+    s->target = target;
+    if (target.hashlife) {
+        s->block_mask = 63;
+        s->blocks = (pattern_block_t*)calloc(64, sizeof(pattern_block_t));
+    }
+}
+
+static void sink_run(pattern_sink_t *s, int64_t x, int64_t y, int64_t length) {
+    s->cells += (uint64_t)length;
+    if (s->target.bitgrid) {
+        sink_bitgrid_run(s->target.bitgrid, x, y, length);
+    } else if (s->target.chunks) {
+        gol_chunks_set_run(s->target.chunks, x, y, length);
+    } else {
+        sink_hashlife_run(s, x, y, length);
+    }
+}
+
+static void sink_finish(pattern_sink_t *s) {
+    if (s->target.hashlife) {
+        sink_hashlife_flush(s);
+        free(s->blocks);
+        s->blocks = NULL;
+    }
+    if (s->target.chunks) {
+        gol_chunks_mark_all_changed(s->target.chunks);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// RLE decoder: a character state machine, so input blocks may split anywhere
+// -----------------------------------------------------------------------------
+typedef struct {
+    pattern_sink_t *sink;
+    int64_t offset_x, offset_y;
+    int in_body;
+    int done;
+    char line[GOL_PATTERN_LINE_MAX];  // Header or comment line being collected
+    int line_len;                     // -1 when not inside such a line
+    int have_pos;
+    int64_t pos_x, pos_y;             // From "#CXRLE Pos="
+    int64_t width, height;
+    uint64_t generation;
+    int64_t count;                    // Pending run count
+    int64_t x, y;                     // Cursor relative to the top-left
+    int64_t origin_x, origin_y;
+} rle_decoder_t;
+
+// Parses an integer after optional blanks and '='; returns the characters
+// consumed so callers advance their own pointer
+static size_t rle_parse_int(const char *p, int64_t *value) {
+    size_t skip = 0;
+    while (p[skip] == ' ' || p[skip] == '\t' || p[skip] == '=') skip++;
+    char *end;
+    long long v = strtoll(p + skip, &end, 10);
+    if (end == p + skip) return skip;
+    *value = (int64_t)v;
+    return skip + (size_t)(end - (p + skip));
+}
+
+static void rle_header_line(rle_decoder_t *d) {
+    const char *line = d->line;
+    if (strncmp(line, "#CXRLE", 6) == 0) {
+        const char *pos = strstr(line, "Pos=");
+        if (pos) {
+            const char *p = pos + 4;
+            p += rle_parse_int(p, &d->pos_x);
+            if (*p == ',') {
+                rle_parse_int(p + 1, &d->pos_y);
+                d->have_pos = 1;
+            }
+        }
+        const char *gen = strstr(line, "Gen=");
+        if (gen) d->generation = strtoull(gen + 4, NULL, 10);
+    } else if (line[0] == 'x') {
+        const char *p = line + 1;
+        p += rle_parse_int(p, &d->width);
+        const char *h = strchr(p, 'y');
+        if (h != NULL) rle_parse_int(h + 1, &d->height);
+    }
+}
+
+static void rle_begin_body(rle_decoder_t *d) {
+    d->in_body = 1;
+    if (d->have_pos) {
+        d->origin_x = d->pos_x + d->offset_x;
+        d->origin_y = d->pos_y + d->offset_y;
+    } else {
+        d->origin_x = d->offset_x - d->width / 2;
+        d->origin_y = d->offset_y - d->height / 2;
+    }
+}
+
+static void rle_feed(rle_decoder_t *d, const char *data, size_t size) {
+    const char *p = data, *end = data + size;
+    while (p < end && !d->done) {
+        char c = *p++;
+        if (!d->in_body) {
+            if (d->line_len >= 0) {
+                if (c == '\n' || c == '\r') {
+                    d->line[d->line_len] = '\0';
+                    rle_header_line(d);
+                    d->line_len = -1;
+                } else if (d->line_len < GOL_PATTERN_LINE_MAX - 1) {
+                    d->line[d->line_len++] = c;
+                }
+                continue;
+            }
+            if (c == '#' || c == 'x') {
+                d->line[0] = c;
+                d->line_len = 1;
+                continue;
+            }
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') continue;
+            rle_begin_body(d);
+        }
+
+        if (c >= '0' && c <= '9') {
+            if (d->count < ((int64_t)1 << 50)) d->count = d->count * 10 + (c - '0');
+            continue;
+        }
+        int64_t n = d->count ? d->count : 1;
+        switch (c) {
+            case 'b': case '.':
+                d->x += n;
+                break;
+            case '$':
+                d->y += n;
+                d->x = 0;
+                break;
+            case '!':
+                d->done = 1;
+                break;
+            case ' ': case '\t': case '\n': case '\r':
+                continue;  // Whitespace does not end a pending count
+            default:
+                // 'o' and the multi-state letters are all alive
+                if (c == 'o' || (c >= 'A' && c <= 'X')) {
+                    sink_run(d->sink, d->origin_x + d->x, d->origin_y + d->y, n);
+                    d->x += n;
+                }
+                break;
+        }
+        d->count = 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Macrocell decoder: nodes are hash-consed straight into a HashLife table
+// -----------------------------------------------------------------------------
+typedef struct {
+    gol_hashlife_t *hl;
+    uint32_t *nodes;                  // Node of each numbered line
+    size_t count, capacity;
+    char line[GOL_PATTERN_LINE_MAX];  // Line split across input blocks
+    size_t line_len;
+    uint64_t generation;
+    char *error;
+} mc_decoder_t;
+
+static void mc_push(mc_decoder_t *d, uint32_t node) {
+    if (d->count == d->capacity) {
+        d->capacity = d->capacity ? d->capacity * 2 : 4096;
+        d->nodes = (uint32_t*)realloc(d->nodes, d->capacity * sizeof(uint32_t));
+    }
+    d->nodes[d->count++] = node;
+}
+
+static void mc_line(mc_decoder_t *d, const char *s, size_t n) {
+    while (n > 0 && (s[n - 1] == '\r' || s[n - 1] == ' ')) n--;
+    if (n == 0 || d->error[0]) return;
+    char c = s[0];
+
+    if (c == '#') {
+        if (n > 2 && s[1] == 'G') {
+            uint64_t gen = 0;
+            for (size_t i = 2; i < n; i++) {
+                if (s[i] >= '0' && s[i] <= '9') gen = gen * 10 + (uint64_t)(s[i] - '0');
+            }
+            d->generation = gen;
+        }
+        return;
+    }
+    if (c == '[') return;
+
+    if (c == '.' || c == '*' || c == '$') {
+        // 8x8 leaf, rows separated by '$', trailing dead cells omitted
+        uint64_t bits = 0;
+        int row = 0, col = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (s[i] == '$') { row++; col = 0; continue; }
+            if (row > 7 || col > 7) break;
+            if (s[i] == '*') bits |= 1ULL << (row * 8 + col);
+            col++;
+        }
+        mc_push(d, gol_hashlife_leaf(d->hl, bits));
+        return;
+    }
+
+    if (c >= '0' && c <= '9') {
+        // "level nw ne sw se", children are 1-based line numbers, 0 is empty
+        uint64_t v[5] = {0};
+        int field = 0;
+        size_t i = 0;
+        while (field < 5) {
+            while (i < n && s[i] == ' ') i++;
+            if (i >= n || s[i] < '0' || s[i] > '9') break;
+            while (i < n && s[i] >= '0' && s[i] <= '9') v[field] = v[field] * 10 + (uint64_t)(s[i++] - '0');
+            field++;
+        }
+        int level = (int)v[0];
+        if (field < 5 || level <= GOL_HL_LEAF_LEVEL || level > GOL_HL_MAX_LEVEL) {
+            snprintf(d->error, 128, "Macrocell: bad node on line %zu", d->count + 1);
+            return;
+        }
+        uint32_t q[4];
+        for (int k = 0; k < 4; k++) {
+            uint64_t ref = v[k + 1];
+            if (ref == 0) {
+                q[k] = d->hl->empty[level - 1];
+            } else if (ref <= d->count && d->hl->nodes[d->nodes[ref - 1]].level == level - 1) {
+                q[k] = d->nodes[ref - 1];
+            } else {
+                snprintf(d->error, 128, "Macrocell: bad child %llu on line %zu", (unsigned long long)ref, d->count + 1);
+                return;
+            }
+        }
+        mc_push(d, gol_hashlife_node(d->hl, q[0], q[1], q[2], q[3]));
+        return;
+    }
+    snprintf(d->error, 128, "Macrocell: unexpected '%c' on line %zu", c, d->count + 1);
+}
+
+static void mc_feed(mc_decoder_t *d, const char *data, size_t size) {
+    const char *p = data, *end = data + size;
+    while (p < end && !d->error[0]) {
+        const char *nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+        size_t n = (size_t)((nl ? nl : end) - p);
+        if (d->line_len > 0 || !nl) {
+            // Only lines split across blocks are copied
+            if (d->line_len + n > sizeof(d->line)) {
+                snprintf(d->error, 128, "Macrocell: line %zu too long", d->count + 1);
+                return;
+            }
+            memcpy(d->line + d->line_len, p, n);
+            d->line_len += n;
+            if (!nl) return;
+            mc_line(d, d->line, d->line_len);
+            d->line_len = 0;
+        } else {
+            mc_line(d, p, n);
+        }
+        p = nl + 1;
+    }
+}
+
+static void mc_emit(pattern_sink_t *s, const gol_hashlife_t *hl, uint32_t n, int64_t x, int64_t y) {
+    const gol_hl_node_t *node = &hl->nodes[n];
+    if (node->population == 0) return;
+    if (node->level == GOL_HL_LEAF_LEVEL) {
+        for (int r = 0; r < 8; r++) {
+            uint64_t row = (node->bits >> (r * 8)) & 0xFF;
+            while (row) {
+                int b = gol_ctz64(row);
+                int len = gol_ones_run(row >> b);
+                sink_run(s, x + b, y + r, len);
+                row &= ~(((1ULL << len) - 1) << b);
+            }
+        }
+        return;
+    }
+    int64_t half = (int64_t)1 << (node->level - 1);
+    uint32_t q[4];
+    memcpy(q, node->quad, sizeof(q));
+    mc_emit(s, hl, q[0], x,        y);
+    mc_emit(s, hl, q[1], x + half, y);
+    mc_emit(s, hl, q[2], x,        y + half);
+    mc_emit(s, hl, q[3], x + half, y + half);
+}
+
+// -----------------------------------------------------------------------------
+// Loading
+// -----------------------------------------------------------------------------
+typedef struct {
+    gol_pattern_stats_t *stats;
+    int64_t offset_x, offset_y;
+    int detected;
+    pattern_sink_t sink;
+    rle_decoder_t rle;
+    mc_decoder_t mc;
+    gol_hashlife_t scratch;           // Macrocell table for engines other than HashLife
+    uint64_t start;
+} pattern_loader_t;
+
+static void loader_begin(pattern_loader_t *l, gol_pattern_target_t target,
+                         int64_t offset_x, int64_t offset_y, gol_pattern_stats_t *stats) {
+    memset(l, 0, sizeof(*l));
+    memset(stats, 0, sizeof(*stats));
+    l->stats = stats;
+    l->offset_x = offset_x;
+    l->offset_y = offset_y;
+    l->start = stm_now();
+    sink_init(&l->sink, target);
+}
+
+static void loader_feed(pattern_loader_t *l, const char *data, size_t size) {
+    l->stats->bytes += size;
+    if (!l->detected) {
+        size_t i = 0;
+        while (i < size && (data[i] == ' ' || data[i] == '\t' || data[i] == '\r' || data[i] == '\n')) i++;
+        if (i == size) return;
+        l->detected = 1;
+        if (size - i >= 4 && memcmp(data + i, "[M2]", 4) == 0) {
+            l->stats->format = GOL_PATTERN_MACROCELL;
+            if (l->sink.target.hashlife) {
+                l->mc.hl = l->sink.target.hashlife;
+            } else {
+                gol_hashlife_create(&l->scratch);
+                l->mc.hl = &l->scratch;
+            }
+            l->mc.error = l->stats->error;
+        } else {
+            l->stats->format = GOL_PATTERN_RLE;
+            l->rle.sink = &l->sink;
+            l->rle.offset_x = l->offset_x;
+            l->rle.offset_y = l->offset_y;
+            l->rle.line_len = -1;
+        }
+    }
+    if (l->stats->format == GOL_PATTERN_MACROCELL) {
+        mc_feed(&l->mc, data, size);
+    } else {
+        rle_feed(&l->rle, data, size);
+    }
+}
+
+static int loader_end(pattern_loader_t *l) {
+    gol_pattern_stats_t *stats = l->stats;
+    if (l->detected && stats->format == GOL_PATTERN_MACROCELL) {
+        mc_decoder_t *d = &l->mc;
+        if (d->line_len > 0 && !stats->error[0]) {
+            mc_line(d, d->line, d->line_len);
+        }
+        if (!stats->error[0] && d->count > 0) {
+            uint32_t root = d->nodes[d->count - 1];
+            int level = d->hl->nodes[root].level;
+            int64_t extent = (int64_t)1 << (level < 62 ? level : 62);
+            int64_t x = l->offset_x - extent / 2;
+            int64_t y = l->offset_y - extent / 2;
+            stats->width = stats->height = extent;
+            if (d->hl == &l->scratch) {
+                mc_emit(&l->sink, d->hl, root, x, y);
+            } else {
+                stats->cells = d->hl->nodes[root].population;
+                gol_hashlife_place(d->hl, root, x, y);
+            }
+        }
+        stats->generation = d->generation;
+        free(d->nodes);
+        if (d->hl == &l->scratch) gol_hashlife_destroy(&l->scratch);
+    } else if (l->detected) {
+        stats->width = l->rle.width;
+        stats->height = l->rle.height;
+        stats->generation = l->rle.generation;
+    }
+    sink_finish(&l->sink);
+    if (l->sink.cells) stats->cells = l->sink.cells;
+
+    stats->seconds = stm_sec(stm_since(l->start));
+    stats->mb_per_s = (stats->seconds > 0.0) ? (double)stats->bytes / 1e6 / stats->seconds : 0.0;
+    return stats->error[0] == '\0';
+}
+
+int gol_pattern_load_memory(const char *data, size_t size, gol_pattern_target_t target,
+                            int64_t offset_x, int64_t offset_y, gol_pattern_stats_t *stats) {
+    pattern_loader_t loader;
+    loader_begin(&loader, target, offset_x, offset_y, stats);
+    loader_feed(&loader, data, size);
+    return loader_end(&loader);
+}
+
+int gol_pattern_load(const char *path, gol_pattern_target_t target,
+                     int64_t offset_x, int64_t offset_y, gol_pattern_stats_t *stats) {
+    pattern_loader_t loader;
+#if GOL_PATTERN_MMAP
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+            madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+            loader_begin(&loader, target, offset_x, offset_y, stats);
+            loader_feed(&loader, (const char*)map, (size_t)st.st_size);
+            int ok = loader_end(&loader);
+            munmap(map, (size_t)st.st_size);
+            close(fd);
+            return ok;
+        }
+    }
+    if (fd >= 0) close(fd);
+#endif
+    // Stream it in blocks instead
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        memset(stats, 0, sizeof(*stats));
+        snprintf(stats->error, sizeof(stats->error), "Cannot open %s", path);
+        return 0;
+    }
+    char *block = (char*)malloc(GOL_PATTERN_READ_BLOCK);
+    loader_begin(&loader, target, offset_x, offset_y, stats);
+    size_t n;
+    while (!stats->error[0] && (n = fread(block, 1, GOL_PATTERN_READ_BLOCK, f)) > 0) {
+        loader_feed(&loader, block, n);
+    }
+    free(block);
+    fclose(f);
+    return loader_end(&loader);
+}
+
+// -----------------------------------------------------------------------------
+// Writing
+// -----------------------------------------------------------------------------
+typedef struct {
+    FILE *f;
+    char buf[1 << 16];
+    size_t len;
+    uint64_t bytes;
+
+    // RLE state: the run being extended, and where the output cursor is
+    int64_t min_x, min_y;
+    int64_t run_x, run_y, run_end;
+    int run_open;
+    int64_t cur_x, cur_y;
+    int col;
+} pattern_writer_t;
+
+static void writer_put(pattern_writer_t *w, const char *s, size_t n) {
+    if (w->len + n > sizeof(w->buf)) {
+        fwrite(w->buf, 1, w->len, w->f);
+        w->len = 0;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+    w->bytes += n;
+}
+
+static void writer_printf(pattern_writer_t *w, const char *fmt, unsigned long long a,
+                          unsigned long long b, unsigned long long c, unsigned long long d,
+                          unsigned long long e) {
+    char tmp[128];
+    int n = snprintf(tmp, sizeof(tmp), fmt, a, b, c, d, e);
+    writer_put(w, tmp, (size_t)n);
+}
+
+static void rle_put(pattern_writer_t *w, int64_t count, char tag) {
+    // Digits are written backwards from the end of tmp; a count of 1 is implied
+    char tmp[24];
+    int start = (int)sizeof(tmp) - 1;
+    tmp[start] = tag;
+    if (count > 1) {
+        for (; count > 0; count /= 10) tmp[--start] = (char)('0' + count % 10);
+    }
+    int n = (int)sizeof(tmp) - start;
+    if (w->col + n > GOL_PATTERN_RLE_LINE) {
+        writer_put(w, "\n", 1);
+        w->col = 0;
+    }
+    writer_put(w, tmp + start, (size_t)n);
+    w->col += n;
+}
+
+static void rle_close_run(pattern_writer_t *w) {
+    if (!w->run_open) return;
+    int64_t x = w->run_x - w->min_x, y = w->run_y - w->min_y;
+    if (y > w->cur_y) {
+        rle_put(w, y - w->cur_y, '$');
+        w->cur_y = y;
+        w->cur_x = 0;
+    }
+    if (x > w->cur_x) rle_put(w, x - w->cur_x, 'b');
+    rle_put(w, w->run_end - w->run_x, 'o');
+    w->cur_x = w->run_end - w->min_x;
+    w->run_open = 0;
+}
+
+// Add the live cells of a 64-cell word starting at (x, y); words must come in
+// row-major order
+static void rle_word(pattern_writer_t *w, uint64_t bits, int64_t x, int64_t y) {
+    while (bits) {
+        int b = gol_ctz64(bits);
+        int len = gol_ones_run(bits >> b);
+        int64_t start = x + b;
+        if (w->run_open && w->run_y == y && w->run_end == start) {
+            w->run_end += len;
+        } else {
+            rle_close_run(w);
+            w->run_open = 1;
+            w->run_x = start;
+            w->run_y = y;
+            w->run_end = start + len;
+        }
+        bits &= (len + b >= 64) ? 0 : ~0ULL << (b + len);
+    }
+}
+
+static void rle_header(pattern_writer_t *w, int64_t x0, int64_t y0, int64_t x1, int64_t y1, uint64_t generation) {
+    char tmp[160];
+    int n = snprintf(tmp, sizeof(tmp), "#CXRLE Pos=%lld,%lld Gen=%llu\nx = %lld, y = %lld, rule = B3/S23\n",
+                     (long long)x0, (long long)y0, (unsigned long long)generation,
+                     (long long)(x1 - x0), (long long)(y1 - y0));
+    writer_put(w, tmp, (size_t)n);
+    w->min_x = x0;
+    w->min_y = y0;
+}
+
+static void rle_finish(pattern_writer_t *w) {
+    rle_close_run(w);
+    writer_put(w, "!\n", 2);
+}
+
+// Bounds of the live cells of a set of bit-packed rows
+typedef struct { int64_t x0, y0, x1, y1; } pattern_bounds_t;
+
+static void bounds_add_word(pattern_bounds_t *b, uint64_t bits, int64_t x, int64_t y) {
+    if (!bits) return;
+    int top = 63;
+    while (!(bits >> top)) top--;
+    int64_t lo = x + gol_ctz64(bits);
+    int64_t hi = x + top + 1;
+    if (lo < b->x0) b->x0 = lo;
+    if (hi > b->x1) b->x1 = hi;
+    if (y < b->y0) b->y0 = y;
+    if (y + 1 > b->y1) b->y1 = y + 1;
+}
+
+static void save_bitgrid(pattern_writer_t *w, const gol_bitgrid_t *grid, uint64_t generation) {
+    const int64_t half = grid->size / 2;
+    pattern_bounds_t b = { INT64_MAX, INT64_MAX, INT64_MIN, INT64_MIN };
+    for (int y = 0; y < grid->size; y++) {
+        const uint64_t *row = gol_bitgrid_row(grid, y);
+        for (int i = 0; i < grid->words; i++) bounds_add_word(&b, row[i], (int64_t)i * 64 - half, y - half);
+    }
+    if (b.x0 > b.x1) b.x0 = b.y0 = b.x1 = b.y1 = 0;
+    rle_header(w, b.x0, b.y0, b.x1, b.y1, generation);
+    for (int y = 0; y < grid->size; y++) {
+        const uint64_t *row = gol_bitgrid_row(grid, y);
+        for (int i = 0; i < grid->words; i++) rle_word(w, row[i], (int64_t)i * 64 - half, y - half);
+    }
+    rle_finish(w);
+}
+
+static int chunk_order(const void *a, const void *b) {
+    const gol_chunk_t *ca = *(const gol_chunk_t* const*)a, *cb = *(const gol_chunk_t* const*)b;
+    if (ca->cy != cb->cy) return (ca->cy < cb->cy) ? -1 : 1;
+    if (ca->cx != cb->cx) return (ca->cx < cb->cx) ? -1 : 1;
+    return 0;
+}
+
+static void save_chunks(pattern_writer_t *w, const gol_chunks_t *u, uint64_t generation) {
+    gol_chunk_t **sorted = (gol_chunk_t**)malloc((size_t)(u->chunk_count + 1) * sizeof(gol_chunk_t*));
+    memcpy(sorted, u->chunks, (size_t)u->chunk_count * sizeof(gol_chunk_t*));
+    qsort(sorted, (size_t)u->chunk_count, sizeof(gol_chunk_t*), chunk_order);
+
+    pattern_bounds_t b = { INT64_MAX, INT64_MAX, INT64_MIN, INT64_MIN };
+    for (int i = 0; i < u->chunk_count; i++) {
+        const gol_chunk_t *c = sorted[i];
+        for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+            bounds_add_word(&b, c->rows[y], (int64_t)c->cx * GOL_CHUNK_SIZE, (int64_t)c->cy * GOL_CHUNK_SIZE + y);
+        }
+    }
+    if (b.x0 > b.x1) b.x0 = b.y0 = b.x1 = b.y1 = 0;
+    rle_header(w, b.x0, b.y0, b.x1, b.y1, generation);
+
+    // One band of chunks (same cy) at a time, row by row across the band
+    for (int first = 0; first < u->chunk_count; ) {
+        int last = first;
+        while (last < u->chunk_count && sorted[last]->cy == sorted[first]->cy) last++;
+        for (int y = 0; y < GOL_CHUNK_SIZE; y++) {
+            for (int i = first; i < last; i++) {
+                const gol_chunk_t *c = sorted[i];
+                rle_word(w, c->rows[y], (int64_t)c->cx * GOL_CHUNK_SIZE, (int64_t)c->cy * GOL_CHUNK_SIZE + y);
+            }
+        }
+        first = last;
+    }
+    rle_finish(w);
+    free(sorted);
+}
+
+// Write node n after its children and return its 1-based line number (0 = empty)
+static uint32_t mc_write_node(pattern_writer_t *w, const gol_hashlife_t *hl, uint32_t n,
+                              uint32_t *ids, uint32_t *next_id) {
+    const gol_hl_node_t *node = &hl->nodes[n];
+    if (node->population == 0) return 0;
+    if (ids[n]) return ids[n];
+    if (node->level == GOL_HL_LEAF_LEVEL) {
+        char line[8 * 9 + 2];
+        size_t len = 0, kept = 0;
+        for (int r = 0; r < 8; r++) {
+            uint64_t row = (node->bits >> (r * 8)) & 0xFF;
+            for (int x = 0; row >> x; x++) line[len++] = ((row >> x) & 1) ? '*' : '.';
+            line[len++] = '$';
+            if (row) kept = len;
+        }
+        line[kept++] = '\n';
+        writer_put(w, line, kept);
+    } else {
+        uint32_t q[4];
+        for (int i = 0; i < 4; i++) q[i] = mc_write_node(w, hl, node->quad[i], ids, next_id);
+        writer_printf(w, "%llu %llu %llu %llu %llu\n", node->level, q[0], q[1], q[2], q[3]);
+    }
+    ids[n] = ++*next_id;
+    return ids[n];
+}
+
+static void save_hashlife(pattern_writer_t *w, const gol_hashlife_t *hl, uint64_t generation) {
+    static const char header[] = "[M2] (simulations)\n#R B3/S23\n";
+    writer_put(w, header, sizeof(header) - 1);
+    writer_printf(w, "#G %llu\n", generation, 0, 0, 0, 0);
+    uint32_t *ids = (uint32_t*)calloc(hl->node_high, sizeof(uint32_t));
+    uint32_t next_id = 0;
+    mc_write_node(w, hl, hl->root, ids, &next_id);
+    free(ids);
+}
+
+int gol_pattern_save(const char *path, gol_pattern_target_t source, uint64_t generation,
+                     gol_pattern_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    uint64_t start = stm_now();
+    pattern_writer_t *w = (pattern_writer_t*)calloc(1, sizeof(pattern_writer_t));
+    w->f = fopen(path, "wb");
+    if (!w->f) {
+        snprintf(stats->error, sizeof(stats->error), "Cannot create %s", path);
+        free(w);
+        return 0;
+    }
+    if (source.hashlife) {
+        stats->format = GOL_PATTERN_MACROCELL;
+        stats->cells = gol_hashlife_population(source.hashlife);
+        save_hashlife(w, source.hashlife, generation);
+    } else if (source.chunks) {
+        stats->cells = source.chunks->population;
+        save_chunks(w, source.chunks, generation);
+    } else {
+        save_bitgrid(w, source.bitgrid, generation);
+    }
+    fwrite(w->buf, 1, w->len, w->f);
+    if (fclose(w->f) != 0) {
+        snprintf(stats->error, sizeof(stats->error), "Error writing %s", path);
+    }
+    stats->bytes = w->bytes;
+    stats->generation = generation;
+    stats->seconds = stm_sec(stm_since(start));
+    stats->mb_per_s = (stats->seconds > 0.0) ? (double)stats->bytes / 1e6 / stats->seconds : 0.0;
+    free(w);
+    return stats->error[0] == '\0';
+}
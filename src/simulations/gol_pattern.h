@@ -0,0 +1,62 @@
+#ifndef GOL_PATTERN_H
+#define GOL_PATTERN_H
+
+#include "gol_bitgrid.h"
+#include "gol_hashlife.h"
+#include "gol_chunks.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Game of Life pattern files: RLE and Macrocell
+//
+// Files are memory-mapped where the platform allows it (read in large blocks
+// otherwise) and fed through incremental decoders that write straight into
+// the engine: RLE runs become row bits, Macrocell nodes become HashLife nodes
+// in the target table. Nothing of the pattern is copied on the way except
+// the Macrocell line -> node index map.
+//
+// Coordinates follow the engines: (0, 0) is the center of the torus, and the
+// origin of the unbounded universes. RLE files are centered on the origin
+// unless they carry a "#CXRLE Pos=x,y" line; Macrocell roots are centered on
+// it. The placement offset is added to either.
+// -----------------------------------------------------------------------------
+
+typedef enum {
+    GOL_PATTERN_RLE,
+    GOL_PATTERN_MACROCELL,
+} gol_pattern_format_t;
+
+// Engine the cells are decoded into (or saved from); set exactly one
+typedef struct gol_pattern_target_t {
+    gol_bitgrid_t *bitgrid;      // Cells wrap around the torus
+    gol_hashlife_t *hashlife;
+    gol_chunks_t *chunks;
+} gol_pattern_target_t;
+
+typedef struct gol_pattern_stats_t {
+    gol_pattern_format_t format;
+    uint64_t bytes;
+    uint64_t cells;              // Live cells written
+    int64_t width, height;       // Header size (RLE) or root extent (Macrocell)
+    uint64_t generation;         // From "#CXRLE Gen=" or "#G", else 0
+    double seconds;
+    double mb_per_s;
+    char error[128];             // Empty on success
+} gol_pattern_stats_t;
+
+// Decode a file (format detected from its first line) into the target,
+// adding its cells to what is already there. Returns 1 on success.
+int gol_pattern_load(const char *path, gol_pattern_target_t target,
+                     int64_t offset_x, int64_t offset_y, gol_pattern_stats_t *stats);
+
+// Same for a buffer that is already in memory
+int gol_pattern_load_memory(const char *data, size_t size, gol_pattern_target_t target,
+                            int64_t offset_x, int64_t offset_y, gol_pattern_stats_t *stats);
+
+// Save the target's current state: Macrocell for HashLife, RLE otherwise.
+// Returns 1 on success.
+int gol_pattern_save(const char *path, gol_pattern_target_t source, uint64_t generation,
+                     gol_pattern_stats_t *stats);
+
+#endif /* GOL_PATTERN_H */
@@ -0,0 +1,232 @@
+#include "gpu_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    GPU_CACHE_SHADER,
+    GPU_CACHE_PIPELINE,
+    GPU_CACHE_SAMPLER,
+    GPU_CACHE_ATTACHMENTS,
+    GPU_CACHE_IMAGE,
+} gpu_cache_kind_t;
+
+typedef struct gpu_cache_entry_t {
+    gpu_cache_kind_t kind;
+    uint64_t hash;
+    void *key;                   // Canonical copy of the descriptor
+    size_t key_size;
+    uint32_t id;
+    int in_use;                  // Images: acquired and not yet released
+    uint64_t released_at;        // Images: release order, for trimming
+} gpu_cache_entry_t;
+
+static struct {
+    gpu_cache_entry_t *entries;
+    int count;
+    int capacity;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t release_clock;
+} gpu_cache;
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+#define GPU_CACHE_FNV_OFFSET 0xCBF29CE484222325ULL
+#define GPU_CACHE_FNV_PRIME 0x100000001B3ULL
+
+static uint64_t gpu_cache_hash(uint64_t h, const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ p[i]) * GPU_CACHE_FNV_PRIME;
+    }
+    return h;
+}
+
+static uint64_t gpu_cache_hash_str(uint64_t h, const char *s) {
+    return s ? gpu_cache_hash(h, s, strlen(s) + 1) : gpu_cache_hash(h, "", 1);
+}
+
+// Entry of a kind with this key; free_only restricts the search to
+// released images
+static int gpu_cache_find(gpu_cache_kind_t kind, const void *key, size_t key_size, uint64_t hash, int free_only) {
+    for (int i = 0; i < gpu_cache.count; i++) {
+        const gpu_cache_entry_t *e = &gpu_cache.entries[i];
+        if (e->kind == kind && e->hash == hash && e->key_size == key_size &&
+            (!free_only || !e->in_use) && memcmp(e->key, key, key_size) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void gpu_cache_insert(gpu_cache_kind_t kind, const void *key, size_t key_size, uint64_t hash, uint32_t id) {
+    if (gpu_cache.count == gpu_cache.capacity) {
+        gpu_cache.capacity = gpu_cache.capacity ? 2 * gpu_cache.capacity : 32;
+        gpu_cache.entries = (gpu_cache_entry_t*)realloc(gpu_cache.entries, (size_t)gpu_cache.capacity * sizeof(gpu_cache_entry_t));
+    }
+    gpu_cache_entry_t *e = &gpu_cache.entries[gpu_cache.count++];
+    e->kind = kind;
+    e->hash = hash;
+    e->key = malloc(key_size);
+    memcpy(e->key, key, key_size);
+    e->key_size = key_size;
+    e->id = id;
+    e->in_use = (kind == GPU_CACHE_IMAGE);
+    e->released_at = 0;
+}
+
+static void gpu_cache_destroy_entry(const gpu_cache_entry_t *e) {
+    switch (e->kind) {
+        case GPU_CACHE_SHADER:      sg_destroy_shader((sg_shader){ e->id }); break;
+        case GPU_CACHE_PIPELINE:    sg_destroy_pipeline((sg_pipeline){ e->id }); break;
+        case GPU_CACHE_SAMPLER:     sg_destroy_sampler((sg_sampler){ e->id }); break;
+        case GPU_CACHE_ATTACHMENTS: sg_destroy_attachments((sg_attachments){ e->id }); break;
+        case GPU_CACHE_IMAGE:       sg_destroy_image((sg_image){ e->id }); break;
+    }
+}
+
+static void gpu_cache_remove(int index) {
+    gpu_cache_destroy_entry(&gpu_cache.entries[index]);
+    free(gpu_cache.entries[index].key);
+    gpu_cache.entries[index] = gpu_cache.entries[--gpu_cache.count];
+}
+
+static int gpu_cache_attachments_use(const sg_attachments_desc *desc, uint32_t image_id) {
+    for (int i = 0; i < SG_MAX_COLOR_ATTACHMENTS; i++) {
+        if (desc->colors[i].image.id == image_id || desc->resolves[i].image.id == image_id) return 1;
+    }
+    return desc->depth_stencil.image.id == image_id;
+}
+
+// Destroy the least recently released image, and the attachments using it,
+// while too many released images are kept
+static void gpu_cache_trim_images(void) {
+    for (;;) {
+        int free_count = 0, oldest = -1;
+        for (int i = 0; i < gpu_cache.count; i++) {
+            const gpu_cache_entry_t *e = &gpu_cache.entries[i];
+            if (e->kind != GPU_CACHE_IMAGE || e->in_use) continue;
+            free_count++;
+            if (oldest < 0 || e->released_at < gpu_cache.entries[oldest].released_at) oldest = i;
+        }
+        if (free_count <= SIM_GPU_CACHE_FREE_IMAGES) return;
+
+        uint32_t image_id = gpu_cache.entries[oldest].id;
+        for (int i = gpu_cache.count - 1; i >= 0; i--) {
+            const gpu_cache_entry_t *e = &gpu_cache.entries[i];
+            if (e->kind == GPU_CACHE_ATTACHMENTS && gpu_cache_attachments_use((const sg_attachments_desc*)e->key, image_id)) {
+                gpu_cache_remove(i);
+            }
+        }
+        for (int i = 0; i < gpu_cache.count; i++) {
+            if (gpu_cache.entries[i].kind == GPU_CACHE_IMAGE && gpu_cache.entries[i].id == image_id) {
+                gpu_cache_remove(i);
+                break;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Shared objects
+// -----------------------------------------------------------------------------
+// Id of the cached object for a key (0 on a miss), counting hits and misses
+static uint32_t gpu_cache_lookup(gpu_cache_kind_t kind, const void *key, size_t key_size, uint64_t hash) {
+    int i = gpu_cache_find(kind, key, key_size, hash, 0);
+    if (i < 0) {
+        gpu_cache.misses++;
+        return 0;
+    }
+    gpu_cache.hits++;
+    return gpu_cache.entries[i].id;
+}
+
+sg_shader sim_gpu_shader(const sg_shader_desc *desc) {
+    // The sources are hashed by content, not by pointer
+    sg_shader_desc key = *desc;
+    key.vertex_func.source = NULL;
+    key.fragment_func.source = NULL;
+    uint64_t hash = gpu_cache_hash(GPU_CACHE_FNV_OFFSET, &key, sizeof(key));
+    hash = gpu_cache_hash_str(hash, desc->vertex_func.source);
+    hash = gpu_cache_hash_str(hash, desc->fragment_func.source);
+    uint32_t id = gpu_cache_lookup(GPU_CACHE_SHADER, &key, sizeof(key), hash);
+    if (id) return (sg_shader){ id };
+    sg_shader shader = sg_make_shader(desc);
+    gpu_cache_insert(GPU_CACHE_SHADER, &key, sizeof(key), hash, shader.id);
+    return shader;
+}
+
+sg_pipeline sim_gpu_pipeline(const sg_pipeline_desc *desc) {
+    uint64_t hash = gpu_cache_hash(GPU_CACHE_FNV_OFFSET, desc, sizeof(*desc));
+    uint32_t id = gpu_cache_lookup(GPU_CACHE_PIPELINE, desc, sizeof(*desc), hash);
+    if (id) return (sg_pipeline){ id };
+    sg_pipeline pip = sg_make_pipeline(desc);
+    gpu_cache_insert(GPU_CACHE_PIPELINE, desc, sizeof(*desc), hash, pip.id);
+    return pip;
+}
+
+sg_sampler sim_gpu_sampler(const sg_sampler_desc *desc) {
+    uint64_t hash = gpu_cache_hash(GPU_CACHE_FNV_OFFSET, desc, sizeof(*desc));
+    uint32_t id = gpu_cache_lookup(GPU_CACHE_SAMPLER, desc, sizeof(*desc), hash);
+    if (id) return (sg_sampler){ id };
+    sg_sampler smp = sg_make_sampler(desc);
+    gpu_cache_insert(GPU_CACHE_SAMPLER, desc, sizeof(*desc), hash, smp.id);
+    return smp;
+}
+
+sg_attachments sim_gpu_attachments(const sg_attachments_desc *desc) {
+    uint64_t hash = gpu_cache_hash(GPU_CACHE_FNV_OFFSET, desc, sizeof(*desc));
+    uint32_t id = gpu_cache_lookup(GPU_CACHE_ATTACHMENTS, desc, sizeof(*desc), hash);
+    if (id) return (sg_attachments){ id };
+    sg_attachments atts = sg_make_attachments(desc);
+    gpu_cache_insert(GPU_CACHE_ATTACHMENTS, desc, sizeof(*desc), hash, atts.id);
+    return atts;
+}
+
+// -----------------------------------------------------------------------------
+// Pooled images
+// -----------------------------------------------------------------------------
+sg_image sim_gpu_image_acquire(const sg_image_desc *desc) {
+    uint64_t hash = gpu_cache_hash(GPU_CACHE_FNV_OFFSET, desc, sizeof(*desc));
+    int i = gpu_cache_find(GPU_CACHE_IMAGE, desc, sizeof(*desc), hash, 1);
+    if (i >= 0) {
+        gpu_cache.hits++;
+        gpu_cache.entries[i].in_use = 1;
+        return (sg_image){ gpu_cache.entries[i].id };
+    }
+    gpu_cache.misses++;
+    sg_image image = sg_make_image(desc);
+    gpu_cache_insert(GPU_CACHE_IMAGE, desc, sizeof(*desc), hash, image.id);
+    return image;
+}
+
+void sim_gpu_image_release(sg_image image) {
+    for (int i = 0; i < gpu_cache.count; i++) {
+        gpu_cache_entry_t *e = &gpu_cache.entries[i];
+        if (e->kind == GPU_CACHE_IMAGE && e->id == image.id && e->in_use) {
+            e->in_use = 0;
+            e->released_at = ++gpu_cache.release_clock;
+            gpu_cache_trim_images();
+            return;
+        }
+    }
+}
+
+void sim_gpu_cache_stats(sim_gpu_cache_stats_t *stats) {
+    stats->objects = gpu_cache.count;
+    stats->hits = gpu_cache.hits;
+    stats->misses = gpu_cache.misses;
+}
+
+void sim_gpu_cache_shutdown(void) {
+    // Attachments before the images they use
+    for (int i = gpu_cache.count - 1; i >= 0; i--) {
+        if (gpu_cache.entries[i].kind == GPU_CACHE_ATTACHMENTS) gpu_cache_remove(i);
+    }
+    while (gpu_cache.count > 0) {
+        gpu_cache_remove(gpu_cache.count - 1);
+    }
+    free(gpu_cache.entries);
+    memset(&gpu_cache, 0, sizeof(gpu_cache));
+}
@@ -0,0 +1,47 @@
+#ifndef GPU_CACHE_H
+#define GPU_CACHE_H
+
+#include "sokol_gfx.h"
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// GPU resource cache shared by all simulations
+//
+// Shaders, pipelines, samplers and attachments are immutable once made, so
+// they are keyed by their descriptor and shared: a simulation that asks for
+// the same descriptor again (after a reset or a switch back) gets the
+// object compiled the first time. The cache owns them; callers never
+// destroy them. Shader keys hash the GLSL source text itself, the other
+// descriptors are compared byte for byte, so a descriptor that differs
+// only in padding costs a duplicate object, never a wrong one.
+//
+// Images are written to (render targets, dynamic textures), so they are
+// pooled rather than shared: acquire hands out an unused image made from
+// the same descriptor, or a new one, and release puts it back. Only images
+// without initial data can be pooled. At most SIM_GPU_CACHE_FREE_IMAGES
+// released images are kept; beyond that the least recently released one is
+// destroyed along with the attachments that use it.
+//
+// Everything is destroyed by sim_gpu_cache_shutdown, before sg_shutdown.
+// -----------------------------------------------------------------------------
+
+#define SIM_GPU_CACHE_FREE_IMAGES 8
+
+typedef struct sim_gpu_cache_stats_t {
+    int objects;
+    uint64_t hits;
+    uint64_t misses;
+} sim_gpu_cache_stats_t;
+
+sg_shader sim_gpu_shader(const sg_shader_desc *desc);
+sg_pipeline sim_gpu_pipeline(const sg_pipeline_desc *desc);
+sg_sampler sim_gpu_sampler(const sg_sampler_desc *desc);
+sg_attachments sim_gpu_attachments(const sg_attachments_desc *desc);
+
+sg_image sim_gpu_image_acquire(const sg_image_desc *desc);
+void sim_gpu_image_release(sg_image image);
+
+void sim_gpu_cache_stats(sim_gpu_cache_stats_t *stats);
+void sim_gpu_cache_shutdown(void);
+
+#endif /* GPU_CACHE_H */
@@ -1,5 +1,14 @@
 #include "ising.h"
 #include "simulations.h"
+#include "ising_lattice.h"
+#include "ising_msc.h"
+#include "ising_cluster.h"
+#include "ising_tempering.h"
+#include "rng.h"
+#include "estimator.h"
+#include "sokol_time.h"
+#ifndef SIM_HEADLESS
+#include "lattice_view.h"
 #ifndef CIMGUI_DEFINE_ENUMS_AND_STRUCTS
     #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #endif
@@ -9,8 +18,10 @@
 #include "sokol_app.h"
 #include "./util/sokol_imgui.h"
 #include "sokol_glue.h"
+#endif
+#include <assert.h>
 #include <stdlib.h>
-#include <time.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -26,223 +37,632 @@ static int ising_grid_size = 64;         // Current grid size
 static int ising_grid_size_new = 64;     // Parameter for grid size (modifiable via UI)
 static float ising_temperature = 2.5f;     // Temperature parameter
 
-// Lattice: each cell is either +1 or -1.
-static int *ising_grid = NULL;           
+// Lattice: each cell is either +1 or -1, stored by checkerboard color as
+// int8 (see ising_lattice.h), as bits, 64 spins per word (see ising_msc.h),
+// or as a contiguous ensemble of int8 replicas (see ising_tempering.h)
+typedef enum { ISING_STORAGE_INT8, ISING_STORAGE_MSC, ISING_STORAGE_TEMPERING } ising_storage_t;
+static ising_lattice_t ising_grid;
+static ising_msc_t ising_msc;
+static ising_tempering_t ising_pt;
+static ising_storage_t ising_storage = ISING_STORAGE_INT8; // Which one holds the current lattice
+#define ISING_INT8_MAX_SIZE 4096         // Larger lattices need multi-spin coding
+#define ISING_TEMPERING_MAX_SIZE 1024    // Per replica
+#define ISING_VERIFY_INTERVAL 256        // Sweeps between debug recounts of E and M
+
+// Update schemes: the whole lattice color by color, random sites one at a
+// time, the multi-spin coded checkerboard, cluster flips (see
+// ising_cluster.h), or replica exchange over a temperature ladder. Switching
+// between schemes with different storage restarts the lattice.
+typedef enum {
+    ISING_UPDATE_CHECKERBOARD,
+    ISING_UPDATE_RANDOM,
+    ISING_UPDATE_MULTISPIN,
+    ISING_UPDATE_WOLFF,
+    ISING_UPDATE_SWENDSEN_WANG,
+    ISING_UPDATE_TEMPERING,
+    ISING_UPDATE_COUNT
+} ising_update_t;
+static int ising_update_mode = ISING_UPDATE_CHECKERBOARD;
+static ising_cluster_t ising_clusters;   // Work buffers for the cluster updates
+
+// Parallel tempering ladder; the Temperature slider picks the replica shown
+static int ising_pt_replicas = 16;
+static float ising_pt_t_min = 1.8f;
+static float ising_pt_t_max = 3.0f;
+static int ising_pt_swap_interval = 1;   // Sweeps between swap attempts
+
+// Integrated autocorrelation time of the energy, in sweeps, last measured
+// with each update scheme over the samples since it was selected
+static float ising_tau[ISING_UPDATE_COUNT];
+static int ising_mode_samples = 0;
+#define ISING_TAU_INTERVAL 32            // Samples between estimates
 
-// Texture and sampler for rendering the lattice
-static sg_image ising_image;
-static sg_sampler ising_sampler;
-static unsigned char *ising_pixels = NULL; // Pixel buffer for texture update
+// Streaming estimates at the current temperature and scheme (see
+// estimator.h). Samples are taken every ising_measure_interval sweeps; in
+// auto mode the interval starts at 1 and doubles, restarting the estimates,
+// for as long as the recorded samples stay correlated, so the series and the
+// estimators only get samples that carry new information. Otherwise it is
+// the Measurement Interval slider's.
+enum {
+    ISING_EST_ENERGY,                    // E / N
+    ISING_EST_ENERGY2,
+    ISING_EST_ABS_MAG,                   // |M| / N
+    ISING_EST_MAG2,
+    ISING_EST_MAG4,
+    ISING_EST_COUNT
+};
+static sim_estimator_t ising_estimator;
+static float ising_estimator_temperature = -1.0f; // Temperature the estimates belong to
+static bool ising_auto_interval = true;
+static int ising_interval_setting = 1;   // Slider value for manual mode
+static int ising_measure_interval = 1;   // Sweeps between samples
+static int ising_sweeps_since_sample = 0;
+#define ISING_INTERVAL_CHECK 512         // Samples between checks of the interval
+#define ISING_MAX_INTERVAL 1024
+
+// Smoothed cost of a sweep, for the flips-per-second readout
+static double ising_sweep_ms = 0.0;
+
+// R8 state texture for rendering the lattice, colored on the GPU. The texels
+// are published with each snapshot; render sizes the view to match.
+#ifndef SIM_HEADLESS
+static lattice_view_t ising_lattice;
+static uint64_t ising_lattice_sequence = 0; // Snapshot last uploaded
+#endif
+#define ISING_MAX_TEXTURE_SIZE 1024
+static int ising_texture_size = 0;
+static int ising_texture_block = 1;      // Spins per texel side
 
 // Plot data for energy and magnetization versus time
-#define ISING_BUFFER_LEN 600
-static float ising_time_data[ISING_BUFFER_LEN];
-static float ising_energy_data[ISING_BUFFER_LEN];
-static float ising_mag_data[ISING_BUFFER_LEN];
-static int ising_data_count = 0;
-static float ising_sim_time = 0.0f;
-
-// Simulation parameters: grid size and temperature
-static sim_parameter_t ising_params[] = {
-    { "Grid Size",   &ising_grid_size_new, SIM_PARAM_INT,   0, 0, 16, 128 },
-    { "Temperature", &ising_temperature,   SIM_PARAM_FLOAT, 0.5f, 5.0f, 0, 0 }
+enum { ISING_SERIES_ENERGY, ISING_SERIES_MAG, ISING_SERIES_COUNT };
+static sim_series_t ising_series;
+static double ising_sim_time = 0.0;
+
+// Every setting by name (see simulations.h), also drawn by the parameters
+// UI; Update is ISING_UPDATE_*. The grid size, update scheme and ladder take
+// effect on init.
+enum {
+    ISING_SETTING_GRID_SIZE, ISING_SETTING_TEMPERATURE, ISING_SETTING_UPDATE,
+    ISING_SETTING_AUTO_INTERVAL, ISING_SETTING_INTERVAL,
+    ISING_SETTING_PT_REPLICAS, ISING_SETTING_PT_T_MIN, ISING_SETTING_PT_T_MAX, ISING_SETTING_PT_SWAP,
+    ISING_SETTING_COUNT
+};
+static sim_parameter_t ising_settings[ISING_SETTING_COUNT] = {
+    [ISING_SETTING_GRID_SIZE]     = { "Grid Size",                 &ising_grid_size_new,    SIM_PARAM_INT,   0, 0, 16, 16384 },
+    [ISING_SETTING_TEMPERATURE]   = { "Temperature",               &ising_temperature,      SIM_PARAM_FLOAT, 0.5f, 5.0f, 0, 0 },
+    [ISING_SETTING_UPDATE]        = { "Update",                    &ising_update_mode,      SIM_PARAM_INT,   0, 0, 0, ISING_UPDATE_COUNT - 1 },
+    [ISING_SETTING_AUTO_INTERVAL] = { "Auto Measurement Interval", &ising_auto_interval,    SIM_PARAM_BOOL,  0, 0, 0, 0 },
+    [ISING_SETTING_INTERVAL]      = { "Measurement Interval",      &ising_interval_setting, SIM_PARAM_INT,   0, 0, 1, ISING_MAX_INTERVAL },
+    [ISING_SETTING_PT_REPLICAS]   = { "Replicas",                  &ising_pt_replicas,      SIM_PARAM_INT,   0, 0, 2, ISING_TEMPERING_MAX_REPLICAS },
+    [ISING_SETTING_PT_T_MIN]      = { "T Min",                     &ising_pt_t_min,         SIM_PARAM_FLOAT, 0.5f, 5.0f, 0, 0 },
+    [ISING_SETTING_PT_T_MAX]      = { "T Max",                     &ising_pt_t_max,         SIM_PARAM_FLOAT, 0.5f, 5.0f, 0, 0 },
+    [ISING_SETTING_PT_SWAP]       = { "Swap Interval",             &ising_pt_swap_interval, SIM_PARAM_INT,   0, 0, 1, 100 }
 };
 
-// -----------------------------------------------------------------------------
-// Helper: Compute periodic index
-// -----------------------------------------------------------------------------
-static inline int mod(int a, int b) {
-    return (a % b + b) % b;
+static ising_storage_t ising_storage_for(int mode) {
+    switch (mode) {
+        case ISING_UPDATE_MULTISPIN: return ISING_STORAGE_MSC;
+        case ISING_UPDATE_TEMPERING: return ISING_STORAGE_TEMPERING;
+        default:                     return ISING_STORAGE_INT8;
+    }
+}
+
+// Temperature of the lattice being measured: the rung nearest the slider in
+// tempering mode, else the slider's
+static float ising_measured_temperature(void) {
+    if (ising_storage == ISING_STORAGE_TEMPERING) {
+        return ising_pt.temperatures[ising_tempering_nearest_slot(&ising_pt, ising_temperature)];
+    }
+    return ising_temperature;
+}
+
+// Forget the estimates, e.g. when the temperature or update scheme changes
+static void ising_restart_estimates(void) {
+    sim_estimator_clear(&ising_estimator);
+    ising_estimator_temperature = ising_measured_temperature();
+    ising_mode_samples = 0;
+    ising_sweeps_since_sample = 0;
+    ising_measure_interval = ising_auto_interval ? 1 : ising_interval_setting;
+}
+
+// Lattice on screen: the replica currently at the temperature nearest the
+// slider in tempering mode, else the only one
+static const ising_lattice_t *ising_shown_lattice(void) {
+    if (ising_storage == ISING_STORAGE_TEMPERING) {
+        int slot = ising_tempering_nearest_slot(&ising_pt, ising_temperature);
+        return &ising_pt.replicas[ising_pt.replica_at[slot]];
+    }
+    return &ising_grid;
+}
+
+// Total energy and magnetization of the lattice on screen, kept up to date by
+// the updates themselves
+static void ising_totals(int64_t *energy, int64_t *total_spin) {
+    if (ising_storage == ISING_STORAGE_MSC) {
+        *energy = ising_msc.energy;
+        *total_spin = ising_msc.magnetization;
+    } else {
+        const ising_lattice_t *lat = ising_shown_lattice();
+        *energy = lat->energy;
+        *total_spin = lat->magnetization;
+    }
 }
 
 // -----------------------------------------------------------------------------
-// Initialization: allocate the lattice, set initial spins, and create texture
+// Initialization: allocate the lattice and set initial spins. Simulation state
+// only, so resets can run on the simulation thread; the texture is sized in
+// render.
 // -----------------------------------------------------------------------------
-void sim_ising_init(void) {
-    // Use new grid size if changed
-    ising_grid_size = ising_grid_size_new;
-    
-    // Allocate lattice array (size: grid_size x grid_size)
-    ising_grid = (int*)malloc(ising_grid_size * ising_grid_size * sizeof(int));
-    
-    // Initialize lattice with random spins (+1 or -1)
-    srand((unsigned int)time(NULL));
-    for (int i = 0; i < ising_grid_size * ising_grid_size; i++) {
-        ising_grid[i] = (rand() % 2) ? 1 : -1;
+static void ising_create(void) {
+    // Allocate the lattice with random spins (+1 or -1); the checkerboard
+    // needs an even size, multi-spin coding a multiple of 128
+    ising_storage = ising_storage_for(ising_update_mode);
+    if (ising_storage == ISING_STORAGE_MSC) {
+        ising_msc_create(&ising_msc, ising_grid_size_new, sim_rng_seed());
+        ising_grid_size = ising_msc.size;
+    } else if (ising_storage == ISING_STORAGE_TEMPERING) {
+        int size = ising_grid_size_new < ISING_TEMPERING_MAX_SIZE ? ising_grid_size_new : ISING_TEMPERING_MAX_SIZE;
+        ising_tempering_create(&ising_pt, size, ising_pt_replicas, ising_pt_t_min, ising_pt_t_max, sim_rng_seed());
+        ising_grid_size = ising_pt.size;
+    } else {
+        int size = ising_grid_size_new < ISING_INT8_MAX_SIZE ? ising_grid_size_new : ISING_INT8_MAX_SIZE;
+        ising_lattice_create(&ising_grid, size, sim_rng_seed());
+        ising_grid_size = ising_grid.size;
+        ising_cluster_create(&ising_clusters, ising_grid_size, sim_rng_seed());
     }
-    
-    // Reset simulation time and plot data count, and clear time series arrays
-    ising_sim_time = 0.0f;
-    ising_data_count = 0;
-    for (int i = 0; i < ISING_BUFFER_LEN; i++) {
-        ising_time_data[i] = 0.0f;
-        ising_energy_data[i] = 0.0f;
-        ising_mag_data[i] = 0.0f;
+    ising_sweep_ms = 0.0;
+    // Only the schemes on the rebuilt lattice lose their tau; the others were
+    // measured on lattices this one does not replace
+    for (int i = 0; i < ISING_UPDATE_COUNT; i++) {
+        if (ising_storage_for(i) == ising_storage) {
+            ising_tau[i] = 0.0f;
+        }
     }
+    sim_estimator_init(&ising_estimator, ISING_EST_COUNT);
+    ising_restart_estimates();
     
-    // Create a dynamic texture whose dimensions match the lattice
-    ising_image = sg_make_image(&(sg_image_desc){
-        .width = ising_grid_size,
-        .height = ising_grid_size,
-        .pixel_format = SG_PIXELFORMAT_RGBA8,
-        .usage = SG_USAGE_DYNAMIC,
-    });
+    // Reset simulation time and the recorded time series
+    ising_sim_time = 0.0;
+    sim_series_init(&ising_series, ISING_SERIES_COUNT);
     
-    // Create a sampler with nearest filtering for a sharp pixel look
-    ising_sampler = sg_make_sampler(&(sg_sampler_desc){
-        .min_filter = SG_FILTER_NEAREST,
-        .mag_filter = SG_FILTER_NEAREST,
-        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
-        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
-    });
-    
-    // Allocate pixel buffer (4 bytes per cell: RGBA)
-    ising_pixels = (unsigned char*)malloc(ising_grid_size * ising_grid_size * 4);
+    // State texture: -1 is blue, +1 is red. Large lattices are reduced by the
+    // smallest power-of-two block that keeps the texture in bounds.
+    ising_texture_block = 1;
+    while (ising_grid_size / ising_texture_block > ISING_MAX_TEXTURE_SIZE) {
+        ising_texture_block *= 2;
+    }
+    ising_texture_size = (ising_grid_size + ising_texture_block - 1) / ising_texture_block;
 }
 
 // -----------------------------------------------------------------------------
-// Destroy: free allocated arrays and GPU resources
+// Destroy: free allocated arrays, and GPU resources with the simulation
 // -----------------------------------------------------------------------------
+static void ising_free(void) {
+    if (ising_storage == ISING_STORAGE_MSC) {
+        ising_msc_destroy(&ising_msc);
+    } else if (ising_storage == ISING_STORAGE_TEMPERING) {
+        ising_tempering_destroy(&ising_pt);
+    } else {
+        ising_lattice_destroy(&ising_grid);
+        ising_cluster_destroy(&ising_clusters);
+    }
+}
+
+void sim_ising_init(void) {
+    ising_create();
+}
+
 void sim_ising_destroy(void) {
-    if (ising_grid) { free(ising_grid); ising_grid = NULL; }
-    if (ising_pixels) { free(ising_pixels); ising_pixels = NULL; }
-    sg_destroy_image(ising_image);
-    sg_destroy_sampler(ising_sampler);
+    ising_free();
+#ifndef SIM_HEADLESS
+    lattice_view_destroy(&ising_lattice);
+    ising_lattice_sequence = 0;
+#endif
 }
 
 // -----------------------------------------------------------------------------
-// Update: perform Monte Carlo updates, compute energy and magnetization, and update texture
+// Update: perform Monte Carlo updates and compute energy and magnetization
 // -----------------------------------------------------------------------------
 void sim_ising_update(float dt) {
-    // Perform one Monte Carlo sweep (N = grid_size^2 random spin updates)
-    int N = ising_grid_size * ising_grid_size;
-    for (int step = 0; step < N; step++) {
-        int i = rand() % ising_grid_size;
-        int j = rand() % ising_grid_size;
-        int idx = j * ising_grid_size + i;
-        int spin = ising_grid[idx];
-        
-        // Sum over four nearest neighbors (with periodic boundaries)
-        int up    = ising_grid[ mod(j - 1, ising_grid_size) * ising_grid_size + i ];
-        int down  = ising_grid[ mod(j + 1, ising_grid_size) * ising_grid_size + i ];
-        int left  = ising_grid[ j * ising_grid_size + mod(i - 1, ising_grid_size) ];
-        int right = ising_grid[ j * ising_grid_size + mod(i + 1, ising_grid_size) ];
-        int sum_neighbors = up + down + left + right;
-        
-        // Energy change if the spin is flipped (with coupling constant J = 1)
-        int deltaE = 2 * spin * sum_neighbors;
-        
-        // Metropolis criterion
-        if (deltaE <= 0) {
-            ising_grid[idx] = -spin;
-        } else {
-            float r = (float)rand() / (float)RAND_MAX;
-            if (r < expf(-deltaE / ising_temperature)) {
-                ising_grid[idx] = -spin;
-            }
+    // One Monte Carlo sweep (every site once on average); the acceptance
+    // table is only rebuilt when the temperature moved
+    uint64_t start = stm_now();
+    if (ising_storage == ISING_STORAGE_MSC) {
+        ising_msc_set_temperature(&ising_msc, ising_temperature);
+        ising_msc_sweep(&ising_msc);
+    } else if (ising_storage == ISING_STORAGE_TEMPERING) {
+        // Every replica at its own rung of the ladder, one per worker task
+        ising_tempering_step(&ising_pt, ising_pt_swap_interval);
+    } else {
+        ising_lattice_set_temperature(&ising_grid, ising_temperature);
+        ising_cluster_set_temperature(&ising_clusters, ising_temperature);
+        switch (ising_update_mode) {
+            case ISING_UPDATE_RANDOM:        ising_lattice_sweep_random(&ising_grid); break;
+            case ISING_UPDATE_WOLFF:         ising_cluster_sweep_wolff(&ising_clusters, &ising_grid); break;
+            case ISING_UPDATE_SWENDSEN_WANG: ising_cluster_sweep_swendsen_wang(&ising_clusters, &ising_grid); break;
+            default:                         ising_lattice_sweep_checkerboard(&ising_grid); break;
         }
     }
-    
-    // Compute total energy and magnetization
-    float energy = 0.0f;
-    long total_spin = 0;
-    // To avoid double counting, only consider right and down neighbors per site
-    for (int j = 0; j < ising_grid_size; j++) {
-        for (int i = 0; i < ising_grid_size; i++) {
-            int idx = j * ising_grid_size + i;
-            int s = ising_grid[idx];
-            int right = ising_grid[j * ising_grid_size + mod(i + 1, ising_grid_size)];
-            int down  = ising_grid[ mod(j + 1, ising_grid_size) * ising_grid_size + i ];
-            energy += -s * (right + down);
-            total_spin += s;
-        }
+    double ms = stm_ms(stm_since(start));
+    ising_sweep_ms = (ising_sweep_ms > 0.0) ? 0.9 * ising_sweep_ms + 0.1 * ms : ms;
+    ising_sim_time += dt;
+
+    // Estimates restart when the measured temperature moves (in tempering
+    // mode, only when the slider reaches another rung); only every
+    // ising_measure_interval-th sweep is recorded
+    if (ising_measured_temperature() != ising_estimator_temperature) {
+        ising_restart_estimates();
+    }
+    if (++ising_sweeps_since_sample < ising_measure_interval) {
+        return;
     }
+    ising_sweeps_since_sample = 0;
+
+    // Debug builds check the running totals against a full recount now and then
+    int64_t energy, total_spin;
+    ising_totals(&energy, &total_spin);
+#ifndef NDEBUG
+    if (ising_mode_samples % ISING_VERIFY_INTERVAL == 0) {
+        assert(ising_storage == ISING_STORAGE_MSC ? ising_msc_verify(&ising_msc)
+                                                  : ising_lattice_verify(ising_shown_lattice()));
+    }
+#endif
+    double spins = (double)ising_grid_size * ising_grid_size;
     // Normalize energy per spin
-    float energy_per_spin = energy / (ising_grid_size * ising_grid_size);
+    float energy_per_spin = (float)(energy / spins);
     // Average magnetization per spin
-    float magnetization = (float)total_spin / (ising_grid_size * ising_grid_size);
+    float magnetization = (float)(total_spin / spins);
     
-    // Update simulation time and record data if within buffer limit
-    ising_sim_time += dt;
-    if (ising_data_count < ISING_BUFFER_LEN) {
-        ising_time_data[ising_data_count]   = ising_sim_time;
-        ising_energy_data[ising_data_count] = energy_per_spin;
-        ising_mag_data[ising_data_count]    = magnetization;
-        ising_data_count++;
+    // Record the sample
+    float sample[ISING_SERIES_COUNT] = { energy_per_spin, magnetization };
+    sim_series_push(&ising_series, ising_sim_time, sample);
+    double e = energy / spins, m = total_spin / spins;
+    double values[ISING_EST_COUNT] = { e, e * e, fabs(m), m * m, m * m * m * m };
+    sim_estimator_push(&ising_estimator, values);
+
+    // Refresh the current scheme's autocorrelation time now and then
+    ising_mode_samples++;
+    if (ising_mode_samples % ISING_TAU_INTERVAL == 0) {
+        double tau = sim_estimator_tau_int(&ising_estimator, ISING_EST_ENERGY);
+        ising_tau[ising_update_mode] = (float)(tau * ising_measure_interval);
     }
-    
-    // Update the pixel buffer for visualization:
-    // Color each cell based on its spin: +1 → red (255,0,0,255); -1 → blue (0,0,255,255)
-    for (int j = 0; j < ising_grid_size; j++) {
-        for (int i = 0; i < ising_grid_size; i++) {
-            int idx = j * ising_grid_size + i;
-            int pixel_idx = idx * 4;
-            if (ising_grid[idx] == 1) {
-                ising_pixels[pixel_idx + 0] = 255;
-                ising_pixels[pixel_idx + 1] = 0;
-                ising_pixels[pixel_idx + 2] = 0;
-                ising_pixels[pixel_idx + 3] = 255;
-            } else {
-                ising_pixels[pixel_idx + 0] = 0;
-                ising_pixels[pixel_idx + 1] = 0;
-                ising_pixels[pixel_idx + 2] = 255;
-                ising_pixels[pixel_idx + 3] = 255;
-            }
+
+    // Samples still correlated: space them further apart and start over
+    if (ising_auto_interval && ising_mode_samples % ISING_INTERVAL_CHECK == 0 &&
+        ising_measure_interval < ISING_MAX_INTERVAL) {
+        double tau = fmax(sim_estimator_tau_int(&ising_estimator, ISING_EST_ENERGY),
+                          sim_estimator_tau_int(&ising_estimator, ISING_EST_ABS_MAG));
+        if (tau > 1.0) {
+            int interval = ising_measure_interval * 2;
+            ising_restart_estimates();
+            ising_measure_interval = interval;
         }
     }
-    // Update the dynamic texture with the new pixel data
-    sg_update_image(ising_image, &(sg_image_data){
-        .subimage[0][0] = {
-            .ptr = ising_pixels,
-            .size = (size_t)(ising_grid_size * ising_grid_size * 4)
+}
+
+sim_parameter_t *sim_ising_settings(int16_t *count) {
+    *count = ISING_SETTING_COUNT;
+    return ising_settings;
+}
+
+// Energy and magnetization per spin after the last sweep, recorded or not
+int sim_ising_observe(sim_observable_t *out) {
+    int64_t energy, total_spin;
+    ising_totals(&energy, &total_spin);
+    double spins = (double)ising_grid_size * ising_grid_size;
+    out[0] = (sim_observable_t){ "energy", (double)energy / spins };
+    out[1] = (sim_observable_t){ "magnetization", (double)total_spin / spins };
+    return 2;
+}
+
+#ifndef SIM_HEADLESS
+// -----------------------------------------------------------------------------
+// UI state; the rest of the file is compiled out of headless builds
+// -----------------------------------------------------------------------------
+static const char *ising_update_names[ISING_UPDATE_COUNT] = {
+    "Checkerboard", "Random site", "Multi-spin (64/word)", "Wolff", "Swendsen-Wang", "Parallel tempering"
+};
+static int ising_update_mode_ui = ISING_UPDATE_CHECKERBOARD; // Combo value, posted
+static bool ising_auto_interval_ui = true;
+
+typedef struct ising_estimate_ctx_t {
+    double sites;
+    double temperature;
+} ising_estimate_ctx_t;
+
+// Binder cumulant U = 1 - <m^4> / (3 <m^2>^2)
+static double ising_binder(const double *means, void *ctx) {
+    (void)ctx;
+    double m2 = means[ISING_EST_MAG2];
+    return m2 > 0.0 ? 1.0 - means[ISING_EST_MAG4] / (3.0 * m2 * m2) : 0.0;
+}
+
+// Susceptibility N (<m^2> - <|m|>^2) / T
+static double ising_susceptibility(const double *means, void *ctx) {
+    const ising_estimate_ctx_t *c = (const ising_estimate_ctx_t*)ctx;
+    double m = means[ISING_EST_ABS_MAG];
+    return c->sites * (means[ISING_EST_MAG2] - m * m) / c->temperature;
+}
+
+// Specific heat N (<e^2> - <e>^2) / T^2
+static double ising_specific_heat(const double *means, void *ctx) {
+    const ising_estimate_ctx_t *c = (const ising_estimate_ctx_t*)ctx;
+    double e = means[ISING_EST_ENERGY];
+    return c->sites * (means[ISING_EST_ENERGY2] - e * e) / (c->temperature * c->temperature);
+}
+
+// What plot_ui and render show besides texels and series
+typedef struct ising_stats_t {
+    int grid_size;
+    int grid_size_new;
+    int update_mode;
+    int storage;
+    int measure_interval;
+    double sweep_ms;
+    double mean_cluster;
+    float tau[ISING_UPDATE_COUNT];
+    float estimator_temperature;
+    sim_estimator_t estimator;
+    // Parallel tempering: the replica on screen and the averages per rung
+    int replica_count;
+    int shown_replica;
+    float shown_temperature;
+    uint64_t swap_attempts, swap_accepts;
+    uint64_t rung_samples;
+    float t[ISING_TEMPERING_MAX_REPLICAS], e[ISING_TEMPERING_MAX_REPLICAS], m[ISING_TEMPERING_MAX_REPLICAS];
+    float chi[ISING_TEMPERING_MAX_REPLICAS], c[ISING_TEMPERING_MAX_REPLICAS];
+} ising_stats_t;
+_Static_assert(sizeof(ising_stats_t) <= SIM_SNAPSHOT_STATS, "Ising stats do not fit a snapshot");
+
+// -----------------------------------------------------------------------------
+// Messages from the UI, run on the thread stepping the simulation
+// -----------------------------------------------------------------------------
+// The grid size is picked up from the slider by ising_create
+static void ising_reset_message(const void *payload) {
+    (void)payload;
+    ising_free();
+    ising_create();
+}
+
+static void ising_update_message(const void *payload) {
+    ising_update_mode = *(const int*)payload;
+    ising_restart_estimates();
+    if (ising_storage != ising_storage_for(ising_update_mode)) {
+        ising_free();
+        ising_create();
+    }
+}
+
+static void ising_auto_interval_message(const void *payload) {
+    ising_auto_interval = *(const bool*)payload;
+    ising_restart_estimates();
+}
+
+static void ising_restart_message(const void *payload) {
+    (void)payload;
+    ising_restart_estimates();
+}
+
+static void ising_reset_averages_message(const void *payload) {
+    (void)payload;
+    if (ising_storage == ISING_STORAGE_TEMPERING) {
+        ising_tempering_reset_averages(&ising_pt);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Publish: texels, energy and magnetization series, estimates and stats for
+// the UI (see simulations.h)
+// -----------------------------------------------------------------------------
+void sim_ising_publish(sim_snapshot_t *snap) {
+    unsigned char *texels = sim_snapshot_pixels(snap, ising_texture_size, ising_texture_size);
+    if (ising_storage == ISING_STORAGE_MSC) {
+        ising_msc_render_r8(&ising_msc, texels, ising_texture_size, ising_texture_block);
+    } else {
+        ising_lattice_render_r8(ising_shown_lattice(), texels, ising_texture_size, ising_texture_block);
+    }
+    snap->series = ising_series;
+
+    ising_stats_t *stats = (ising_stats_t*)snap->stats;
+    stats->grid_size = ising_grid_size;
+    stats->grid_size_new = ising_grid_size_new;
+    stats->update_mode = ising_update_mode;
+    stats->storage = ising_storage;
+    stats->measure_interval = ising_measure_interval;
+    stats->sweep_ms = ising_sweep_ms;
+    // Cluster buffers only exist with int8 storage and only the cluster
+    // updates fill them
+    bool clusters = ising_storage == ISING_STORAGE_INT8 &&
+                    (ising_update_mode == ISING_UPDATE_WOLFF || ising_update_mode == ISING_UPDATE_SWENDSEN_WANG);
+    stats->mean_cluster = clusters ? ising_clusters.mean_cluster : 0.0;
+    memcpy(stats->tau, ising_tau, sizeof(stats->tau));
+    stats->estimator_temperature = ising_estimator_temperature;
+    stats->estimator = ising_estimator;
+    stats->replica_count = 0;
+    stats->rung_samples = 0;
+    if (ising_storage == ISING_STORAGE_TEMPERING) {
+        int slot = ising_tempering_nearest_slot(&ising_pt, ising_temperature);
+        stats->replica_count = ising_pt.replica_count;
+        stats->shown_replica = ising_pt.replica_at[slot];
+        stats->shown_temperature = ising_pt.temperatures[slot];
+        stats->swap_attempts = ising_pt.slots[slot].swap_attempts;
+        stats->swap_accepts = ising_pt.slots[slot].swap_accepts;
+        stats->rung_samples = ising_pt.slots[0].samples;
+        for (int i = 0; i < ising_pt.replica_count; i++) {
+            stats->t[i] = ising_pt.temperatures[i];
+            ising_tempering_observables(&ising_pt, i, &stats->e[i], &stats->m[i], &stats->chi[i], &stats->c[i]);
         }
-    });
+    }
 }
 
 // -----------------------------------------------------------------------------
 // Parameters UI: slider for grid size and temperature plus a reset button
 // -----------------------------------------------------------------------------
 void sim_ising_params_ui(void) {
+    const sim_snapshot_t *snap = simulations_snapshot();
+    const ising_stats_t *stats = snap ? (const ising_stats_t*)snap->stats : NULL;
     if (igButton("Reset Simulation", (ImVec2){0,0})) {
-        // If the grid size has been modified, update ising_grid_size accordingly
-        if (ising_grid_size != ising_grid_size_new) {
-            ising_grid_size = ising_grid_size_new;
+        simulations_post(ising_reset_message, NULL, 0);
+    }
+    simulations_draw_params(&ising_settings[ISING_SETTING_GRID_SIZE], 2);    // And Temperature
+    if (igCombo_Str_arr("Update", &ising_update_mode_ui, ising_update_names, ISING_UPDATE_COUNT, -1)) {
+        simulations_post(ising_update_message, &ising_update_mode_ui, sizeof(ising_update_mode_ui));
+    }
+    if (igCheckbox("Auto Measurement Interval", &ising_auto_interval_ui)) {
+        simulations_post(ising_auto_interval_message, &ising_auto_interval_ui, sizeof(ising_auto_interval_ui));
+    }
+    if (ising_auto_interval_ui) {
+        igText("Measuring every %d sweeps", stats ? stats->measure_interval : 1);
+    } else if (simulations_draw_params(&ising_settings[ISING_SETTING_INTERVAL], 1)) {
+        simulations_post(ising_restart_message, NULL, 0);
+    }
+    ising_storage_t storage = ising_storage_for(ising_update_mode_ui);
+    int size_new = stats ? stats->grid_size_new : 0;
+    if (storage == ISING_STORAGE_INT8 && size_new > ISING_INT8_MAX_SIZE) {
+        igTextWrapped("Sizes above %d need the multi-spin update", ISING_INT8_MAX_SIZE);
+    }
+    if (storage == ISING_STORAGE_TEMPERING) {
+        simulations_draw_params(&ising_settings[ISING_SETTING_PT_REPLICAS], 4);
+        if (igButton("Reset Averages", (ImVec2){0,0})) {
+            simulations_post(ising_reset_averages_message, NULL, 0);
+        }
+        if (size_new > ISING_TEMPERING_MAX_SIZE) {
+            igTextWrapped("Replicas are capped at %d spins per side", ISING_TEMPERING_MAX_SIZE);
         }
-        sim_ising_destroy();
-        sim_ising_init();
     }
-    simulations_draw_params(ising_params, 2);
 }
 
 // -----------------------------------------------------------------------------
 // Plot UI: display a time-series plot of energy and magnetization over time
 // -----------------------------------------------------------------------------
 void sim_ising_plot_ui(void) {
-    if (ising_data_count < 2)
+    const sim_snapshot_t *snap = simulations_snapshot();
+    double min_time, max_time;
+    if (!snap || !sim_series_x_range(&snap->series, &min_time, &max_time))
         return;
-    float max_time = ising_time_data[ising_data_count - 1];
-    float min_time = 0.0f;
+    const ising_stats_t *stats = (const ising_stats_t*)snap->stats;
     // Set y-axis limits to cover the expected ranges (energy near -2 to 2, magnetization between -1 and 1)
     ImPlot_SetNextAxesLimits(min_time, max_time, -2.5f, 2.5f, ImPlotCond_Always);
     if (ImPlot_BeginPlot("Energy and Magnetization", (ImVec2){0,0}, ImPlotFlags_None)) {
-        ImPlot_PlotLine_FloatPtrFloatPtr("Energy", ising_time_data, ising_energy_data, ising_data_count, 0, 0, sizeof(float));
-        ImPlot_PlotLine_FloatPtrFloatPtr("Magnetization", ising_time_data, ising_mag_data, ising_data_count, 0, 0, sizeof(float));
+        sim_series_plot_line(&snap->series, ISING_SERIES_ENERGY, "Energy");
+        sim_series_plot_line(&snap->series, ISING_SERIES_MAG, "Magnetization");
+        ImPlot_EndPlot();
+    }
+
+    // Estimates at the current temperature with autocorrelation-aware errors
+    const sim_estimator_t *est = &stats->estimator;
+    if (est->count > 1) {
+        ising_estimate_ctx_t ctx = { (double)stats->grid_size * stats->grid_size, stats->estimator_temperature };
+        double binder, binder_err, chi, chi_err, heat, heat_err;
+        sim_estimator_jackknife(est, ising_binder, &ctx, &binder, &binder_err);
+        sim_estimator_jackknife(est, ising_susceptibility, &ctx, &chi, &chi_err);
+        sim_estimator_jackknife(est, ising_specific_heat, &ctx, &heat, &heat_err);
+        igText("%llu samples, %d sweeps apart", (unsigned long long)est->count, stats->measure_interval);
+        igText("E/N   = %.5f +/- %.5f  (tau %.1f samples, %.0f independent)",
+               sim_estimator_mean(est, ISING_EST_ENERGY), sim_estimator_error(est, ISING_EST_ENERGY),
+               sim_estimator_tau_int(est, ISING_EST_ENERGY), sim_estimator_effective_samples(est, ISING_EST_ENERGY));
+        igText("|M|/N = %.5f +/- %.5f  (tau %.1f samples, %.0f independent)",
+               sim_estimator_mean(est, ISING_EST_ABS_MAG), sim_estimator_error(est, ISING_EST_ABS_MAG),
+               sim_estimator_tau_int(est, ISING_EST_ABS_MAG), sim_estimator_effective_samples(est, ISING_EST_ABS_MAG));
+        igText("Binder U = %.4f +/- %.4f", binder, binder_err);
+        igText("Susceptibility = %.4g +/- %.2g, Specific heat = %.4g +/- %.2g", chi, chi_err, heat, heat_err);
+
+        // Blocking analysis: tau estimate per block length, which should
+        // level off once blocks outgrow the correlation time
+        static double levels[SIM_ESTIMATOR_LEVELS], tau_e[SIM_ESTIMATOR_LEVELS], tau_m[SIM_ESTIMATOR_LEVELS];
+        double e0 = sim_estimator_level_error(est, ISING_EST_ENERGY, 0);
+        double m0 = sim_estimator_level_error(est, ISING_EST_ABS_MAG, 0);
+        int n = 0;
+        while (n < SIM_ESTIMATOR_LEVELS && est->level_count[n] >= 4) {
+            double re = e0 > 0.0 ? sim_estimator_level_error(est, ISING_EST_ENERGY, n) / e0 : 1.0;
+            double rm = m0 > 0.0 ? sim_estimator_level_error(est, ISING_EST_ABS_MAG, n) / m0 : 1.0;
+            levels[n] = n;
+            tau_e[n] = 0.5 * re * re;
+            tau_m[n] = 0.5 * rm * rm;
+            n++;
+        }
+        if (n > 1 && ImPlot_BeginPlot("Blocking Analysis", (ImVec2){0,0}, ImPlotFlags_None)) {
+            ImPlot_SetupAxes("log2 block length", "tau (samples)", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot_PlotLine_doublePtrdoublePtr("Energy", levels, tau_e, n, 0, 0, sizeof(double));
+            ImPlot_PlotLine_doublePtrdoublePtr("|Magnetization|", levels, tau_m, n, 0, 0, sizeof(double));
+            ImPlot_EndPlot();
+        }
+    }
+
+    // Autocorrelation time per update scheme: how many sweeps apart samples
+    // have to be to count as independent
+    if (ImPlot_BeginPlot("Autocorrelation Time of E (sweeps)", (ImVec2){0,0}, ImPlotFlags_None)) {
+        ImPlot_SetupAxes(NULL, "tau_int", ImPlotAxisFlags_None, ImPlotAxisFlags_AutoFit);
+        ImPlot_SetupAxisLimits(ImAxis_X1, -0.5, ISING_UPDATE_COUNT - 0.5, ImPlotCond_Always);
+        ImPlot_SetupAxisTicks_double(ImAxis_X1, 0.0, ISING_UPDATE_COUNT - 1, ISING_UPDATE_COUNT, ising_update_names, false);
+        ImPlot_PlotBars_FloatPtrInt("tau_int", stats->tau, ISING_UPDATE_COUNT, 0.6, 0.0, 0, 0, sizeof(float));
         ImPlot_EndPlot();
     }
+
+    // Replica exchange: averages at every rung of the ladder
+    if (stats->storage == ISING_STORAGE_TEMPERING && stats->rung_samples > 1) {
+        const float *t = stats->t, *e = stats->e, *m = stats->m, *chi = stats->chi, *c = stats->c;
+        int n = stats->replica_count;
+        if (ImPlot_BeginPlot("E and |M| per Spin vs T", (ImVec2){0,0}, ImPlotFlags_None)) {
+            ImPlot_SetupAxes("T", NULL, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot_PlotLine_FloatPtrFloatPtr("Energy", t, e, n, 0, 0, sizeof(float));
+            ImPlot_PlotLine_FloatPtrFloatPtr("|Magnetization|", t, m, n, 0, 0, sizeof(float));
+            ImPlot_EndPlot();
+        }
+        if (ImPlot_BeginPlot("Susceptibility and Specific Heat vs T", (ImVec2){0,0}, ImPlotFlags_None)) {
+            ImPlot_SetupAxes("T", NULL, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot_PlotLine_FloatPtrFloatPtr("Susceptibility", t, chi, n, 0, 0, sizeof(float));
+            ImPlot_PlotLine_FloatPtrFloatPtr("Specific Heat", t, c, n, 0, 0, sizeof(float));
+            ImPlot_EndPlot();
+        }
+    }
 }
 
 // -----------------------------------------------------------------------------
 // Render UI: display the lattice using the offscreen texture and show current stats
 // -----------------------------------------------------------------------------
 void sim_ising_render(void) {
+    const sim_snapshot_t *snap = simulations_snapshot();
+    if (!snap) return;
+    const ising_stats_t *stats = (const ising_stats_t*)snap->stats;
     ImVec4 white = {1.0f, 1.0f, 1.0f, 1.0f};
     ImVec2 size = {256,256};
     ImVec2 uv0 = {0,0};
     ImVec2 uv1 = {1,1};
-    ImTextureID tex_id = simgui_imtextureid_with_sampler(ising_image, ising_sampler);
+    // State texture: -1 is blue, +1 is red, sized to the published texels
+    if (ising_lattice.width != snap->width || ising_lattice.height != snap->height) {
+        lattice_view_destroy(&ising_lattice);
+        lattice_view_create(&ising_lattice, snap->width, snap->height,
+                            (float[4]){0.0f, 0.0f, 1.0f, 1.0f}, (float[4]){1.0f, 0.0f, 0.0f, 1.0f});
+        ising_lattice_sequence = 0;
+    }
+    if (snap->sequence != ising_lattice_sequence) {
+        lattice_view_update(&ising_lattice, snap->pixels);
+        ising_lattice_sequence = snap->sequence;
+    }
+    ImTextureID tex_id = simgui_imtextureid_with_sampler(ising_lattice.color_img, ising_lattice.color_smp);
     igImage(tex_id, size, uv0, uv1, white, (ImVec4){0,0,0,0});
-    float current_energy = (ising_data_count > 0) ? ising_energy_data[ising_data_count - 1] : 0.0f;
-    float current_mag = (ising_data_count > 0) ? ising_mag_data[ising_data_count - 1] : 0.0f;
+    float current_energy = sim_series_last(&snap->series, ISING_SERIES_ENERGY);
+    float current_mag = sim_series_last(&snap->series, ISING_SERIES_MAG);
     igText("Energy per spin: %.3f", current_energy);
     igText("Magnetization: %.3f", current_mag);
-}
\ No newline at end of file
+    if (stats->storage == ISING_STORAGE_TEMPERING) {
+        igText("Showing replica %d at T = %.3f", stats->shown_replica, stats->shown_temperature);
+        if (stats->swap_attempts > 0) {
+            igText("Swap acceptance with next T: %.1f%%", 100.0 * (double)stats->swap_accepts / (double)stats->swap_attempts);
+        }
+    }
+    if (stats->sweep_ms > 0.0) {
+        double replicas = (stats->storage == ISING_STORAGE_TEMPERING) ? stats->replica_count : 1;
+        double flips = replicas * stats->grid_size * stats->grid_size / (stats->sweep_ms * 1e3);
+        igText("Sweep: %.3f ms (%.1f M site updates/s)", stats->sweep_ms, flips);
+    }
+    if (stats->mean_cluster > 0.0) {
+        igText("Mean cluster size: %.1f spins", stats->mean_cluster);
+    }
+    if (stats->tau[stats->update_mode] > 0.0f) {
+        igText("tau_int(E): %.2f sweeps", stats->tau[stats->update_mode]);
+    }
+}
+
+#endif /* SIM_HEADLESS */
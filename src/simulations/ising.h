@@ -1,6 +1,12 @@
 #ifndef ISING_H
 #define ISING_H
 
+#include <stdint.h>
+
+struct sim_snapshot_t;
+struct sim_parameter_t;
+struct sim_observable_t;
+
 
 
 void sim_ising_init(void);
@@ -9,6 +15,9 @@ void sim_ising_update(float dt);
 void sim_ising_params_ui(void);
 void sim_ising_plot_ui(void);
 void sim_ising_render(void);
+struct sim_parameter_t *sim_ising_settings(int16_t *count);
+int sim_ising_observe(struct sim_observable_t *out);
+void sim_ising_publish(struct sim_snapshot_t *snap);
 
 
 #endif /* ISING_H */
\ No newline at end of file
@@ -0,0 +1,278 @@
+#include "ising_cluster.h"
+#include "workers.h"
+#include "rng.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+static inline uint64_t ising_cluster_rotl(uint64_t v, int k) {
+    return (v << k) | (v >> (64 - k));
+}
+
+static inline uint64_t ising_cluster_mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Stream 0 seeds the main generator, 1 + b the generator of band b
+static void ising_cluster_rng_seed(ising_cluster_rng_t *rng, uint64_t seed, int stream) {
+    sim_rng_t source;
+    sim_rng_init(&source, seed, SIM_RNG_STREAM_ISING_CLUSTER + (uint64_t)stream);
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = sim_rng_u64(&source);
+    }
+}
+
+static inline uint64_t ising_cluster_rng_next(ising_cluster_rng_t *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = ising_cluster_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = ising_cluster_rotl(s[3], 45);
+    return result;
+}
+
+static inline uint32_t ising_cluster_rng_next32(ising_cluster_rng_t *rng) {
+    return (uint32_t)(ising_cluster_rng_next(rng) >> 32);
+}
+
+// Union-find with path halving; unions hang the larger root under the smaller
+// so the forest does not depend on the order bands finish in
+static inline int32_t ising_uf_find(int32_t *parent, int32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static inline void ising_uf_union(int32_t *parent, int32_t a, int32_t b) {
+    a = ising_uf_find(parent, a);
+    b = ising_uf_find(parent, b);
+    if (a < b) {
+        parent[b] = a;
+    } else if (b < a) {
+        parent[a] = b;
+    }
+}
+
+// Root lookup without writes, safe while other threads read the forest
+static inline int32_t ising_uf_root(const int32_t *parent, int32_t i) {
+    while (parent[i] != i) {
+        i = parent[i];
+    }
+    return i;
+}
+
+// Sum of the four neighbors of (x, y), wrapping at the edges; the halos are
+// stale while a cluster grows
+static inline int ising_cluster_field(const ising_lattice_t *lat, int x, int y) {
+    const int size = lat->size;
+    int xl = x == 0 ? size - 1 : x - 1, xr = x == size - 1 ? 0 : x + 1;
+    int yu = y == 0 ? size - 1 : y - 1, yd = y == size - 1 ? 0 : y + 1;
+    return *ising_lattice_site(lat, xl, y) + *ising_lattice_site(lat, xr, y)
+         + *ising_lattice_site(lat, x, yu) + *ising_lattice_site(lat, x, yd);
+}
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+void ising_cluster_create(ising_cluster_t *cl, int size, uint64_t seed) {
+    memset(cl, 0, sizeof(*cl));
+    cl->size = size;
+    size_t sites = (size_t)size * (size_t)size;
+    cl->band_count = (size + ISING_CLUSTER_BAND_ROWS - 1) / ISING_CLUSTER_BAND_ROWS;
+    cl->stack = (int32_t*)malloc(sites * sizeof(int32_t));
+    cl->parent = (int32_t*)malloc(sites * sizeof(int32_t));
+    cl->edge_bonds = (uint8_t*)malloc((size_t)cl->band_count * (size_t)size);
+    cl->band_roots = (int32_t*)malloc((size_t)cl->band_count * sizeof(int32_t));
+    cl->band_rng = (ising_cluster_rng_t*)malloc((size_t)cl->band_count * sizeof(ising_cluster_rng_t));
+    ising_cluster_rng_seed(&cl->rng, seed, 0);
+    for (int b = 0; b < cl->band_count; b++) {
+        ising_cluster_rng_seed(&cl->band_rng[b], seed, 1 + b);
+    }
+    cl->temperature = -1.0f;
+}
+
+void ising_cluster_destroy(ising_cluster_t *cl) {
+    if (cl->stack) { free(cl->stack); cl->stack = NULL; }
+    if (cl->parent) { free(cl->parent); cl->parent = NULL; }
+    if (cl->edge_bonds) { free(cl->edge_bonds); cl->edge_bonds = NULL; }
+    if (cl->band_roots) { free(cl->band_roots); cl->band_roots = NULL; }
+    if (cl->band_rng) { free(cl->band_rng); cl->band_rng = NULL; }
+    cl->size = 0;
+    cl->band_count = 0;
+}
+
+void ising_cluster_set_temperature(ising_cluster_t *cl, float temperature) {
+    if (temperature == cl->temperature) {
+        return;
+    }
+    cl->temperature = temperature;
+    double threshold = (1.0 - exp(-2.0 / (double)temperature)) * 4294967296.0;
+    cl->p_add = threshold >= 4294967295.0 ? 0xFFFFFFFFu : (uint32_t)threshold;
+}
+
+// -----------------------------------------------------------------------------
+// Wolff
+// -----------------------------------------------------------------------------
+void ising_cluster_sweep_wolff(ising_cluster_t *cl, ising_lattice_t *lat) {
+    const int size = cl->size;
+    const int64_t sites = (int64_t)size * size;
+    const uint32_t p_add = cl->p_add;
+    int32_t *stack = cl->stack;
+    int64_t flipped = 0, d_energy = 0, d_spin = 0;
+    int clusters = 0;
+
+    while (flipped < sites) {
+        // Seed: flip it, then grow through aligned neighbors. Spins flip as
+        // they join, so a site can never be pushed twice, and each flip's
+        // deltaE = 2 s0 (sum of neighbors) is taken against the spins as they
+        // are at that moment, so the deltas add up to the cluster's.
+        int32_t seed = (int32_t)(((uint64_t)ising_cluster_rng_next32(&cl->rng) * (uint64_t)sites) >> 32);
+        int8_t *p = ising_lattice_site(lat, seed % size, seed / size);
+        const int8_t s0 = *p;
+        d_energy += 2 * s0 * ising_cluster_field(lat, seed % size, seed / size);
+        *p = (int8_t)-s0;
+        int top = 0;
+        stack[top++] = seed;
+        int64_t cluster_size = 1;
+
+        while (top > 0) {
+            int32_t i = stack[--top];
+            int x = i % size, y = i / size;
+            int xs[4] = { x == 0 ? size - 1 : x - 1, x == size - 1 ? 0 : x + 1, x, x };
+            int ys[4] = { y, y, y == 0 ? size - 1 : y - 1, y == size - 1 ? 0 : y + 1 };
+            for (int n = 0; n < 4; n++) {
+                int8_t *q = ising_lattice_site(lat, xs[n], ys[n]);
+                if (*q == s0 && ising_cluster_rng_next32(&cl->rng) < p_add) {
+                    d_energy += 2 * s0 * ising_cluster_field(lat, xs[n], ys[n]);
+                    *q = (int8_t)-s0;
+                    stack[top++] = ys[n] * size + xs[n];
+                    cluster_size++;
+                }
+            }
+        }
+        flipped += cluster_size;
+        d_spin -= 2 * s0 * cluster_size;
+        clusters++;
+    }
+    cl->mean_cluster = (double)flipped / clusters;
+    ising_lattice_exchange_halos(lat);
+    lat->energy += d_energy;
+    lat->magnetization += d_spin;
+}
+
+// -----------------------------------------------------------------------------
+// Swendsen-Wang
+// -----------------------------------------------------------------------------
+typedef struct ising_sw_ctx_t {
+    ising_cluster_t *cl;
+    ising_lattice_t *lat;
+    uint64_t key;                // Per-sweep key hashed with each root for its flip
+} ising_sw_ctx_t;
+
+// Bonds and labels inside one band. South bonds out of the band's last row
+// are only recorded; they are joined after every band is done.
+static void ising_sw_label_band(void *ctx, int task, int worker) {
+    (void)worker;
+    ising_sw_ctx_t *sw = (ising_sw_ctx_t*)ctx;
+    ising_cluster_t *cl = sw->cl;
+    const ising_lattice_t *lat = sw->lat;
+    const int size = cl->size;
+    const uint32_t p_add = cl->p_add;
+    const int y0 = task * ISING_CLUSTER_BAND_ROWS;
+    const int y1 = y0 + ISING_CLUSTER_BAND_ROWS < size ? y0 + ISING_CLUSTER_BAND_ROWS : size;
+    int32_t *parent = cl->parent;
+    uint8_t *edge = cl->edge_bonds + (size_t)task * size;
+    ising_cluster_rng_t rng = cl->band_rng[task];
+
+    for (int32_t i = y0 * size; i < y1 * size; i++) {
+        parent[i] = i;
+    }
+    for (int y = y0; y < y1; y++) {
+        int ys = y == size - 1 ? 0 : y + 1;
+        for (int x = 0; x < size; x++) {
+            int32_t i = y * size + x;
+            int8_t s = *ising_lattice_site(lat, x, y);
+            int xe = x == size - 1 ? 0 : x + 1;
+            if (*ising_lattice_site(lat, xe, y) == s && ising_cluster_rng_next32(&rng) < p_add) {
+                ising_uf_union(parent, i, y * size + xe);
+            }
+            int south = *ising_lattice_site(lat, x, ys) == s && ising_cluster_rng_next32(&rng) < p_add;
+            if (y + 1 < y1) {
+                if (south) {
+                    ising_uf_union(parent, i, i + size);
+                }
+            } else {
+                edge[x] = (uint8_t)south;
+            }
+        }
+    }
+    cl->band_rng[task] = rng;
+}
+
+// Flip every cluster whose root hashes to 1 and count the roots
+static void ising_sw_flip_band(void *ctx, int task, int worker) {
+    (void)worker;
+    ising_sw_ctx_t *sw = (ising_sw_ctx_t*)ctx;
+    ising_cluster_t *cl = sw->cl;
+    ising_lattice_t *lat = sw->lat;
+    const int size = cl->size;
+    const int y0 = task * ISING_CLUSTER_BAND_ROWS;
+    const int y1 = y0 + ISING_CLUSTER_BAND_ROWS < size ? y0 + ISING_CLUSTER_BAND_ROWS : size;
+    const int32_t *parent = cl->parent;
+    int32_t roots = 0;
+
+    for (int y = y0; y < y1; y++) {
+        for (int x = 0; x < size; x++) {
+            int32_t i = y * size + x;
+            int32_t root = ising_uf_root(parent, i);
+            roots += (root == i);
+            if (ising_cluster_mix64((uint64_t)root ^ sw->key) & 1) {
+                int8_t *p = ising_lattice_site(lat, x, y);
+                *p = (int8_t)-*p;
+            }
+        }
+    }
+    cl->band_roots[task] = roots;
+}
+
+void ising_cluster_sweep_swendsen_wang(ising_cluster_t *cl, ising_lattice_t *lat) {
+    const int size = cl->size;
+    ising_sw_ctx_t ctx = { cl, lat, ising_cluster_rng_next(&cl->rng) };
+    sim_workers_run(ising_sw_label_band, &ctx, cl->band_count);
+
+    // Stitch each band to the next one (the last wraps to the first)
+    for (int b = 0; b < cl->band_count; b++) {
+        int y = (b + 1) * ISING_CLUSTER_BAND_ROWS - 1 < size - 1 ? (b + 1) * ISING_CLUSTER_BAND_ROWS - 1 : size - 1;
+        int ys = y == size - 1 ? 0 : y + 1;
+        const uint8_t *edge = cl->edge_bonds + (size_t)b * size;
+        for (int x = 0; x < size; x++) {
+            if (edge[x]) {
+                ising_uf_union(cl->parent, y * size + x, ys * size + x);
+            }
+        }
+    }
+
+    sim_workers_run(ising_sw_flip_band, &ctx, cl->band_count);
+    ising_lattice_exchange_halos(lat);
+
+    // Bands flip concurrently, so the energy change is not known per site;
+    // the sweep already visits every site twice, a third pass is cheap
+    ising_lattice_recount(lat);
+
+    int64_t clusters = 0;
+    for (int b = 0; b < cl->band_count; b++) {
+        clusters += cl->band_roots[b];
+    }
+    cl->mean_cluster = (double)size * size / (double)clusters;
+}
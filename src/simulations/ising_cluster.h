@@ -0,0 +1,60 @@
+#ifndef ISING_CLUSTER_H
+#define ISING_CLUSTER_H
+
+#include "ising_lattice.h"
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Cluster updates for the int8 Ising lattice
+//
+// Both algorithms join aligned neighbors with probability 1 - exp(-2/T) and
+// flip whole clusters, which removes most of the critical slowing down of
+// single-spin Metropolis near Tc.
+//
+// Wolff grows one cluster from a random seed with an explicit stack, flipping
+// spins as they join, and repeats until about size^2 spins have flipped (one
+// sweep's worth). Swendsen-Wang places bonds everywhere and flips every
+// cluster with probability 1/2: bonds and the labeling inside bands of rows
+// run in parallel as a union-find forest, the bands are then stitched across
+// their edges, and the flip pass hashes each root with a per-sweep key so it
+// can look roots up concurrently without writing to the forest.
+//
+// Wolff keeps the lattice's running energy and magnetization up to date flip
+// by flip; Swendsen-Wang recounts them at the end of its sweep.
+//
+// All work buffers are allocated once at create.
+// -----------------------------------------------------------------------------
+
+#define ISING_CLUSTER_BAND_ROWS 32
+
+typedef struct ising_cluster_rng_t {
+    uint64_t s[4];               // xoshiro256**
+} ising_cluster_rng_t;
+
+typedef struct ising_cluster_t {
+    int size;                    // Must match the lattice
+    int band_count;
+    int32_t *stack;              // Wolff: sites waiting to grow the cluster
+    int32_t *parent;             // Swendsen-Wang: union-find forest over sites
+    uint8_t *edge_bonds;         // Swendsen-Wang: south bonds of each band's last row
+    float temperature;
+    uint32_t p_add;              // (1 - exp(-2/T)) * 2^32
+    ising_cluster_rng_t rng;     // Wolff seeds and growth, Swendsen-Wang flip keys
+    ising_cluster_rng_t *band_rng; // Swendsen-Wang bonds, one per band
+    int32_t *band_roots;         // Swendsen-Wang clusters rooted in each band
+    double mean_cluster;         // Mean cluster size of the last sweep
+} ising_cluster_t;
+
+void ising_cluster_create(ising_cluster_t *cl, int size, uint64_t seed);
+void ising_cluster_destroy(ising_cluster_t *cl);
+
+// Rebuild the bond probability if the temperature changed
+void ising_cluster_set_temperature(ising_cluster_t *cl, float temperature);
+
+// Wolff clusters until at least size^2 spins have flipped
+void ising_cluster_sweep_wolff(ising_cluster_t *cl, ising_lattice_t *lat);
+
+// One Swendsen-Wang update of the whole lattice
+void ising_cluster_sweep_swendsen_wang(ising_cluster_t *cl, ising_lattice_t *lat);
+
+#endif /* ISING_CLUSTER_H */
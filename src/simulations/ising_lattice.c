@@ -0,0 +1,350 @@
+#include "ising_lattice.h"
+#include "workers.h"
+#include "rng.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// Random numbers: xoshiro128+ in lanes, stepped together so the loop
+// vectorizes. Lane 0 doubles as the scalar generator for the random-site sweep.
+// Each band's lanes are seeded from its own stream (see rng.h).
+// -----------------------------------------------------------------------------
+static void ising_rng_seed(ising_rng_lanes_t *rng, uint64_t seed, int band) {
+    sim_rng_t stream;
+    sim_rng_init(&stream, seed, SIM_RNG_STREAM_ISING_LATTICE + (uint64_t)band);
+    for (int i = 0; i < 4; i++) {
+        for (int l = 0; l < ISING_LANES; l++) {
+            rng->s[i][l] = sim_rng_u32(&stream);
+        }
+    }
+    for (int l = 0; l < ISING_LANES; l++) {
+        rng->s[3][l] |= 1u;      // Never the all-zero state
+    }
+}
+
+static inline void ising_rng_lanes_next(ising_rng_lanes_t *rng, uint32_t *out) {
+    for (int l = 0; l < ISING_LANES; l++) {
+        uint32_t s0 = rng->s[0][l], s1 = rng->s[1][l], s2 = rng->s[2][l], s3 = rng->s[3][l];
+        out[l] = s0 + s3;
+        uint32_t t = s1 << 9;
+        s2 ^= s0;
+        s3 ^= s1;
+        s1 ^= s2;
+        s0 ^= s3;
+        s2 ^= t;
+        s3 = (s3 << 11) | (s3 >> 21);
+        rng->s[0][l] = s0; rng->s[1][l] = s1; rng->s[2][l] = s2; rng->s[3][l] = s3;
+    }
+}
+
+static inline uint32_t ising_rng_next(ising_rng_lanes_t *rng) {
+    uint32_t s0 = rng->s[0][0], s1 = rng->s[1][0], s2 = rng->s[2][0], s3 = rng->s[3][0];
+    uint32_t result = s0 + s3;
+    uint32_t t = s1 << 9;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = (s3 << 11) | (s3 >> 21);
+    rng->s[0][0] = s0; rng->s[1][0] = s1; rng->s[2][0] = s2; rng->s[3][0] = s3;
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Halo exchange for one color: wrapped columns first, then whole rows
+// (corners included, though nothing reads them)
+// -----------------------------------------------------------------------------
+static void ising_lattice_exchange_color(ising_lattice_t *lat, int color) {
+    int8_t *spins = lat->spins[color];
+    const int stride = lat->stride;
+    for (int y = 1; y <= lat->size; y++) {
+        int8_t *row = spins + (size_t)y * stride;
+        row[0] = row[lat->half];
+        row[lat->half + 1] = row[1];
+    }
+    memcpy(spins, spins + (size_t)lat->size * stride, (size_t)stride);
+    memcpy(spins + (size_t)(lat->size + 1) * stride, spins + stride, (size_t)stride);
+}
+
+void ising_lattice_exchange_halos(ising_lattice_t *lat) {
+    ising_lattice_exchange_color(lat, 0);
+    ising_lattice_exchange_color(lat, 1);
+}
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+// Generators first, then the band deltas and each color, padded to cache lines
+static size_t ising_lattice_color_bytes(int size) {
+    size_t count = (size_t)(size + 2) * (size_t)(size / 2 + 2);
+    return (count + 63) & ~(size_t)63;
+}
+
+size_t ising_lattice_bytes(int size) {
+    size = (size + 1) & ~1;
+    size_t bands = (size_t)((size + ISING_BAND_ROWS - 1) / ISING_BAND_ROWS);
+    size_t deltas = (bands * 2 * sizeof(int64_t) + 63) & ~(size_t)63;
+    return bands * sizeof(ising_rng_lanes_t) + deltas + 2 * ising_lattice_color_bytes(size);
+}
+
+void ising_lattice_create(ising_lattice_t *lat, int size, uint64_t seed) {
+    void *memory = malloc(ising_lattice_bytes(size));
+    ising_lattice_create_in(lat, size, seed, memory);
+    lat->owns_memory = 1;
+}
+
+void ising_lattice_create_in(ising_lattice_t *lat, int size, uint64_t seed, void *memory) {
+    memset(lat, 0, sizeof(*lat));
+    lat->size = (size + 1) & ~1;
+    lat->half = lat->size / 2;
+    lat->stride = lat->half + 2;
+    lat->band_count = (lat->size + ISING_BAND_ROWS - 1) / ISING_BAND_ROWS;
+    lat->memory = memory;
+    lat->rng = (ising_rng_lanes_t*)memory;
+    lat->band_delta = (int64_t(*)[2])(lat->rng + lat->band_count);
+    lat->spins[0] = (int8_t*)lat->band_delta + (((size_t)lat->band_count * 2 * sizeof(int64_t) + 63) & ~(size_t)63);
+    lat->spins[1] = lat->spins[0] + ising_lattice_color_bytes(lat->size);
+
+    for (int b = 0; b < lat->band_count; b++) {
+        ising_rng_seed(&lat->rng[b], seed, b);
+    }
+
+    // Random initial spins
+    for (int y = 0; y < lat->size; y++) {
+        for (int x = 0; x < lat->size; x++) {
+            *ising_lattice_site(lat, x, y) = (ising_rng_next(&lat->rng[0]) >> 31) ? 1 : -1;
+        }
+    }
+    ising_lattice_exchange_halos(lat);
+    ising_lattice_recount(lat);
+
+    lat->temperature = -1.0f;
+}
+
+void ising_lattice_destroy(ising_lattice_t *lat) {
+    if (lat->owns_memory && lat->memory) {
+        free(lat->memory);
+    }
+    lat->memory = NULL;
+    lat->owns_memory = 0;
+    lat->spins[0] = lat->spins[1] = NULL;
+    lat->rng = NULL;
+    lat->band_delta = NULL;
+    lat->size = 0;
+    lat->band_count = 0;
+}
+
+void ising_lattice_set_temperature(ising_lattice_t *lat, float temperature) {
+    if (temperature == lat->temperature) {
+        return;
+    }
+    lat->temperature = temperature;
+    for (int i = 0; i < 2; i++) {
+        double p = exp(-4.0 * (i + 1) / (double)temperature);
+        double threshold = p * 4294967296.0;
+        lat->accept[i] = threshold >= 4294967295.0 ? 0xFFFFFFFFu : (uint32_t)threshold;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Checkerboard sweep
+// -----------------------------------------------------------------------------
+typedef struct ising_sweep_ctx_t {
+    ising_lattice_t *lat;
+    int color;
+} ising_sweep_ctx_t;
+
+// Metropolis on n contiguous sites of one color. With e = s * (sum of
+// neighbors), deltaE = 2e: flips with e <= 0 always pass, e = 2 and e = 4
+// pass when the random number is under the table threshold. The energy and
+// magnetization changes of the accepted flips are added to *de and *dm.
+static inline void ising_update_lanes(int8_t *restrict s, const int8_t *restrict up,
+                                      const int8_t *restrict mid, const int8_t *restrict side,
+                                      const int8_t *restrict down, const uint32_t *restrict r,
+                                      uint32_t accept4, uint32_t accept8, int n,
+                                      int *restrict de, int *restrict dm) {
+    int d_energy = 0, d_spin = 0;
+    for (int l = 0; l < n; l++) {
+        int spin = s[l];
+        int e = spin * (up[l] + mid[l] + side[l] + down[l]);
+        uint32_t threshold = e > 2 ? accept8 : accept4;
+        int flip = (e <= 0) | (r[l] < threshold);
+        s[l] = (int8_t)(spin - 2 * spin * flip);
+        d_energy += 2 * e * flip;
+        d_spin -= 2 * spin * flip;
+    }
+    *de += d_energy;
+    *dm += d_spin;
+}
+
+static void ising_sweep_band(void *ctx, int task, int worker) {
+    (void)worker;
+    ising_sweep_ctx_t *sweep = (ising_sweep_ctx_t*)ctx;
+    ising_lattice_t *lat = sweep->lat;
+    const int color = sweep->color;
+    const int half = lat->half;
+    const int stride = lat->stride;
+    const uint32_t accept4 = lat->accept[0];
+    const uint32_t accept8 = lat->accept[1];
+    const int y_end = (task + 1) * ISING_BAND_ROWS < lat->size ? (task + 1) * ISING_BAND_ROWS : lat->size;
+    ising_rng_lanes_t rng = lat->rng[task];
+    uint32_t r[ISING_LANES];
+    int64_t band_energy = 0, band_spin = 0;
+
+    for (int y = task * ISING_BAND_ROWS; y < y_end; y++) {
+        int8_t *s = lat->spins[color] + (size_t)(y + 1) * stride + 1;
+        const int8_t *mid = lat->spins[color ^ 1] + (size_t)(y + 1) * stride + 1;
+        const int8_t *up = mid - stride;
+        const int8_t *down = mid + stride;
+        // Site k sits at x = 2k + ((color ^ y) & 1); its other horizontal
+        // neighbor is column k + 1 when x is odd, k - 1 when it is even
+        const int8_t *side = mid + (((color ^ y) & 1) ? 1 : -1);
+
+        int k = 0, row_energy = 0, row_spin = 0;
+        for (; k + ISING_LANES <= half; k += ISING_LANES) {
+            ising_rng_lanes_next(&rng, r);
+            ising_update_lanes(s + k, up + k, mid + k, side + k, down + k, r, accept4, accept8, ISING_LANES,
+                               &row_energy, &row_spin);
+        }
+        if (k < half) {
+            ising_rng_lanes_next(&rng, r);
+            ising_update_lanes(s + k, up + k, mid + k, side + k, down + k, r, accept4, accept8, half - k,
+                               &row_energy, &row_spin);
+        }
+        band_energy += row_energy;
+        band_spin += row_spin;
+    }
+    lat->rng[task] = rng;
+    lat->band_delta[task][0] = band_energy;
+    lat->band_delta[task][1] = band_spin;
+}
+
+static void ising_lattice_add_band_deltas(ising_lattice_t *lat) {
+    for (int band = 0; band < lat->band_count; band++) {
+        lat->energy += lat->band_delta[band][0];
+        lat->magnetization += lat->band_delta[band][1];
+    }
+}
+
+void ising_lattice_sweep_checkerboard(ising_lattice_t *lat) {
+    for (int color = 0; color < 2; color++) {
+        ising_sweep_ctx_t ctx = { lat, color };
+        sim_workers_run(ising_sweep_band, &ctx, lat->band_count);
+        ising_lattice_exchange_color(lat, color);
+        ising_lattice_add_band_deltas(lat);
+    }
+}
+
+void ising_lattice_sweep_checkerboard_serial(ising_lattice_t *lat) {
+    for (int color = 0; color < 2; color++) {
+        ising_sweep_ctx_t ctx = { lat, color };
+        for (int band = 0; band < lat->band_count; band++) {
+            ising_sweep_band(&ctx, band, 0);
+        }
+        ising_lattice_exchange_color(lat, color);
+        ising_lattice_add_band_deltas(lat);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Random-site sweep: the classic sequential Metropolis, kept for comparison
+// -----------------------------------------------------------------------------
+void ising_lattice_sweep_random(ising_lattice_t *lat) {
+    const int size = lat->size;
+    const int count = size * size;
+    ising_rng_lanes_t *rng = &lat->rng[0];
+    int64_t d_energy = 0, d_spin = 0;
+    for (int step = 0; step < count; step++) {
+        int x = (int)(((uint64_t)ising_rng_next(rng) * (uint64_t)size) >> 32);
+        int y = (int)(((uint64_t)ising_rng_next(rng) * (uint64_t)size) >> 32);
+        int xl = x == 0 ? size - 1 : x - 1;
+        int xr = x == size - 1 ? 0 : x + 1;
+        int yu = y == 0 ? size - 1 : y - 1;
+        int yd = y == size - 1 ? 0 : y + 1;
+        int8_t *s = ising_lattice_site(lat, x, y);
+        int sum = *ising_lattice_site(lat, xl, y) + *ising_lattice_site(lat, xr, y)
+                + *ising_lattice_site(lat, x, yu) + *ising_lattice_site(lat, x, yd);
+        int e = *s * sum;
+        uint32_t threshold = e > 2 ? lat->accept[1] : lat->accept[0];
+        int flip = (e <= 0) | (ising_rng_next(rng) < threshold);
+        d_energy += 2 * e * flip;
+        d_spin -= 2 * *s * flip;
+        *s = (int8_t)(*s - 2 * *s * flip);
+    }
+    ising_lattice_exchange_halos(lat);
+    lat->energy += d_energy;
+    lat->magnetization += d_spin;
+}
+
+// -----------------------------------------------------------------------------
+// Observables: every bond joins a color 0 site to a color 1 site, so summing
+// the four neighbors of the color 0 sites counts each bond exactly once
+// -----------------------------------------------------------------------------
+void ising_lattice_measure(const ising_lattice_t *lat, int64_t *energy, int64_t *magnetization) {
+    const int half = lat->half;
+    const int stride = lat->stride;
+    int64_t e_total = 0, m_total = 0;
+    for (int y = 0; y < lat->size; y++) {
+        const int8_t *s = lat->spins[0] + (size_t)(y + 1) * stride + 1;
+        const int8_t *t = lat->spins[1] + (size_t)(y + 1) * stride + 1;
+        const int8_t *side = t + ((y & 1) ? 1 : -1);
+        int e_row = 0, m_row = 0;
+        for (int k = 0; k < half; k++) {
+            e_row += s[k] * (t[k - stride] + t[k] + side[k] + t[k + stride]);
+            m_row += s[k] + t[k];
+        }
+        e_total -= e_row;
+        m_total += m_row;
+    }
+    *energy = e_total;
+    *magnetization = m_total;
+}
+
+void ising_lattice_recount(ising_lattice_t *lat) {
+    ising_lattice_measure(lat, &lat->energy, &lat->magnetization);
+}
+
+int ising_lattice_verify(const ising_lattice_t *lat) {
+    int64_t energy, magnetization;
+    ising_lattice_measure(lat, &energy, &magnetization);
+    return energy == lat->energy && magnetization == lat->magnetization;
+}
+
+void ising_lattice_render_r8(const ising_lattice_t *lat, unsigned char *texels, int tex_size, int block) {
+    if (block == 1) {
+        for (int y = 0; y < lat->size; y++) {
+            unsigned char *dst = texels + (size_t)y * tex_size;
+            for (int color = 0; color < 2; color++) {
+                const int8_t *s = lat->spins[color] + (size_t)(y + 1) * lat->stride + 1;
+                unsigned char *out = dst + ((color ^ y) & 1);
+                for (int k = 0; k < lat->half; k++) {
+                    out[2 * k] = (unsigned char)((s[k] + 1) * 255 / 2);
+                }
+            }
+        }
+        return;
+    }
+
+    // Sum of spins per block, mapped from -block^2..block^2 to 0..255
+    const int full = block * block;
+    int *sums = (int*)malloc((size_t)tex_size * sizeof(int));
+    for (int py = 0; py < tex_size; py++) {
+        memset(sums, 0, (size_t)tex_size * sizeof(int));
+        for (int y = py * block; y < (py + 1) * block && y < lat->size; y++) {
+            for (int color = 0; color < 2; color++) {
+                const int8_t *s = lat->spins[color] + (size_t)(y + 1) * lat->stride + 1;
+                const int parity = (color ^ y) & 1;
+                for (int k = 0; k < lat->half; k++) {
+                    sums[(2 * k + parity) / block] += s[k];
+                }
+            }
+        }
+        unsigned char *dst = texels + (size_t)py * tex_size;
+        for (int px = 0; px < tex_size; px++) {
+            dst[px] = (unsigned char)(((sums[px] + full) * 255) / (2 * full));
+        }
+    }
+    free(sums);
+}
@@ -0,0 +1,103 @@
+#ifndef ISING_LATTICE_H
+#define ISING_LATTICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Checkerboard Ising lattice
+//
+// Spins are int8 (+1 / -1) split by checkerboard color: site (x, y) has
+// color (x + y) & 1 and lives in spins[color] at row y, column x / 2. Every
+// neighbor of a site has the other color, so a whole color can be updated at
+// once, and within a row the sites of one color are contiguous, so the update
+// runs in ISING_LANES-wide lanes with no branches. The neighbors of column k
+// in row y are, in the other color's array, column k of rows y - 1, y and
+// y + 1, plus column k - 1 or k + 1 of row y depending on the row parity.
+//
+// Each color array has a halo row above and below and a halo column on either
+// side holding the wrapped-around spins, refreshed after that color changes,
+// so the kernel never special-cases the torus edges.
+//
+// Metropolis acceptance compares a 32-bit random number to P(flip) * 2^32
+// from a small table rebuilt only when the temperature changes; deltaE can
+// only be 4 or 8 for an uphill flip. Rows are updated in bands on the shared
+// worker pool, each band with its own lanes of xoshiro128+ generators, so
+// results do not depend on the thread count.
+//
+// Energy and magnetization are running totals: each band sums deltaE = 2e
+// and -2s over the flips it accepts, and the sweep adds the band sums in band
+// order once the color is done, so reading them costs nothing per sweep.
+// Anything that writes spins through ising_lattice_site must keep them up to
+// date itself or call ising_lattice_recount.
+// -----------------------------------------------------------------------------
+
+#define ISING_LANES 16           // Sites updated together, one random number each
+#define ISING_BAND_ROWS 16       // Rows per parallel task
+
+typedef struct ising_rng_lanes_t {
+    uint32_t s[4][ISING_LANES];  // xoshiro128+ state, one generator per lane
+} ising_rng_lanes_t;
+
+typedef struct ising_lattice_t {
+    int size;                    // Spins per side of the torus, even
+    int half;                    // Sites of one color per row
+    int stride;                  // half plus the two halo columns
+    int8_t *spins[2];            // Per color: (size + 2) rows of stride spins
+    float temperature;           // Temperature the acceptance table is built for
+    uint32_t accept[2];          // P(flip) * 2^32 for deltaE = 4 and 8
+    int band_count;
+    ising_rng_lanes_t *rng;      // One set of lanes per band
+    int64_t (*band_delta)[2];    // Energy and magnetization change per band, last color
+    int64_t energy;              // Running total energy (J = 1)
+    int64_t magnetization;       // Running sum of spins
+    void *memory;                // Single block holding the generators and both colors
+    int owns_memory;
+} ising_lattice_t;
+
+// Spin at (x, y) for 0 <= x, y < size
+static inline int8_t *ising_lattice_site(const ising_lattice_t *lat, int x, int y) {
+    int color = (x + y) & 1;
+    return lat->spins[color] + (size_t)(y + 1) * lat->stride + (x >> 1) + 1;
+}
+
+// size is rounded up to an even number; spins start uniformly random
+void ising_lattice_create(ising_lattice_t *lat, int size, uint64_t seed);
+void ising_lattice_destroy(ising_lattice_t *lat);
+
+// Same, in caller-owned memory of ising_lattice_bytes(size) bytes aligned to
+// 64, so several lattices can share one contiguous block
+size_t ising_lattice_bytes(int size);
+void ising_lattice_create_in(ising_lattice_t *lat, int size, uint64_t seed, void *memory);
+
+// Rebuild the acceptance table if the temperature changed
+void ising_lattice_set_temperature(ising_lattice_t *lat, float temperature);
+
+// One Metropolis sweep: both colors in turn, every site once
+void ising_lattice_sweep_checkerboard(ising_lattice_t *lat);
+
+// The same sweep entirely on the calling thread, for callers that already
+// spread whole lattices over the worker pool
+void ising_lattice_sweep_checkerboard_serial(ising_lattice_t *lat);
+
+// One Metropolis sweep of size^2 updates at uniformly random sites
+void ising_lattice_sweep_random(ising_lattice_t *lat);
+
+// Refresh the halos of both colors after writing spins through
+// ising_lattice_site (the sweeps keep them up to date themselves)
+void ising_lattice_exchange_halos(ising_lattice_t *lat);
+
+// Total energy (J = 1) and sum of spins by a full pass over the lattice
+void ising_lattice_measure(const ising_lattice_t *lat, int64_t *energy, int64_t *magnetization);
+
+// Reset the running totals from ising_lattice_measure
+void ising_lattice_recount(ising_lattice_t *lat);
+
+// Nonzero if the running totals agree with a full recount
+int ising_lattice_verify(const ising_lattice_t *lat);
+
+// Reduce into a tex_size x tex_size R8 image where each texel covers a
+// block x block square and holds its fraction of up spins scaled to 0..255
+void ising_lattice_render_r8(const ising_lattice_t *lat, unsigned char *texels, int tex_size, int block);
+
+#endif /* ISING_LATTICE_H */
@@ -0,0 +1,291 @@
+#include "ising_msc.h"
+#include "workers.h"
+#include "rng.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+static inline int ising_msc_popcount(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static inline uint64_t ising_msc_rotl(uint64_t v, int k) {
+    return (v << k) | (v >> (64 - k));
+}
+
+static inline uint64_t ising_msc_rng_next(ising_msc_rng_t *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = ising_msc_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = ising_msc_rotl(s[3], 45);
+    return result;
+}
+
+// Lanes of `lanes` set with probability threshold / 2^32. Each lane compares
+// a random number to the threshold from the top bit down, one random word
+// per bit; a lane is decided at the first bit where they differ, and most
+// are after a handful of words.
+static inline uint64_t ising_msc_bernoulli(ising_msc_rng_t *rng, uint64_t lanes, uint32_t threshold) {
+    uint64_t result = 0;
+    uint64_t undecided = lanes;
+    for (int bit = 31; bit >= 0 && undecided; bit--) {
+        uint64_t r = ising_msc_rng_next(rng);
+        if ((threshold >> bit) & 1u) {
+            result |= undecided & ~r;   // Random bit 0 under a threshold bit 1: below
+            undecided &= r;
+        } else {
+            undecided &= ~r;            // Random bit 1 over a threshold bit 0: above
+        }
+    }
+    return result;
+}
+
+static inline uint64_t *ising_msc_row(const ising_msc_t *lat, int color, int y) {
+    return lat->spins[color] + (size_t)(y + 1) * lat->stride + 1;
+}
+
+// -----------------------------------------------------------------------------
+// Halo exchange for one color
+// -----------------------------------------------------------------------------
+static void ising_msc_exchange_halos(ising_msc_t *lat, int color) {
+    uint64_t *spins = lat->spins[color];
+    const int stride = lat->stride;
+    for (int y = 1; y <= lat->size; y++) {
+        uint64_t *row = spins + (size_t)y * stride;
+        row[0] = row[lat->words];
+        row[lat->words + 1] = row[1];
+    }
+    memcpy(spins, spins + (size_t)lat->size * stride, (size_t)stride * sizeof(uint64_t));
+    memcpy(spins + (size_t)(lat->size + 1) * stride, spins + stride, (size_t)stride * sizeof(uint64_t));
+}
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+void ising_msc_create(ising_msc_t *lat, int size, uint64_t seed) {
+    memset(lat, 0, sizeof(*lat));
+    lat->size = (size + 127) & ~127;
+    lat->words = lat->size / 128;
+    lat->stride = lat->words + 2;
+    size_t count = (size_t)(lat->size + 2) * (size_t)lat->stride;
+    lat->spins[0] = (uint64_t*)malloc(count * sizeof(uint64_t));
+    lat->spins[1] = (uint64_t*)malloc(count * sizeof(uint64_t));
+
+    // Bands whose three rows of both colors stay in cache
+    int row_bytes = lat->stride * (int)sizeof(uint64_t);
+    lat->band_rows = ISING_MSC_TILE_BYTES / (4 * row_bytes);
+    if (lat->band_rows < 4) lat->band_rows = 4;
+    lat->band_count = (lat->size + lat->band_rows - 1) / lat->band_rows;
+    lat->rng = (ising_msc_rng_t*)malloc((size_t)lat->band_count * sizeof(ising_msc_rng_t));
+    lat->band_delta = (int64_t(*)[2])malloc((size_t)lat->band_count * sizeof(*lat->band_delta));
+    for (int b = 0; b < lat->band_count; b++) {
+        sim_rng_t stream;
+        sim_rng_init(&stream, seed, SIM_RNG_STREAM_ISING_MSC + (uint64_t)b);
+        for (int i = 0; i < 4; i++) {
+            lat->rng[b].s[i] = sim_rng_u64(&stream);
+        }
+    }
+
+    // Random initial spins
+    for (int color = 0; color < 2; color++) {
+        for (int y = 0; y < lat->size; y++) {
+            uint64_t *row = ising_msc_row(lat, color, y);
+            for (int w = 0; w < lat->words; w++) {
+                row[w] = ising_msc_rng_next(&lat->rng[0]);
+            }
+        }
+        ising_msc_exchange_halos(lat, color);
+    }
+    ising_msc_measure(lat, &lat->energy, &lat->magnetization);
+
+    lat->temperature = -1.0f;
+}
+
+void ising_msc_destroy(ising_msc_t *lat) {
+    if (lat->spins[0]) { free(lat->spins[0]); lat->spins[0] = NULL; }
+    if (lat->spins[1]) { free(lat->spins[1]); lat->spins[1] = NULL; }
+    if (lat->rng) { free(lat->rng); lat->rng = NULL; }
+    if (lat->band_delta) { free(lat->band_delta); lat->band_delta = NULL; }
+    lat->size = 0;
+    lat->band_count = 0;
+}
+
+void ising_msc_set_temperature(ising_msc_t *lat, float temperature) {
+    if (temperature == lat->temperature) {
+        return;
+    }
+    lat->temperature = temperature;
+    for (int i = 0; i < 2; i++) {
+        double p = exp(-4.0 * (i + 1) / (double)temperature);
+        double threshold = p * 4294967296.0;
+        lat->accept[i] = threshold >= 4294967295.0 ? 0xFFFFFFFFu : (uint32_t)threshold;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Sweep
+// -----------------------------------------------------------------------------
+typedef struct ising_msc_sweep_ctx_t {
+    ising_msc_t *lat;
+    int color;
+} ising_msc_sweep_ctx_t;
+
+static void ising_msc_sweep_band(void *ctx, int task, int worker) {
+    (void)worker;
+    ising_msc_sweep_ctx_t *sweep = (ising_msc_sweep_ctx_t*)ctx;
+    ising_msc_t *lat = sweep->lat;
+    const int color = sweep->color;
+    const int words = lat->words;
+    const int stride = lat->stride;
+    const uint32_t accept4 = lat->accept[0];
+    const uint32_t accept8 = lat->accept[1];
+    const int y_end = (task + 1) * lat->band_rows < lat->size ? (task + 1) * lat->band_rows : lat->size;
+    ising_msc_rng_t rng = lat->rng[task];
+    int64_t flips = 0, flips_up = 0, anti = 0;
+
+    for (int y = task * lat->band_rows; y < y_end; y++) {
+        uint64_t *row = ising_msc_row(lat, color, y);
+        const uint64_t *mid = ising_msc_row(lat, color ^ 1, y);
+        const uint64_t *up = mid - stride;
+        const uint64_t *down = mid + stride;
+        // Sites at odd x have their other horizontal neighbor in column k + 1
+        const int odd = (color ^ y) & 1;
+
+        for (int w = 0; w < words; w++) {
+            uint64_t s = row[w];
+            uint64_t side = odd ? (mid[w] >> 1) | (mid[w + 1] << 63)
+                                : (mid[w] << 1) | (mid[w - 1] >> 63);
+
+            // Antiparallel neighbors per lane, summed into ones and carries
+            uint64_t a1 = s ^ up[w], a2 = s ^ down[w], a3 = s ^ mid[w], a4 = s ^ side;
+            uint64_t x1 = a1 ^ a2, c1 = a1 & a2;
+            uint64_t x2 = a3 ^ a4, c2 = a3 & a4;
+            uint64_t ones = x1 ^ x2;
+            uint64_t ge2 = c1 | c2 | (x1 & x2);
+
+            // 2+ antiparallel: deltaE <= 0. One: deltaE = 4. None: deltaE = 8.
+            uint64_t one = ones & ~ge2;
+            uint64_t none = ~(ones | ge2);
+            uint64_t flip = ge2
+                          | ising_msc_bernoulli(&rng, one, accept4)
+                          | ising_msc_bernoulli(&rng, none, accept8);
+            row[w] = s ^ flip;
+
+            // n = ones + 2 (c1 + c2 + x1 x2), and c1 c2 is the only way the
+            // carries reach 2, so summing n over the flipped lanes is three
+            // popcounts
+            flips += ising_msc_popcount(flip);
+            flips_up += ising_msc_popcount(flip & s);
+            anti += ising_msc_popcount(flip & ones)
+                  + 2 * ising_msc_popcount(flip & ge2)
+                  + 2 * ising_msc_popcount(flip & c1 & c2);
+        }
+    }
+    lat->rng[task] = rng;
+    lat->band_delta[task][0] = 8 * flips - 4 * anti;
+    lat->band_delta[task][1] = 2 * (flips - flips_up) - 2 * flips_up;
+}
+
+void ising_msc_sweep(ising_msc_t *lat) {
+    for (int color = 0; color < 2; color++) {
+        ising_msc_sweep_ctx_t ctx = { lat, color };
+        sim_workers_run(ising_msc_sweep_band, &ctx, lat->band_count);
+        ising_msc_exchange_halos(lat, color);
+        for (int b = 0; b < lat->band_count; b++) {
+            lat->energy += lat->band_delta[b][0];
+            lat->magnetization += lat->band_delta[b][1];
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Observables: each bond joins a color 0 site to a color 1 site, so the
+// antiparallel bonds are the XORs of the color 0 words with their four
+// neighbor words. E = (antiparallel - parallel) over the 2N bonds.
+// -----------------------------------------------------------------------------
+void ising_msc_measure(const ising_msc_t *lat, int64_t *energy, int64_t *magnetization) {
+    int64_t anti = 0, up_count = 0;
+    for (int y = 0; y < lat->size; y++) {
+        const uint64_t *s = ising_msc_row(lat, 0, y);
+        const uint64_t *t = ising_msc_row(lat, 1, y);
+        const int odd = y & 1;
+        for (int w = 0; w < lat->words; w++) {
+            uint64_t side = odd ? (t[w] >> 1) | (t[w + 1] << 63)
+                                : (t[w] << 1) | (t[w - 1] >> 63);
+            anti += ising_msc_popcount(s[w] ^ t[w - lat->stride])
+                  + ising_msc_popcount(s[w] ^ t[w + lat->stride])
+                  + ising_msc_popcount(s[w] ^ t[w])
+                  + ising_msc_popcount(s[w] ^ side);
+            up_count += ising_msc_popcount(s[w]) + ising_msc_popcount(t[w]);
+        }
+    }
+    int64_t sites = (int64_t)lat->size * lat->size;
+    *energy = 2 * anti - 2 * sites;
+    *magnetization = 2 * up_count - sites;
+}
+
+int ising_msc_verify(const ising_msc_t *lat) {
+    int64_t energy, magnetization;
+    ising_msc_measure(lat, &energy, &magnetization);
+    return energy == lat->energy && magnetization == lat->magnetization;
+}
+
+// -----------------------------------------------------------------------------
+// Rendering
+// -----------------------------------------------------------------------------
+void ising_msc_render_r8(const ising_msc_t *lat, unsigned char *texels, int tex_size, int block) {
+    if (block == 1) {
+        for (int y = 0; y < lat->size; y++) {
+            unsigned char *dst = texels + (size_t)y * tex_size;
+            for (int color = 0; color < 2; color++) {
+                const uint64_t *row = ising_msc_row(lat, color, y);
+                unsigned char *out = dst + ((color ^ y) & 1);
+                for (int k = 0; k < lat->size / 2; k++) {
+                    out[2 * k] = (unsigned char)(((row[k >> 6] >> (k & 63)) & 1) * 255);
+                }
+            }
+        }
+        return;
+    }
+
+    // A block spans block / 2 bits of each color in every row it covers
+    const int field = block / 2;
+    const uint64_t field_mask = (field >= 64) ? ~0ULL : ((1ULL << field) - 1);
+    const int fields = 64 / field;
+    const int full = block * block;
+    int *counts = (int*)malloc((size_t)tex_size * sizeof(int));
+
+    for (int py = 0; py < tex_size; py++) {
+        memset(counts, 0, (size_t)tex_size * sizeof(int));
+        for (int y = py * block; y < (py + 1) * block && y < lat->size; y++) {
+            for (int color = 0; color < 2; color++) {
+                const uint64_t *row = ising_msc_row(lat, color, y);
+                for (int w = 0; w < lat->words; w++) {
+                    for (int f = 0; f < fields && w * fields + f < tex_size; f++) {
+                        counts[w * fields + f] += ising_msc_popcount((row[w] >> (f * field)) & field_mask);
+                    }
+                }
+            }
+        }
+        unsigned char *dst = texels + (size_t)py * tex_size;
+        for (int px = 0; px < tex_size; px++) {
+            dst[px] = (unsigned char)((counts[px] * 255) / full);
+        }
+    }
+    free(counts);
+}
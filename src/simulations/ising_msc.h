@@ -0,0 +1,71 @@
+#ifndef ISING_MSC_H
+#define ISING_MSC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Multi-spin coded Ising lattice: 64 spins per word
+//
+// Same checkerboard split as ising_lattice.h, but each color row is a bit
+// string (bit set = spin up) of size / 2 bits, so size must be a multiple of
+// 128. Rows carry a halo word on either side and each color a halo row above
+// and below, refreshed after that color is updated.
+//
+// Updating one word of 64 same-colored spins: XOR with the four neighbor
+// words marks the antiparallel bonds, a small adder tree sorts every lane by
+// how many there are (0, 1, or 2 and more), and lanes with 2 or more always
+// flip. The rest flip where a random bit mask is set; the masks come from
+// comparing one random 32-bit number per lane to P(flip) * 2^32 a bit at a
+// time, drawing random words only until every lane is decided.
+//
+// Energy and magnetization are running totals. A flipped lane with n
+// antiparallel neighbors changes the energy by 8 - 4n, and the adder tree
+// already holds n bit-sliced, so each word adds a few popcounts of the flip
+// mask; bands sum their deltas and the sweep adds them in band order.
+// ising_msc_measure recounts from scratch with popcounts.
+// -----------------------------------------------------------------------------
+
+#define ISING_MSC_TILE_BYTES (64 * 1024)
+
+typedef struct ising_msc_rng_t {
+    uint64_t s[4];               // xoshiro256**
+} ising_msc_rng_t;
+
+typedef struct ising_msc_t {
+    int size;                    // Spins per side, a multiple of 128
+    int words;                   // Words of one color per row
+    int stride;                  // words plus the two halo words
+    uint64_t *spins[2];          // Per color: (size + 2) rows of stride words
+    float temperature;           // Temperature the acceptance table is built for
+    uint32_t accept[2];          // P(flip) * 2^32 for deltaE = 4 and 8
+    int band_rows;               // Rows per parallel task
+    int band_count;
+    ising_msc_rng_t *rng;        // One generator per band
+    int64_t (*band_delta)[2];    // Energy and magnetization change per band, last color
+    int64_t energy;              // Running total energy (J = 1)
+    int64_t magnetization;       // Running sum of spins
+} ising_msc_t;
+
+// size is rounded up to a multiple of 128; spins start uniformly random
+void ising_msc_create(ising_msc_t *lat, int size, uint64_t seed);
+void ising_msc_destroy(ising_msc_t *lat);
+
+// Rebuild the acceptance table if the temperature changed
+void ising_msc_set_temperature(ising_msc_t *lat, float temperature);
+
+// One Metropolis sweep: both colors in turn, every site once
+void ising_msc_sweep(ising_msc_t *lat);
+
+// Total energy (J = 1) and sum of spins by a full pass over the lattice
+void ising_msc_measure(const ising_msc_t *lat, int64_t *energy, int64_t *magnetization);
+
+// Nonzero if the running totals agree with a full recount
+int ising_msc_verify(const ising_msc_t *lat);
+
+// Reduce into a tex_size x tex_size R8 image where each texel covers a
+// block x block square (block a power of two <= 64) and holds its fraction
+// of up spins scaled to 0..255
+void ising_msc_render_r8(const ising_msc_t *lat, unsigned char *texels, int tex_size, int block);
+
+#endif /* ISING_MSC_H */
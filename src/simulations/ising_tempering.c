@@ -0,0 +1,122 @@
+#include "ising_tempering.h"
+#include "workers.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// -----------------------------------------------------------------------------
+// Lifetime
+// -----------------------------------------------------------------------------
+void ising_tempering_create(ising_tempering_t *pt, int size, int replica_count,
+                            float t_min, float t_max, uint64_t seed) {
+    memset(pt, 0, sizeof(*pt));
+    if (replica_count < 2) replica_count = 2;
+    if (replica_count > ISING_TEMPERING_MAX_REPLICAS) replica_count = ISING_TEMPERING_MAX_REPLICAS;
+    if (t_max < t_min) { float t = t_min; t_min = t_max; t_max = t; }
+    pt->replica_count = replica_count;
+    sim_rng_init(&pt->rng, seed, SIM_RNG_STREAM_ISING_TEMPERING);
+
+    // One block for the whole ensemble, each replica on its own cache lines
+    size_t replica_bytes = (ising_lattice_bytes(size) + 63) & ~(size_t)63;
+    pt->memory = malloc(replica_bytes * (size_t)replica_count + 63);
+    uint8_t *base = (uint8_t*)(((uintptr_t)pt->memory + 63) & ~(uintptr_t)63);
+
+    for (int r = 0; r < replica_count; r++) {
+        float t = t_min * powf(t_max / t_min, (float)r / (float)(replica_count - 1));
+        ising_lattice_create_in(&pt->replicas[r], size, sim_rng_u64(&pt->rng), base + replica_bytes * r);
+        ising_lattice_set_temperature(&pt->replicas[r], t);
+        pt->temperatures[r] = t;
+        pt->replica_at[r] = r;
+    }
+    pt->size = pt->replicas[0].size;
+}
+
+void ising_tempering_destroy(ising_tempering_t *pt) {
+    for (int r = 0; r < pt->replica_count; r++) {
+        ising_lattice_destroy(&pt->replicas[r]);
+    }
+    if (pt->memory) { free(pt->memory); pt->memory = NULL; }
+    pt->replica_count = 0;
+}
+
+void ising_tempering_reset_averages(ising_tempering_t *pt) {
+    memset(pt->slots, 0, sizeof(pt->slots));
+}
+
+// -----------------------------------------------------------------------------
+// Step
+// -----------------------------------------------------------------------------
+static void ising_tempering_sweep_replica(void *ctx, int task, int worker) {
+    (void)worker;
+    ising_tempering_t *pt = (ising_tempering_t*)ctx;
+    ising_lattice_sweep_checkerboard_serial(&pt->replicas[task]);
+}
+
+static void ising_tempering_swap(ising_tempering_t *pt, int parity) {
+    for (int i = parity; i + 1 < pt->replica_count; i += 2) {
+        int a = pt->replica_at[i], b = pt->replica_at[i + 1];
+        double delta = (1.0 / pt->temperatures[i] - 1.0 / pt->temperatures[i + 1])
+                     * (double)(pt->replicas[a].energy - pt->replicas[b].energy);
+        double u = sim_rng_double(&pt->rng);
+        pt->slots[i].swap_attempts++;
+        if (delta >= 0.0 || u < exp(delta)) {
+            pt->slots[i].swap_accepts++;
+            pt->replica_at[i] = b;
+            pt->replica_at[i + 1] = a;
+            ising_lattice_set_temperature(&pt->replicas[b], pt->temperatures[i]);
+            ising_lattice_set_temperature(&pt->replicas[a], pt->temperatures[i + 1]);
+        }
+    }
+}
+
+void ising_tempering_step(ising_tempering_t *pt, int swap_interval) {
+    sim_workers_run(ising_tempering_sweep_replica, pt, pt->replica_count);
+
+    // Accumulate per temperature, in slot order
+    const double sites = (double)pt->size * pt->size;
+    for (int i = 0; i < pt->replica_count; i++) {
+        const ising_lattice_t *lat = &pt->replicas[pt->replica_at[i]];
+        ising_tempering_slot_t *slot = &pt->slots[i];
+        double e = (double)lat->energy / sites;
+        double m = fabs((double)lat->magnetization) / sites;
+        slot->samples++;
+        double de = e - slot->e_mean;
+        slot->e_mean += de / (double)slot->samples;
+        slot->e_m2 += de * (e - slot->e_mean);
+        double dm = m - slot->m_mean;
+        slot->m_mean += dm / (double)slot->samples;
+        slot->m_m2 += dm * (m - slot->m_mean);
+    }
+
+    pt->steps++;
+    if (swap_interval < 1) swap_interval = 1;
+    if (pt->steps % (uint64_t)swap_interval == 0) {
+        ising_tempering_swap(pt, (int)((pt->steps / (uint64_t)swap_interval) & 1));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Queries
+// -----------------------------------------------------------------------------
+int ising_tempering_nearest_slot(const ising_tempering_t *pt, float t) {
+    int best = 0;
+    for (int i = 1; i < pt->replica_count; i++) {
+        if (fabsf(pt->temperatures[i] - t) < fabsf(pt->temperatures[best] - t)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+void ising_tempering_observables(const ising_tempering_t *pt, int slot,
+                                 float *e, float *m, float *chi, float *c) {
+    const ising_tempering_slot_t *s = &pt->slots[slot];
+    const double sites = (double)pt->size * pt->size;
+    const double t = pt->temperatures[slot];
+    double var_e = s->samples > 1 ? s->e_m2 / (double)(s->samples - 1) : 0.0;
+    double var_m = s->samples > 1 ? s->m_m2 / (double)(s->samples - 1) : 0.0;
+    *e = (float)s->e_mean;
+    *m = (float)s->m_mean;
+    *chi = (float)(sites * var_m / t);
+    *c = (float)(sites * var_e / (t * t));
+}
@@ -0,0 +1,64 @@
+#ifndef ISING_TEMPERING_H
+#define ISING_TEMPERING_H
+
+#include "ising_lattice.h"
+#include "rng.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Parallel tempering (replica exchange) over a temperature ladder
+//
+// R int8 lattices (see ising_lattice.h) live back to back in one block, each
+// one a cache-line aligned slice holding its generators and both colors. A
+// step sweeps every replica as its own task on the worker pool, each keeping
+// its own running energy and magnetization; every swap_interval steps
+// neighboring temperatures attempt to exchange replicas with probability
+// min(1, exp((1/T_i - 1/T_j)(E_i - E_j))), pairs alternating between even
+// and odd so each attempt is independent. Swaps only relabel which replica
+// holds which temperature; no spins move.
+//
+// Averages are kept per temperature slot: energy and |M| per spin, from which
+// susceptibility chi = N var(|m|) / T and specific heat C = N var(e) / T^2.
+// -----------------------------------------------------------------------------
+
+#define ISING_TEMPERING_MAX_REPLICAS 64
+
+typedef struct ising_tempering_slot_t {
+    uint64_t samples;
+    double e_mean, e_m2;         // Welford running mean / sum of squares, E / N
+    double m_mean, m_m2;         // Same for |M| / N
+    uint64_t swap_attempts;      // With the next slot up
+    uint64_t swap_accepts;
+} ising_tempering_slot_t;
+
+typedef struct ising_tempering_t {
+    int size;
+    int replica_count;
+    void *memory;                // Raw allocation behind the replica block
+    ising_lattice_t replicas[ISING_TEMPERING_MAX_REPLICAS];
+    float temperatures[ISING_TEMPERING_MAX_REPLICAS];    // Ladder, ascending
+    int replica_at[ISING_TEMPERING_MAX_REPLICAS];        // Replica holding each slot
+    ising_tempering_slot_t slots[ISING_TEMPERING_MAX_REPLICAS];
+    uint64_t steps;
+    sim_rng_t rng;               // Replica seeds, then the swap decisions
+} ising_tempering_t;
+
+// Geometric ladder of replica_count temperatures from t_min to t_max
+void ising_tempering_create(ising_tempering_t *pt, int size, int replica_count,
+                            float t_min, float t_max, uint64_t seed);
+void ising_tempering_destroy(ising_tempering_t *pt);
+
+// Sweep every replica, then attempt swaps every swap_interval steps
+void ising_tempering_step(ising_tempering_t *pt, int swap_interval);
+
+void ising_tempering_reset_averages(ising_tempering_t *pt);
+
+// Slot whose temperature is closest to t
+int ising_tempering_nearest_slot(const ising_tempering_t *pt, float t);
+
+// Averages at one slot: e = <E>/N, m = <|M|>/N, susceptibility, specific heat
+void ising_tempering_observables(const ising_tempering_t *pt, int slot,
+                                 float *e, float *m, float *chi, float *c);
+
+#endif /* ISING_TEMPERING_H */
@@ -0,0 +1,145 @@
+#include "lattice_view.h"
+#include "gpu_cache.h"
+#include <string.h>
+
+// Uniform block for the palette pass
+typedef struct {
+    float low[4];
+    float high[4];
+} lattice_view_uniforms_t;
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer needed
+static const char *lattice_view_vs_src =
+    "#version 300 es\n"
+    "precision mediump float;\n"
+    "out vec2 uv;\n"
+    "void main() {\n"
+    "  vec2 p = vec2(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0);\n"
+    "  uv = p * 0.5 + 0.5;\n"
+    "  gl_Position = vec4(p, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *lattice_view_fs_src =
+    "#version 300 es\n"
+    "precision mediump float;\n"
+    "uniform vec4 u_low;\n"
+    "uniform vec4 u_high;\n"
+    "uniform sampler2D u_state;\n"
+    "in vec2 uv;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "  frag_color = mix(u_low, u_high, texture(u_state, uv).r);\n"
+    "}\n";
+
+void lattice_view_create(lattice_view_t *view, int width, int height,
+                         const float low[4], const float high[4]) {
+    memset(view, 0, sizeof(*view));
+    view->width = width;
+    view->height = height;
+    memcpy(view->palette[0], low, sizeof(view->palette[0]));
+    memcpy(view->palette[1], high, sizeof(view->palette[1]));
+
+    // One byte per cell, uploaded by the simulation
+    view->state_img = sim_gpu_image_acquire(&(sg_image_desc){
+        .width = width,
+        .height = height,
+        .pixel_format = SG_PIXELFORMAT_R8,
+        .usage = SG_USAGE_DYNAMIC,
+    });
+    view->state_smp = sim_gpu_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+    });
+
+    // Palette-mapped target at the lattice resolution
+    view->color_img = sim_gpu_image_acquire(&(sg_image_desc){
+        .render_target = true,
+        .width = width,
+        .height = height,
+        .pixel_format = SG_PIXELFORMAT_RGBA8,
+        .sample_count = 1,
+    });
+    view->color_smp = sim_gpu_sampler(&(sg_sampler_desc){
+        .min_filter = SG_FILTER_NEAREST,
+        .mag_filter = SG_FILTER_NEAREST,
+        .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+        .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+    });
+    view->attachments = sim_gpu_attachments(&(sg_attachments_desc){
+        .colors[0].image = view->color_img,
+    });
+
+    view->shader = sim_gpu_shader(&(sg_shader_desc){
+        .vertex_func = { .source = lattice_view_vs_src, .entry = "main" },
+        .fragment_func = { .source = lattice_view_fs_src, .entry = "main" },
+        .uniform_blocks[0] = {
+            .stage = SG_SHADERSTAGE_FRAGMENT,
+            .size = sizeof(lattice_view_uniforms_t),
+            .glsl_uniforms = {
+                [0] = { .type = SG_UNIFORMTYPE_FLOAT4, .glsl_name = "u_low" },
+                [1] = { .type = SG_UNIFORMTYPE_FLOAT4, .glsl_name = "u_high" },
+            }
+        },
+        .images[0] = {
+            .stage = SG_SHADERSTAGE_FRAGMENT,
+            .image_type = SG_IMAGETYPE_2D,
+            .sample_type = SG_IMAGESAMPLETYPE_FLOAT,
+        },
+        .samplers[0] = {
+            .stage = SG_SHADERSTAGE_FRAGMENT,
+            .sampler_type = SG_SAMPLERTYPE_FILTERING,
+        },
+        .image_sampler_pairs[0] = {
+            .stage = SG_SHADERSTAGE_FRAGMENT,
+            .image_slot = 0,
+            .sampler_slot = 0,
+            .glsl_name = "u_state",
+        },
+        .label = "Lattice Palette Shader"
+    });
+
+    view->pip = sim_gpu_pipeline(&(sg_pipeline_desc){
+        .shader = view->shader,
+        .primitive_type = SG_PRIMITIVETYPE_TRIANGLES,
+        .colors[0].pixel_format = SG_PIXELFORMAT_RGBA8,
+        .depth.pixel_format = SG_PIXELFORMAT_NONE,
+        .sample_count = 1,
+    });
+}
+
+// Only the images go back to the pool; the rest is shared through the cache
+void lattice_view_destroy(lattice_view_t *view) {
+    sim_gpu_image_release(view->color_img);
+    sim_gpu_image_release(view->state_img);
+    memset(view, 0, sizeof(*view));
+}
+
+void lattice_view_update(lattice_view_t *view, const uint8_t *state) {
+    sg_update_image(view->state_img, &(sg_image_data){
+        .subimage[0][0] = {
+            .ptr = state,
+            .size = (size_t)view->width * view->height
+        }
+    });
+
+    lattice_view_uniforms_t uniforms;
+    memcpy(uniforms.low, view->palette[0], sizeof(uniforms.low));
+    memcpy(uniforms.high, view->palette[1], sizeof(uniforms.high));
+
+    sg_begin_pass(&(sg_pass){
+        .action = {
+            .colors[0] = { .load_action = SG_LOADACTION_DONTCARE, .store_action = SG_STOREACTION_STORE }
+        },
+        .attachments = view->attachments
+    });
+    sg_apply_pipeline(view->pip);
+    sg_apply_bindings(&(sg_bindings){
+        .images[0] = view->state_img,
+        .samplers[0] = view->state_smp,
+    });
+    sg_apply_uniforms(0, &SG_RANGE(uniforms));
+    sg_draw(0, 3, 1);
+    sg_end_pass();
+}
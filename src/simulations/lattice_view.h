@@ -0,0 +1,37 @@
+#ifndef LATTICE_VIEW_H
+#define LATTICE_VIEW_H
+
+#include "sokol_gfx.h"
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Lattice view: one byte of state per cell on the GPU
+//
+// The simulation uploads a single-channel R8 texture and a small offscreen
+// pass maps it through a two-color palette (mix(low, high, value)) into an
+// RGBA8 render target that ImGui can display. No RGBA is built on the CPU.
+// All GPU objects come from the shared cache (gpu_cache.h), so recreating a
+// view of a size seen before compiles and allocates nothing.
+// -----------------------------------------------------------------------------
+
+typedef struct lattice_view_t {
+    int width, height;
+    sg_image state_img;          // R8 lattice state, updated once per frame
+    sg_sampler state_smp;
+    sg_image color_img;          // Palette-mapped RGBA8 target shown in ImGui
+    sg_sampler color_smp;
+    sg_attachments attachments;
+    sg_shader shader;
+    sg_pipeline pip;
+    float palette[2][4];         // Colors for state 0 and state 255
+} lattice_view_t;
+
+void lattice_view_create(lattice_view_t *view, int width, int height,
+                         const float low[4], const float high[4]);
+void lattice_view_destroy(lattice_view_t *view);
+
+// Upload width x height bytes of state and run the palette pass. Call at
+// most once per frame (sg_update_image may only touch an image once).
+void lattice_view_update(lattice_view_t *view, const uint8_t *state);
+
+#endif /* LATTICE_VIEW_H */
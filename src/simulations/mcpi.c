@@ -1,5 +1,11 @@
 #include "mcpi.h"
 #include "simulations.h"
+#include "rng.h"
+#include "mcpi_batch.h"
+#include "mcpi_parallel.h"
+#include "workers.h"
+#include "sokol_time.h"
+#ifndef SIM_HEADLESS
 #ifndef CIMGUI_DEFINE_ENUMS_AND_STRUCTS
     #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #endif
@@ -9,7 +15,9 @@
 #include "sokol_app.h"
 #include "./util/sokol_imgui.h"
 #include "sokol_glue.h"
+#endif
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #ifndef M_PI
@@ -18,121 +26,372 @@
 
 // A simulation that estimates Pi by a random sampling of numbers in a box, checks if it's bounded by a radius <1
 
-#define MCPI_MAX_POINTS 10000
+#define MCPI_MAX_POINTS 100000
+#define MCPI_HIST_SIZE 64           // Histogram cells per side
 
 /* Monte Carlo Pi simulation globals */
 static int mcpi_max_points = 1000;  // parameter: maximum points to use (slider)
 static int mcpi_points_count = 0;
 static int mcpi_points_inside = 0;
 
-static float mcpi_x_data[MCPI_MAX_POINTS];
-static float mcpi_y_data[MCPI_MAX_POINTS];
-static int   mcpi_in_circle[MCPI_MAX_POINTS]; // 1 if inside the circle, 0 otherwise
+/* Points are not kept: each one lands in a cell of a fixed 2D histogram with
+   separate outside [0] and inside [1] counts, row 0 at the top (y = 1) */
+static uint32_t mcpi_hist[2][MCPI_HIST_SIZE * MCPI_HIST_SIZE];
+
+static sim_rng_t mcpi_rng;            // Restarted from the global seed on reset
+
+/* Modes: one point per frame binned into the hit histogram shown as a
+   heatmap, or counters only with as many points per frame as the time
+   budget allows, on one thread (see mcpi_batch.h) or sharded over the
+   worker pool (see mcpi_parallel.h) */
+typedef enum { MCPI_MODE_HEATMAP, MCPI_MODE_BATCHED, MCPI_MODE_PARALLEL, MCPI_MODE_COUNT } mcpi_mode_t;
+static int mcpi_mode = MCPI_MODE_HEATMAP;
+
+/* Batched mode runs one sampler, or all of them side by side with the same
+   number of points so their error curves line up (see mcpi_qmc.h) */
+static int mcpi_sampler = MCPI_SAMPLER_RANDOM;
+static bool mcpi_compare = true;            // Run every sampler, overlay their errors
+
+static mcpi_batch_t mcpi_batch[MCPI_SAMPLER_COUNT];
+static float mcpi_frame_budget_ms = 8.0f;   // parameter: kernel time per frame
+static int mcpi_update_chunks = 0;          // parameter: fixed chunks or rounds per update, 0 for the budget
+#define MCPI_CHUNK_POINTS (1 << 16)         // Points per sampler between clock checks
+static double mcpi_samples_per_sec = 0.0;   // Kernel throughput, smoothed
+static uint64_t mcpi_frame_samples = 0;
 
-static float mcpi_time_data[MCPI_MAX_POINTS];
-static float mcpi_pi_estimate_data[MCPI_MAX_POINTS];
+/* Parallel mode: one shard per worker thread, restarted when the thread
+   count changes. Scaling efficiency compares the wall-clock rate with the
+   single-thread rate times the thread count. */
+static mcpi_parallel_t mcpi_par;
+#define MCPI_ROUND_POINTS (1 << 18)         // Points per shard per round
+static double mcpi_shard_per_sec[SIM_WORKERS_MAX];   // Smoothed per shard
+static double mcpi_single_per_sec = 0.0;    // Calibrated on the calling thread
 
-static sim_parameter_t mcpi_params[] = {
-    { "Number of Points", &mcpi_max_points, SIM_PARAM_INT, 0, 0, 100, MCPI_MAX_POINTS }
+/* Estimate, its standard error and the actual error, against samples drawn
+   in batched mode and against time in heatmap mode */
+enum { MCPI_SERIES_ESTIMATE, MCPI_SERIES_STD_ERROR, MCPI_SERIES_ABS_ERROR, MCPI_SERIES_COUNT };
+static sim_series_t mcpi_pi_series;
+static sim_series_t mcpi_error_series[MCPI_SAMPLER_COUNT];   // |estimate - Pi| per sampler
+
+/* Every setting by name (see simulations.h), also drawn by the parameters
+   UI; Mode is MCPI_MODE_*, Sampler MCPI_SAMPLER_*. A fixed chunk count makes
+   runs repeatable. */
+enum {
+    MCPI_SETTING_MODE, MCPI_SETTING_SAMPLER, MCPI_SETTING_COMPARE, MCPI_SETTING_POINTS,
+    MCPI_SETTING_BUDGET, MCPI_SETTING_CHUNKS, MCPI_SETTING_COUNT
+};
+static sim_parameter_t mcpi_settings[MCPI_SETTING_COUNT] = {
+    [MCPI_SETTING_MODE]    = { "Mode",                 &mcpi_mode,            SIM_PARAM_INT,   0, 0, 0, MCPI_MODE_COUNT - 1 },
+    [MCPI_SETTING_SAMPLER] = { "Sampler",              &mcpi_sampler,         SIM_PARAM_INT,   0, 0, 0, MCPI_SAMPLER_COUNT - 1 },
+    [MCPI_SETTING_COMPARE] = { "Compare All Samplers", &mcpi_compare,         SIM_PARAM_BOOL,  0, 0, 0, 0 },
+    [MCPI_SETTING_POINTS]  = { "Number of Points",     &mcpi_max_points,      SIM_PARAM_INT,   0, 0, 100, MCPI_MAX_POINTS },
+    [MCPI_SETTING_BUDGET]  = { "Frame Budget (ms)",    &mcpi_frame_budget_ms, SIM_PARAM_FLOAT, 0.5f, 50.0f, 0, 0 },
+    [MCPI_SETTING_CHUNKS]  = { "Chunks per Update",    &mcpi_update_chunks,   SIM_PARAM_INT,   0, 0, 0, 256 }
 };
 
-/* Initialization: reset counters and seed random generator */
-void sim_mcpi_init(void) {
+/* Restart both modes from the global seed */
+static void mcpi_reset(void) {
     mcpi_points_count = 0;
     mcpi_points_inside = 0;
-    srand((unsigned int)time(NULL));
-    // Optionally clear data arrays
-    for (int i = 0; i < MCPI_MAX_POINTS; i++) {
-        mcpi_x_data[i] = 0.0f;
-        mcpi_y_data[i] = 0.0f;
-        mcpi_in_circle[i] = 0;
-        mcpi_time_data[i] = 0.0f;
-        mcpi_pi_estimate_data[i] = 0.0f;
+    sim_rng_init(&mcpi_rng, sim_rng_seed(), SIM_RNG_STREAM_MCPI);
+    for (int s = 0; s < MCPI_SAMPLER_COUNT; s++) {
+        mcpi_batch_init(&mcpi_batch[s], (mcpi_sampler_t)s, sim_rng_seed());
+        sim_series_init(&mcpi_error_series[s], 1);
+    }
+    mcpi_parallel_init(&mcpi_par, sim_rng_seed(), sim_workers_count(), MCPI_ROUND_POINTS);
+    memset(mcpi_shard_per_sec, 0, sizeof(mcpi_shard_per_sec));
+    mcpi_single_per_sec = 0.0;
+    mcpi_samples_per_sec = 0.0;
+    mcpi_frame_samples = 0;
+    sim_series_init(&mcpi_pi_series, MCPI_SERIES_COUNT);
+    memset(mcpi_hist, 0, sizeof(mcpi_hist));
+}
+
+static void mcpi_push_estimate(double x, double pi, double std_error) {
+    float values[MCPI_SERIES_COUNT] = { (float)pi, (float)std_error, (float)fabs(pi - M_PI) };
+    sim_series_push(&mcpi_pi_series, x, values);
+}
+
+/* Initialization: reset counters and seed random generator */
+void sim_mcpi_init(void) {
+    mcpi_reset();
+}
+
+static double mcpi_smooth(double average, double value) {
+    return (average > 0.0) ? 0.9 * average + 0.1 * value : value;
+}
+
+/* Whether an update that ran `count` chunks (or rounds) in `ms` is done */
+static bool mcpi_update_done(int count, double ms) {
+    return mcpi_update_chunks > 0 ? count >= mcpi_update_chunks : ms >= mcpi_frame_budget_ms;
+}
+
+/* Batched update: whole chunks until the frame budget is spent; when
+   comparing, every sampler draws each chunk so all stay at the same count */
+static void mcpi_update_batched(void) {
+    mcpi_batch_t *batch = &mcpi_batch[mcpi_sampler];
+    uint64_t start = stm_now();
+    uint64_t before = batch->samples;
+    double ms;
+    int chunks = 0;
+    do {
+        for (int s = 0; s < MCPI_SAMPLER_COUNT; s++) {
+            if (s == mcpi_sampler || mcpi_compare) {
+                mcpi_batch_run(&mcpi_batch[s], MCPI_CHUNK_POINTS);
+            }
+        }
+        ms = stm_ms(stm_since(start));
+    } while (!mcpi_update_done(++chunks, ms));
+    mcpi_frame_samples = (batch->samples - before) * (mcpi_compare ? MCPI_SAMPLER_COUNT : 1);
+    double rate = (double)mcpi_frame_samples / (ms * 1e-3);
+    mcpi_samples_per_sec = mcpi_smooth(mcpi_samples_per_sec, rate);
+
+    double pi, std_error;
+    mcpi_batch_estimate(batch, &pi, &std_error);
+    mcpi_push_estimate((double)batch->samples, pi, std_error);
+    for (int s = 0; s < MCPI_SAMPLER_COUNT; s++) {
+        if (s == mcpi_sampler || mcpi_compare) {
+            mcpi_batch_estimate(&mcpi_batch[s], &pi, &std_error);
+            float error = (float)fabs(pi - M_PI);
+            sim_series_push(&mcpi_error_series[s], (double)mcpi_batch[s].samples, &error);
+        }
+    }
+}
+
+/* Parallel update: whole rounds until the frame budget is spent. The first
+   frame also times one shard's worth of points on this thread alone. */
+static void mcpi_update_parallel(void) {
+    if (mcpi_par.shard_count != sim_workers_count()) {
+        mcpi_reset();
+    }
+    if (mcpi_single_per_sec == 0.0) {
+        mcpi_batch_t scratch;
+        mcpi_batch_init(&scratch, MCPI_SAMPLER_RANDOM, sim_rng_seed());
+        uint64_t start = stm_now();
+        mcpi_batch_run(&scratch, MCPI_ROUND_POINTS);
+        mcpi_single_per_sec = (double)scratch.samples / stm_sec(stm_since(start));
+    }
+
+    uint64_t shard_samples[SIM_WORKERS_MAX];
+    double shard_seconds[SIM_WORKERS_MAX];
+    for (int s = 0; s < mcpi_par.shard_count; s++) {
+        shard_samples[s] = mcpi_par.shards[s].batch.samples;
+        shard_seconds[s] = mcpi_par.shards[s].seconds;
+    }
+    uint64_t start = stm_now();
+    uint64_t before = mcpi_par.samples;
+    double ms;
+    int rounds = 0;
+    do {
+        mcpi_parallel_run(&mcpi_par);
+        ms = stm_ms(stm_since(start));
+    } while (!mcpi_update_done(++rounds, ms));
+    mcpi_frame_samples = mcpi_par.samples - before;
+    mcpi_samples_per_sec = mcpi_smooth(mcpi_samples_per_sec, (double)mcpi_frame_samples / (ms * 1e-3));
+    for (int s = 0; s < mcpi_par.shard_count; s++) {
+        const mcpi_shard_t *shard = &mcpi_par.shards[s];
+        double seconds = shard->seconds - shard_seconds[s];
+        if (seconds > 0.0) {
+            mcpi_shard_per_sec[s] = mcpi_smooth(mcpi_shard_per_sec[s], (double)(shard->batch.samples - shard_samples[s]) / seconds);
+        }
     }
+
+    double pi, std_error;
+    mcpi_parallel_estimate(&mcpi_par, &pi, &std_error);
+    mcpi_push_estimate((double)mcpi_par.samples, pi, std_error);
 }
 
 /* Update: add one new random point and update the π estimate */
 void sim_mcpi_update(float dt) {
+    if (mcpi_mode == MCPI_MODE_BATCHED) {
+        mcpi_update_batched();
+        return;
+    }
+    if (mcpi_mode == MCPI_MODE_PARALLEL) {
+        mcpi_update_parallel();
+        return;
+    }
     if (mcpi_points_count < mcpi_max_points) {
-        float x = (float)rand() / (float)RAND_MAX;
-        float y = (float)rand() / (float)RAND_MAX;
-        mcpi_x_data[mcpi_points_count] = x;
-        mcpi_y_data[mcpi_points_count] = y;
+        float x = sim_rng_float(&mcpi_rng);
+        float y = sim_rng_float(&mcpi_rng);
         int inside = (x * x + y * y <= 1.0f) ? 1 : 0;
-        mcpi_in_circle[mcpi_points_count] = inside;
+        int column = (int)(x * MCPI_HIST_SIZE);
+        int row = MCPI_HIST_SIZE - 1 - (int)(y * MCPI_HIST_SIZE);
+        mcpi_hist[inside][row * MCPI_HIST_SIZE + column]++;
         if (inside) {
             mcpi_points_inside++;
         }
         mcpi_points_count++;
-        float pi_estimate = 4.0f * ((float)mcpi_points_inside / (float)mcpi_points_count);
-        mcpi_pi_estimate_data[mcpi_points_count - 1] = pi_estimate;
-        mcpi_time_data[mcpi_points_count - 1] = mcpi_points_count * dt;
+        double p = (double)mcpi_points_inside / (double)mcpi_points_count;
+        mcpi_push_estimate(mcpi_points_count * dt, 4.0 * p, 4.0 * sqrt(p * (1.0 - p) / mcpi_points_count));
     }
 }
 
+sim_parameter_t *sim_mcpi_settings(int16_t *count) {
+    *count = MCPI_SETTING_COUNT;
+    return mcpi_settings;
+}
+
+/* Observables: the current mode's sample count, estimate and errors */
+int sim_mcpi_observe(sim_observable_t *out) {
+    double samples, pi, std_error;
+    if (mcpi_mode == MCPI_MODE_PARALLEL) {
+        samples = (double)mcpi_par.samples;
+        mcpi_parallel_estimate(&mcpi_par, &pi, &std_error);
+    } else if (mcpi_mode == MCPI_MODE_BATCHED) {
+        samples = (double)mcpi_batch[mcpi_sampler].samples;
+        mcpi_batch_estimate(&mcpi_batch[mcpi_sampler], &pi, &std_error);
+    } else {
+        samples = mcpi_points_count;
+        double p = mcpi_points_count > 0 ? (double)mcpi_points_inside / mcpi_points_count : 0.0;
+        pi = 4.0 * p;
+        std_error = mcpi_points_count > 0 ? 4.0 * sqrt(p * (1.0 - p) / mcpi_points_count) : 0.0;
+    }
+    out[0] = (sim_observable_t){ "samples", samples };
+    out[1] = (sim_observable_t){ "estimate", pi };
+    out[2] = (sim_observable_t){ "std_error", std_error };
+    out[3] = (sim_observable_t){ "abs_error", fabs(pi - M_PI) };
+    return 4;
+}
+
+#ifndef SIM_HEADLESS
+/* UI state; the rest of the file, up to destroy, is compiled out of headless builds */
+static const char *mcpi_mode_names[MCPI_MODE_COUNT] = { "Heatmap (1 point/frame)", "Batched", "Parallel" };
+static const char *mcpi_sampler_names[MCPI_SAMPLER_COUNT] = { "Pseudo-random", "Sobol (Owen)", "Halton (Owen)", "Stratified jittered" };
+static float mcpi_hist_values[MCPI_HIST_SIZE * MCPI_HIST_SIZE];
+
 /* UI: Parameters slider and reset button */
 void sim_mcpi_params_ui(void) {
     if (igButton("Reset Simulation", (ImVec2){0,0})) {
-        mcpi_points_count = 0;
-        mcpi_points_inside = 0;
-        for (int i = 0; i < MCPI_MAX_POINTS; i++) {
-            mcpi_x_data[i] = 0.0f;
-            mcpi_y_data[i] = 0.0f;
-            mcpi_in_circle[i] = 0;
-            mcpi_time_data[i] = 0.0f;
-            mcpi_pi_estimate_data[i] = 0.0f;
+        mcpi_reset();
+    }
+    if (igCombo_Str_arr("Mode", &mcpi_mode, mcpi_mode_names, MCPI_MODE_COUNT, -1)) {
+        mcpi_reset();
+    }
+    if (mcpi_mode == MCPI_MODE_BATCHED) {
+        if (igCombo_Str_arr("Sampler", &mcpi_sampler, mcpi_sampler_names, MCPI_SAMPLER_COUNT, -1)) {
+            mcpi_reset();
         }
+        if (igCheckbox("Compare All Samplers", &mcpi_compare)) {
+            mcpi_reset();
+        }
+    }
+    if (mcpi_mode != MCPI_MODE_HEATMAP) {
+        simulations_draw_params(&mcpi_settings[MCPI_SETTING_BUDGET], 2);    // And Chunks per Update
+    } else {
+        simulations_draw_params(&mcpi_settings[MCPI_SETTING_POINTS], 1);
     }
-    simulations_draw_params(mcpi_params, 1);
 }
 
 /* Plot UI: display a time-series of the current π estimate versus actual π */
 void sim_mcpi_plot_ui(void) {
-    if (mcpi_points_count < 2)
+    double min_time, max_time;
+    if (!sim_series_x_range(&mcpi_pi_series, &min_time, &max_time))
         return;
-
-    float max_time = mcpi_time_data[mcpi_points_count - 1];
-    float min_time = 0.0f;
+    if (mcpi_mode != MCPI_MODE_HEATMAP) {
+        // Against samples drawn: the pseudo-random error falls as 1/sqrt(N),
+        // the quasi-random and stratified ones close to 1/N
+        if (ImPlot_BeginPlot("Pi Estimate vs Samples", (ImVec2){0,0}, ImPlotFlags_None)) {
+            ImPlot_SetupAxes("samples", NULL, ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot_SetupAxisScale_PlotScale(ImAxis_X1, ImPlotScale_Log10);
+            sim_series_plot_line(&mcpi_pi_series, MCPI_SERIES_ESTIMATE, "Estimated Pi");
+            double constant_x[2] = {min_time, max_time};
+            double constant_y[2] = {M_PI, M_PI};
+            ImPlot_PlotLine_doublePtrdoublePtr("Actual Pi", constant_x, constant_y, 2, 0, 0, sizeof(double));
+            ImPlot_EndPlot();
+        }
+        if (ImPlot_BeginPlot("Error vs Samples", (ImVec2){0,0}, ImPlotFlags_None)) {
+            ImPlot_SetupAxes("samples", "error", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot_SetupAxisScale_PlotScale(ImAxis_X1, ImPlotScale_Log10);
+            ImPlot_SetupAxisScale_PlotScale(ImAxis_Y1, ImPlotScale_Log10);
+            sim_series_plot_line(&mcpi_pi_series, MCPI_SERIES_STD_ERROR, "Standard Error (pseudo-random)");
+            if (mcpi_mode == MCPI_MODE_BATCHED) {
+                for (int s = 0; s < MCPI_SAMPLER_COUNT; s++) {
+                    if (s == mcpi_sampler || mcpi_compare) {
+                        sim_series_plot_line(&mcpi_error_series[s], 0, mcpi_sampler_names[s]);
+                    }
+                }
+            } else {
+                sim_series_plot_line(&mcpi_pi_series, MCPI_SERIES_ABS_ERROR, "|Estimate - Pi|");
+            }
+            ImPlot_EndPlot();
+        }
+        return;
+    }
     // Set y-axis limits to cover the expected π range (around 3.14)
     ImPlot_SetNextAxesLimits(min_time, max_time, 2.5f, 4.0f, ImPlotCond_Always);
     if (ImPlot_BeginPlot("Pi Estimate Over Time", (ImVec2){0,0}, ImPlotFlags_None)) {
-        ImPlot_PlotLine_FloatPtrFloatPtr("Estimated Pi", mcpi_time_data, mcpi_pi_estimate_data, mcpi_points_count, 0, 0, sizeof(float));
+        sim_series_plot_line(&mcpi_pi_series, 0, "Estimated Pi");
         // Plot a constant line for actual Pi
-        float constant_x[2] = {min_time, max_time};
-        float constant_y[2] = {M_PI, M_PI};
-        ImPlot_PlotLine_FloatPtrFloatPtr("Actual Pi", constant_x, constant_y, 2, 0, 0, sizeof(float));
+        double constant_x[2] = {min_time, max_time};
+        double constant_y[2] = {M_PI, M_PI};
+        ImPlot_PlotLine_doublePtrdoublePtr("Actual Pi", constant_x, constant_y, 2, 0, 0, sizeof(double));
         ImPlot_EndPlot();
     }
 }
 
-/* Render UI: display a 2D scatter plot of the points colored by in-circle status */
+/* Render UI: the hit histogram as one heatmap, blue inside the circle and red
+   outside, shaded by density relative to a uniform fill; the cost depends on
+   the histogram size only, not on the number of points */
 void sim_mcpi_render(void) {
-    if (mcpi_points_count < 1)
+    if (mcpi_mode == MCPI_MODE_PARALLEL) {
+        double pi, std_error;
+        mcpi_parallel_estimate(&mcpi_par, &pi, &std_error);
+        int threads = mcpi_par.shard_count;
+        igText("Threads: %d", threads);
+        igText("Samples: %.4g", (double)mcpi_par.samples);
+        igText("Pi = %.9f +/- %.2g", pi, std_error);
+        igText("Error: %.2g (%.1f standard errors)", fabs(pi - M_PI), std_error > 0.0 ? fabs(pi - M_PI) / std_error : 0.0);
+        igText("Throughput: %.1f M samples/s, %.3g per frame", mcpi_samples_per_sec * 1e-6, (double)mcpi_frame_samples);
+        igText("Single thread: %.1f M samples/s, scaling efficiency %.0f%%", mcpi_single_per_sec * 1e-6,
+               mcpi_single_per_sec > 0.0 ? 100.0 * mcpi_samples_per_sec / (threads * mcpi_single_per_sec) : 0.0);
+        for (int s = 0; s < threads; s++) {
+            igText("  Thread %d: %.1f M samples/s", s, mcpi_shard_per_sec[s] * 1e-6);
+        }
         return;
-
-    if (ImPlot_BeginPlot("Monte Carlo Scatter", (ImVec2){256,256}, ImPlotFlags_None)) {
-        // Separate points into "inside" and "outside" arrays
-        static float inside_x[MCPI_MAX_POINTS], inside_y[MCPI_MAX_POINTS];
-        static float outside_x[MCPI_MAX_POINTS], outside_y[MCPI_MAX_POINTS];
-        int inside_count = 0, outside_count = 0;
-        for (int i = 0; i < mcpi_points_count; i++) {
-            if (mcpi_in_circle[i]) {
-                inside_x[inside_count] = mcpi_x_data[i];
-                inside_y[inside_count] = mcpi_y_data[i];
-                inside_count++;
-            } else {
-                outside_x[outside_count] = mcpi_x_data[i];
-                outside_y[outside_count] = mcpi_y_data[i];
-                outside_count++;
+    }
+    if (mcpi_mode == MCPI_MODE_BATCHED) {
+        const mcpi_batch_t *batch = &mcpi_batch[mcpi_sampler];
+        double pi, std_error;
+        mcpi_batch_estimate(batch, &pi, &std_error);
+        igText("Sampler: %s", mcpi_sampler_names[mcpi_sampler]);
+        igText("Samples: %.4g", (double)batch->samples);
+        igText("Pi = %.9f +/- %.2g", pi, std_error);
+        igText("Error: %.2g (%.1f standard errors)", fabs(pi - M_PI), std_error > 0.0 ? fabs(pi - M_PI) / std_error : 0.0);
+        igText("Throughput: %.1f M samples/s, %.3g per frame", mcpi_samples_per_sec * 1e-6, (double)mcpi_frame_samples);
+        if (mcpi_compare) {
+            // Error relative to the pseudo-random baseline at the same N
+            double pi_random, error_random;
+            mcpi_batch_estimate(&mcpi_batch[MCPI_SAMPLER_RANDOM], &pi_random, &error_random);
+            for (int s = MCPI_SAMPLER_RANDOM + 1; s < MCPI_SAMPLER_COUNT; s++) {
+                mcpi_batch_estimate(&mcpi_batch[s], &pi, &std_error);
+                double error = fabs(pi - M_PI);
+                igText("%s: error %.2g, %.3gx below the baseline std error", mcpi_sampler_names[s], error,
+                       error > 0.0 ? error_random / error : 0.0);
             }
         }
-        // Plot the points: points inside the circle and those outside
-        ImPlot_PlotScatter_FloatPtrFloatPtr("Inside", inside_x, inside_y, inside_count, 0, 0, sizeof(float));
-        ImPlot_PlotScatter_FloatPtrFloatPtr("Outside", outside_x, outside_y, outside_count, 0, 0, sizeof(float));
+        return;
+    }
+    if (mcpi_points_count < 1)
+        return;
+
+    const int cells = MCPI_HIST_SIZE * MCPI_HIST_SIZE;
+    const float scale = (float)cells / (float)mcpi_points_count;
+    for (int i = 0; i < cells; i++) {
+        mcpi_hist_values[i] = ((float)mcpi_hist[1][i] - (float)mcpi_hist[0][i]) * scale;
+    }
+    ImPlot_PushColormap_PlotColormap(ImPlotColormap_RdBu);
+    if (ImPlot_BeginPlot("Monte Carlo Density", (ImVec2){256,256}, ImPlotFlags_None)) {
+        ImPlot_SetupAxesLimits(0.0, 1.0, 0.0, 1.0, ImPlotCond_Always);
+        ImPlot_PlotHeatmap_FloatPtr("Hits", mcpi_hist_values, MCPI_HIST_SIZE, MCPI_HIST_SIZE, -2.0, 2.0, NULL,
+                                    (ImPlotPoint){0.0, 0.0}, (ImPlotPoint){1.0, 1.0}, 0);
         ImPlot_EndPlot();
     }
+    ImPlot_PopColormap(1);
 }
 
+#endif /* SIM_HEADLESS */
+
 /* Cleanup: no GPU resources to free */
 void sim_mcpi_destroy(void) {
     // Nothing to destroy
@@ -1,6 +1,11 @@
 #ifndef MCPI_H
 #define MCPI_H
 
+#include <stdint.h>
+
+struct sim_parameter_t;
+struct sim_observable_t;
+
 
 
 void sim_mcpi_init(void);
@@ -9,6 +14,8 @@ void sim_mcpi_update(float dt);
 void sim_mcpi_params_ui(void);
 void sim_mcpi_plot_ui(void);
 void sim_mcpi_render(void);
+struct sim_parameter_t *sim_mcpi_settings(int16_t *count);
+int sim_mcpi_observe(struct sim_observable_t *out);
 
 
 
@@ -0,0 +1,88 @@
+#include "mcpi_batch.h"
+#include "mcpi_qmc.h"
+#include "rng.h"
+#include <math.h>
+
+void mcpi_batch_init(mcpi_batch_t *batch, mcpi_sampler_t sampler, uint64_t seed) {
+    batch->sampler = sampler;
+    batch->seed = seed;
+    batch->stream = SIM_RNG_STREAM_MCPI;
+    batch->samples = 0;
+    batch->inside = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Kernel: coordinates stay integers below 2^24, so they convert to float
+// exactly; the test is x^2 + y^2 < 2^48 in float. The squares round to 24
+// bits, so points within about 2^-23 (relative) of the circle may land on
+// either side, a bias far below the estimate's standard error. Exact integer
+// or double squares cost about a fifth of the throughput.
+// -----------------------------------------------------------------------------
+uint64_t mcpi_batch_count(uint64_t seed, uint64_t stream, uint64_t first_block, uint64_t block_count) {
+    const uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    const float radius2 = 281474976710656.0f;    // 2^48
+    uint64_t inside = 0;
+    for (uint64_t b = 0; b < block_count; b += SIM_RNG_LANES) {
+        uint32_t ctr[4][SIM_RNG_LANES];
+        sim_rng_lanes_counters(ctr, stream, first_block + b);
+        sim_rng_philox_lanes(ctr, k0, k1);
+        uint32_t hits = 0;
+        for (int l = 0; l < SIM_RNG_LANES; l++) {
+            float x0 = (float)(ctr[0][l] >> 8), y0 = (float)(ctr[1][l] >> 8);
+            float x1 = (float)(ctr[2][l] >> 8), y1 = (float)(ctr[3][l] >> 8);
+            hits += (x0 * x0 + y0 * y0 < radius2) + (x1 * x1 + y1 * y1 < radius2);
+        }
+        inside += hits;
+    }
+    return inside;
+}
+
+// Full resolution: x^2 + y^2 < 2^64, in double so the loop vectorizes
+uint64_t mcpi_batch_count_points(const uint32_t *x, const uint32_t *y, int count) {
+    const double radius2 = 18446744073709551616.0;    // 2^64
+    int hits = 0;
+    for (int i = 0; i < count; i++) {
+        double xd = (double)x[i], yd = (double)y[i];
+        hits += xd * xd + yd * yd < radius2;
+    }
+    return (uint64_t)hits;
+}
+
+void mcpi_batch_run(mcpi_batch_t *batch, uint64_t point_count) {
+    uint64_t blocks = (point_count + MCPI_BATCH_POINTS - 1) / MCPI_BATCH_POINTS;
+    if (batch->sampler == MCPI_SAMPLER_RANDOM) {
+        uint64_t philox_blocks = blocks * (MCPI_BATCH_POINTS / 2);
+        batch->inside += mcpi_batch_count(batch->seed, batch->stream, batch->samples / 2, philox_blocks);
+        batch->samples += 2 * philox_blocks;
+        return;
+    }
+
+    uint32_t x[MCPI_BATCH_POINTS], y[MCPI_BATCH_POINTS];
+    for (uint64_t b = 0; b < blocks; b++) {
+        switch (batch->sampler) {
+            case MCPI_SAMPLER_SOBOL:
+                mcpi_qmc_sobol(batch->seed, batch->samples, MCPI_BATCH_POINTS, x, y);
+                break;
+            case MCPI_SAMPLER_HALTON:
+                mcpi_qmc_halton(batch->seed, batch->samples, MCPI_BATCH_POINTS, x, y);
+                break;
+            default:
+                mcpi_qmc_stratified(batch->seed, batch->samples, MCPI_BATCH_POINTS, x, y);
+                break;
+        }
+        batch->inside += mcpi_batch_count_points(x, y, MCPI_BATCH_POINTS);
+        batch->samples += MCPI_BATCH_POINTS;
+    }
+}
+
+void mcpi_batch_estimate(const mcpi_batch_t *batch, double *pi, double *std_error) {
+    if (batch->samples == 0) {
+        *pi = 0.0;
+        *std_error = 0.0;
+        return;
+    }
+    double n = (double)batch->samples;
+    double p = (double)batch->inside / n;
+    *pi = 4.0 * p;
+    *std_error = 4.0 * sqrt(p * (1.0 - p) / n);
+}
@@ -0,0 +1,61 @@
+#ifndef MCPI_BATCH_H
+#define MCPI_BATCH_H
+
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Batched Monte Carlo Pi sampler
+//
+// Points are never stored, only the number inside the quarter circle.
+//
+// The pseudo-random sampler takes two points from every Philox block of the
+// MCPI stream (see rng.h), each coordinate the top 24 bits of one word.
+// Blocks are drawn SIM_RNG_LANES at a time through sim_rng_philox_lanes and
+// tested in the same lanes, so generation and test vectorize together.
+//
+// The quasi-random and stratified samplers (mcpi_qmc.h) write blocks of
+// MCPI_BATCH_POINTS coordinates that a separate vectorized loop tests at full
+// 32-bit resolution.
+//
+// Counts are pure functions of the seed and the index range.
+// -----------------------------------------------------------------------------
+
+typedef enum {
+    MCPI_SAMPLER_RANDOM,
+    MCPI_SAMPLER_SOBOL,
+    MCPI_SAMPLER_HALTON,
+    MCPI_SAMPLER_STRATIFIED,
+    MCPI_SAMPLER_COUNT
+} mcpi_sampler_t;
+
+#define MCPI_BATCH_POINTS 1024   // Points per generated block; runs are whole blocks
+
+typedef struct mcpi_batch_t {
+    mcpi_sampler_t sampler;
+    uint64_t seed;
+    uint64_t stream;             // Philox stream of the pseudo-random sampler
+    uint64_t samples;            // Points drawn, also the index of the next one
+    uint64_t inside;
+} mcpi_batch_t;
+
+// Starts at the beginning of the sequence, the pseudo-random sampler on
+// stream SIM_RNG_STREAM_MCPI
+void mcpi_batch_init(mcpi_batch_t *batch, mcpi_sampler_t sampler, uint64_t seed);
+
+// Points inside among the 2 * block_count points of Philox blocks
+// [first_block, first_block + block_count) of a stream; block_count is
+// rounded up to a multiple of SIM_RNG_LANES
+uint64_t mcpi_batch_count(uint64_t seed, uint64_t stream, uint64_t first_block, uint64_t block_count);
+
+// Points inside among `count` 32-bit fixed-point points
+uint64_t mcpi_batch_count_points(const uint32_t *x, const uint32_t *y, int count);
+
+// Draw the next point_count points, rounded up to whole MCPI_BATCH_POINTS
+void mcpi_batch_run(mcpi_batch_t *batch, uint64_t point_count);
+
+// 4 * inside / samples and its standard error 4 sqrt(p (1 - p) / samples).
+// The error is the plain Monte Carlo one; the quasi-random samplers converge
+// faster than it suggests.
+void mcpi_batch_estimate(const mcpi_batch_t *batch, double *pi, double *std_error);
+
+#endif /* MCPI_BATCH_H */
@@ -0,0 +1,46 @@
+#ifndef MCPI_PARALLEL_H
+#define MCPI_PARALLEL_H
+
+#include <stdint.h>
+#include "mcpi_batch.h"
+#include "workers.h"
+
+// -----------------------------------------------------------------------------
+// Multithreaded Monte Carlo Pi
+//
+// Sampling is split into one shard per worker thread. Each shard is a
+// pseudo-random mcpi_batch_t on its own Philox stream, so the points a shard
+// draws do not depend on which thread runs it. A round gives every shard the
+// same number of points through the worker pool; afterwards the shard
+// counters are summed in shard order. The estimate after a given number of
+// rounds is therefore a pure function of the seed and the shard count.
+//
+// Shards are padded to a cache line so threads never write to the same line
+// while counting.
+// -----------------------------------------------------------------------------
+
+#define MCPI_PARALLEL_CACHE_LINE 64
+
+typedef struct mcpi_shard_t {
+    _Alignas(MCPI_PARALLEL_CACHE_LINE) mcpi_batch_t batch;
+    double seconds;              // Time spent sampling, all rounds
+} mcpi_shard_t;
+
+typedef struct mcpi_parallel_t {
+    int shard_count;
+    uint64_t points_per_round;   // Per shard, a multiple of MCPI_BATCH_POINTS
+    mcpi_shard_t shards[SIM_WORKERS_MAX];
+    uint64_t samples;            // Totals, reduced after every round
+    uint64_t inside;
+} mcpi_parallel_t;
+
+// shard_count is clamped to [1, SIM_WORKERS_MAX]
+void mcpi_parallel_init(mcpi_parallel_t *par, uint64_t seed, int shard_count, uint64_t points_per_round);
+
+// One round on the shared worker pool
+void mcpi_parallel_run(mcpi_parallel_t *par);
+
+// Same as mcpi_batch_estimate, over all shards
+void mcpi_parallel_estimate(const mcpi_parallel_t *par, double *pi, double *std_error);
+
+#endif /* MCPI_PARALLEL_H */
@@ -0,0 +1,189 @@
+#include "mcpi_qmc.h"
+#include "rng.h"
+
+// Streams inside the MCPI namespace; the pseudo-random sampler uses stream 0
+#define MCPI_QMC_STREAM_SCRAMBLE (SIM_RNG_STREAM_MCPI + 1)
+#define MCPI_QMC_STREAM_JITTER   (SIM_RNG_STREAM_MCPI + 2)
+#define MCPI_QMC_STREAM_ORDER    (SIM_RNG_STREAM_MCPI + 3)
+
+#define MCPI_QMC_BASE3_DIGITS 21           // 3^21 > 2^32
+#define MCPI_QMC_BASE3_SCALE (4294967296.0 / 10460353203.0)   // 2^32 / 3^21
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+static inline int mcpi_ctz32(uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(v);
+#else
+    int n = 0;
+    while (!(v & 1)) { v >>= 1; n++; }
+    return n;
+#endif
+}
+
+static inline uint32_t mcpi_reverse_bits(uint32_t v) {
+    v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+    v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+    v = ((v >> 4) & 0x0F0F0F0Fu) | ((v & 0x0F0F0F0Fu) << 4);
+    v = ((v >> 8) & 0x00FF00FFu) | ((v & 0x00FF00FFu) << 8);
+    return (v >> 16) | (v << 16);
+}
+
+// Every step changes bit k by a function of bits 0..k-1 only, so on a
+// bit-reversed coordinate this permutes each digit depending on the digits
+// above it: an Owen scramble (Laine-Karras, constants from Burley 2020)
+static inline uint32_t mcpi_lk_permute(uint32_t v, uint32_t seed) {
+    v ^= v * 0x3d20adeau;
+    v += seed;
+    v *= (seed >> 16) | 1u;
+    v ^= v * 0x05526c56u;
+    v ^= v * 0x53a22864u;
+    return v;
+}
+
+static inline uint32_t mcpi_owen_base2(uint32_t v, uint32_t seed) {
+    return mcpi_reverse_bits(mcpi_lk_permute(mcpi_reverse_bits(v), seed));
+}
+
+static inline uint64_t mcpi_mix64(uint64_t v) {
+    v ^= v >> 30;
+    v *= 0xBF58476D1CE4E5B9ULL;
+    v ^= v >> 27;
+    v *= 0x94D049BB133111EBULL;
+    return v ^ (v >> 31);
+}
+
+static const uint8_t mcpi_perm3[6][3] = {
+    {0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}
+};
+
+// Owen-scrambled radical inverse of n in base 3. The permutation of digit k
+// is picked by a hash of the digits below it; `prefix` starts at 1 so equal
+// digit strings of different lengths stay distinct.
+static inline uint32_t mcpi_owen_base3(uint32_t n, uint64_t seed) {
+    uint64_t prefix = 1;
+    uint64_t value = 0;
+    for (int k = 0; k < MCPI_QMC_BASE3_DIGITS; k++) {
+        uint32_t d = n % 3;
+        n /= 3;
+        uint64_t h = mcpi_mix64(seed ^ (prefix * 0x9E3779B97F4A7C15ULL));
+        value = value * 3 + mcpi_perm3[h % 6][d];
+        prefix = prefix * 3 + d;
+    }
+    return (uint32_t)((double)value * MCPI_QMC_BASE3_SCALE);
+}
+
+// Even bits of v packed into the low half
+static inline uint32_t mcpi_compact_bits(uint32_t v) {
+    v &= 0x55555555u;
+    v = (v | (v >> 1)) & 0x33333333u;
+    v = (v | (v >> 2)) & 0x0F0F0F0Fu;
+    v = (v | (v >> 4)) & 0x00FF00FFu;
+    return (v | (v >> 8)) & 0x0000FFFFu;
+}
+
+// Scramble seeds of the replicate holding point `index`
+static void mcpi_qmc_scramble_seeds(uint64_t seed, uint64_t index, uint32_t out[4]) {
+    sim_rng_block(seed, MCPI_QMC_STREAM_SCRAMBLE, index >> 32, out);
+}
+
+// -----------------------------------------------------------------------------
+// Sobol
+// -----------------------------------------------------------------------------
+void mcpi_qmc_sobol(uint64_t seed, uint64_t first, int count, uint32_t *x, uint32_t *y) {
+    // Direction numbers of dimension 2 (primitive polynomial x + 1);
+    // dimension 1 is the identity, i.e. the bit-reversed index
+    uint32_t v1[32];
+    v1[0] = 1u << 31;
+    for (int j = 1; j < 32; j++) {
+        v1[j] = v1[j - 1] ^ (v1[j - 1] >> 1);
+    }
+
+    // Point n is Sobol'(gray(n)); consecutive Gray codes differ in bit ctz(n)
+    uint32_t n = (uint32_t)first;
+    uint32_t gray = n ^ (n >> 1);
+    uint32_t sx = mcpi_reverse_bits(gray), sy = 0;
+    for (int j = 0; j < 32; j++) {
+        if ((gray >> j) & 1u) sy ^= v1[j];
+    }
+    for (int i = 0; i < count; i++) {
+        x[i] = sx;
+        y[i] = sy;
+        if (++n != 0) {
+            int j = mcpi_ctz32(n);
+            sx ^= 1u << (31 - j);
+            sy ^= v1[j];
+        }
+    }
+
+    uint32_t scramble[4];
+    mcpi_qmc_scramble_seeds(seed, first, scramble);
+    for (int i = 0; i < count; i++) {
+        x[i] = mcpi_owen_base2(x[i], scramble[0]);
+        y[i] = mcpi_owen_base2(y[i], scramble[1]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Halton
+// -----------------------------------------------------------------------------
+void mcpi_qmc_halton(uint64_t seed, uint64_t first, int count, uint32_t *x, uint32_t *y) {
+    uint32_t scramble[4];
+    mcpi_qmc_scramble_seeds(seed, first, scramble);
+    const uint64_t seed3 = ((uint64_t)scramble[3] << 32) | scramble[2];
+    const uint32_t n0 = (uint32_t)first;
+
+    // Base 2: the radical inverse is the bit-reversed index, so the scramble
+    // reduces to one hash and one reversal
+    for (int i = 0; i < count; i++) {
+        x[i] = mcpi_reverse_bits(mcpi_lk_permute(n0 + (uint32_t)i, scramble[0]));
+    }
+    for (int i = 0; i < count; i++) {
+        y[i] = mcpi_owen_base3(n0 + (uint32_t)i, seed3);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Stratified
+// -----------------------------------------------------------------------------
+// Seed of the cell order of a pass
+static uint32_t mcpi_qmc_order_seed(uint64_t seed, uint64_t pass) {
+    uint32_t out[4];
+    sim_rng_block(seed, MCPI_QMC_STREAM_ORDER, pass, out);
+    return out[0];
+}
+
+void mcpi_qmc_stratified(uint64_t seed, uint64_t first, int count, uint32_t *x, uint32_t *y) {
+    // Pass k holds 4^k points; passes at the finest level repeat
+    const int last = MCPI_QMC_STRATA_LEVELS - 1;
+    int level = 0;
+    uint64_t j = first;
+    while (level < last && j >= (1ULL << (2 * level))) {
+        j -= 1ULL << (2 * level);
+        level++;
+    }
+    uint64_t pass = (uint64_t)level;
+    if (level == last) {
+        pass += j >> (2 * last);
+        j &= (1ULL << (2 * last)) - 1;
+    }
+    uint32_t order = mcpi_qmc_order_seed(seed, pass);
+
+    for (int i = 0; i < count; i++) {
+        // Bit-reversed Morton order alone would enter every coarse cell at
+        // its corner nearest the origin, biasing partial passes inward; the
+        // Owen scramble picks a random sub-cell order per coarse cell instead
+        uint32_t cell = level ? mcpi_reverse_bits(mcpi_lk_permute((uint32_t)j, order)) >> (32 - 2 * level) : 0;
+        uint64_t cx = mcpi_compact_bits(cell), cy = mcpi_compact_bits(cell >> 1);
+        uint32_t jitter[4];
+        sim_rng_block(seed, MCPI_QMC_STREAM_JITTER, first + (uint64_t)i, jitter);
+        x[i] = (uint32_t)(((cx << 32) | jitter[0]) >> level);
+        y[i] = (uint32_t)(((cy << 32) | jitter[1]) >> level);
+        if (++j == 1ULL << (2 * level)) {
+            j = 0;
+            if (level < last) level++;
+            order = mcpi_qmc_order_seed(seed, ++pass);
+        }
+    }
+}
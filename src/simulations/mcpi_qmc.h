@@ -0,0 +1,34 @@
+#ifndef MCPI_QMC_H
+#define MCPI_QMC_H
+
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Low-discrepancy point generators for Monte Carlo Pi
+//
+// Each function writes points [first, first + count) of its sequence as 32-bit
+// fixed-point coordinates (x / 2^32 in [0, 1)). Like mcpi_batch_count, the
+// output is a pure function of the seed and the index range.
+//
+// - Sobol: the first two Sobol' dimensions in Gray-code order, with Owen
+//   (nested uniform) scrambling by a hash of the bit-reversed coordinate.
+// - Halton: bases 2 and 3, Owen scrambled. Base 2 uses the same hash as
+//   Sobol. Base 3 permutes each digit by a hash of the digits before it.
+// - Stratified: passes over 2^k x 2^k grids with k = 0, 1, ... up to
+//   MCPI_QMC_STRATA_LEVELS - 1, one jittered point per cell. Cells are
+//   visited in Owen-scrambled bit-reversed Morton order, so any prefix of a
+//   pass is also spread evenly over the coarser grids.
+//
+// Sobol and Halton repeat after 2^32 points. Each further run of 2^32
+// points therefore draws fresh scrambles, making it an independent
+// replicate. Ranges passed to these functions must not cross such a
+// boundary.
+// -----------------------------------------------------------------------------
+
+#define MCPI_QMC_STRATA_LEVELS 17          // Finest grid: 2^16 cells per side
+
+void mcpi_qmc_sobol(uint64_t seed, uint64_t first, int count, uint32_t *x, uint32_t *y);
+void mcpi_qmc_halton(uint64_t seed, uint64_t first, int count, uint32_t *x, uint32_t *y);
+void mcpi_qmc_stratified(uint64_t seed, uint64_t first, int count, uint32_t *x, uint32_t *y);
+
+#endif /* MCPI_QMC_H */
@@ -1,8 +1,11 @@
 #include "none.h"
+#include "simulations.h"
+#ifndef SIM_HEADLESS
 #ifndef CIMGUI_DEFINE_ENUMS_AND_STRUCTS
     #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #endif
 #include "cimgui.h"
+#endif
 
 
 
@@ -10,7 +13,11 @@
 void sim_none_init(void) {}
 void sim_none_destroy(void) {}
 void sim_none_update(float dt) { (void)dt; }
+sim_parameter_t *sim_none_settings(int16_t *count) { *count = 0; return NULL; }
+int sim_none_observe(sim_observable_t *out) { (void)out; return 0; }
+#ifndef SIM_HEADLESS
 void sim_none_params_ui(void) { igText("No simulation selected."); }
 void sim_none_plot_ui(void) { igText("No plot."); }
 void sim_none_render(void) {igText("No simulation Render");}
+#endif
 
@@ -1,6 +1,11 @@
 #ifndef NONE_H
 #define NONE_H
 
+#include <stdint.h>
+
+struct sim_parameter_t;
+struct sim_observable_t;
+
 
 
 void sim_none_init(void);
@@ -9,6 +14,8 @@ void sim_none_update(float dt);
 void sim_none_params_ui(void);
 void sim_none_plot_ui(void);
 void sim_none_render(void);
+struct sim_parameter_t *sim_none_settings(int16_t *count);
+int sim_none_observe(struct sim_observable_t *out);
 
 
 
@@ -1,5 +1,9 @@
 #include "pendulum.h"
 #include "simulations.h"
+#include "pendulum_integrator.h"
+#include "pendulum_ensemble.h"
+#ifndef SIM_HEADLESS
+#include "gpu_cache.h"
 #ifndef CIMGUI_DEFINE_ENUMS_AND_STRUCTS
     #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #endif
@@ -9,12 +13,12 @@
 #include "sokol_app.h"
 #include "./util/sokol_imgui.h"
 #include "sokol_glue.h"
+#endif
 
 #include <math.h>
 #include <stdlib.h>
 #include <stdint.h>
 
-#define BUFFER_LEN 600
 #ifndef M_PI
 #define M_PI 3.14159265358979323846264338327
 #endif
@@ -22,13 +26,170 @@
 /* Pendulum Parameters */
 static float pendulum_gravity = 9.81f;
 static float pendulum_length = 1.0f;
-static float pendulum_angle = 0.5f;
-static float pendulum_angular_vel = 0.0f;
+static float pendulum_angle = 0.5f;           // Shown angle, wrapped to [-pi, pi]
+
+/* Integration: every integrator runs its own copy of the pendulum on the same
+   fixed-timestep clock, so their energy errors can be compared live; the
+   selected one is drawn. Each update is one step of the scheduler's fixed
+   timestep (see simulations.h), split into pendulum_substeps. */
+#define PENDULUM_START_ANGLE 0.5
+static int pendulum_integrator = PENDULUM_INTEGRATOR_VERLET;
+static int pendulum_substeps = 1;             // parameter: integrator steps per timestep
+static float pendulum_log_tolerance = -8.0f;  // parameter: RK45 tolerance, log10
+static pendulum_solver_t pendulum_solvers[PENDULUM_INTEGRATOR_COUNT];
+static double pendulum_energy0[PENDULUM_INTEGRATOR_COUNT];     // Reference energies
+static double pendulum_max_error[PENDULUM_INTEGRATOR_COUNT];   // Since the reference was taken
+static float pendulum_ref_gravity, pendulum_ref_length;        // g and L of the reference
+
+/* Ensemble mode: many single or double pendulums from nearby starts on the
+   same fixed-timestep clock, drawn with one instanced call straight from the
+   ensemble's angle arrays (see pendulum_ensemble.h). Count, kind and spread
+   take effect on reset. */
+typedef enum { PENDULUM_MODE_SINGLE, PENDULUM_MODE_ENSEMBLE, PENDULUM_MODE_COUNT } pendulum_mode_t;
+static int pendulum_mode = PENDULUM_MODE_SINGLE;
+#define PENDULUM_ENSEMBLE_START 2.0f          // Both angles; chaotic for the double pendulum
+static int pendulum_ensemble_count = 10000;   // parameter: pendulums in the ensemble
+static bool pendulum_ensemble_double = true;  // parameter: double or single pendulums
+static float pendulum_log_spread = -4.0f;     // parameter: initial angle spread, log10 rad
+static pendulum_ensemble_t pendulum_ens;
+static sim_series_t pendulum_spread_series;   // RMS distance from the unperturbed pendulum
 
 /* Plot Data */
-static float pendulum_time_data[BUFFER_LEN];
-static float pendulum_angle_data[BUFFER_LEN];
-static int   pendulum_data_count = 0;
+static sim_series_t pendulum_angle_series;
+static sim_series_t pendulum_energy_series;   // |E - E0| / (g L), one channel per integrator
+static double pendulum_sim_time = 0.0;
+
+/* Every setting by name (see simulations.h), also drawn by the parameters
+   UI in contiguous groups; Mode is PENDULUM_MODE_*, Integrator
+   PENDULUM_INTEGRATOR_* */
+enum {
+    PENDULUM_SETTING_MODE, PENDULUM_SETTING_INTEGRATOR,
+    PENDULUM_SETTING_GRAVITY, PENDULUM_SETTING_LENGTH, PENDULUM_SETTING_SUBSTEPS,
+    PENDULUM_SETTING_TOLERANCE,
+    PENDULUM_SETTING_ENSEMBLE_COUNT, PENDULUM_SETTING_SPREAD, PENDULUM_SETTING_DOUBLE,
+    PENDULUM_SETTING_COUNT
+};
+static sim_parameter_t pendulum_settings[PENDULUM_SETTING_COUNT] = {
+    [PENDULUM_SETTING_MODE] = { "Mode", &pendulum_mode, SIM_PARAM_INT, 0,0, 0, PENDULUM_MODE_COUNT - 1 },
+    [PENDULUM_SETTING_INTEGRATOR] = { "Integrator", &pendulum_integrator, SIM_PARAM_INT, 0,0, 0, PENDULUM_INTEGRATOR_COUNT - 1 },
+    [PENDULUM_SETTING_GRAVITY] = { "Gravity", &pendulum_gravity, SIM_PARAM_FLOAT, 1.0f, 20.0f, 0,0 },
+    [PENDULUM_SETTING_LENGTH] = { "Length",  &pendulum_length,  SIM_PARAM_FLOAT, 0.5f, 5.0f,  0,0 },
+    [PENDULUM_SETTING_SUBSTEPS] = { "Substeps", &pendulum_substeps, SIM_PARAM_INT, 0,0, 1, 64 },
+    [PENDULUM_SETTING_TOLERANCE] = { "RK45 Tolerance (log10)", &pendulum_log_tolerance, SIM_PARAM_FLOAT, -12.0f, -2.0f, 0,0 },
+    [PENDULUM_SETTING_ENSEMBLE_COUNT] = { "Pendulums", &pendulum_ensemble_count, SIM_PARAM_INT, 0,0, 100, PENDULUM_ENSEMBLE_MAX },
+    [PENDULUM_SETTING_SPREAD] = { "Initial Spread (log10 rad)", &pendulum_log_spread, SIM_PARAM_FLOAT, -6.0f, 0.0f, 0,0 },
+    [PENDULUM_SETTING_DOUBLE] = { "Double Pendulums", &pendulum_ensemble_double, SIM_PARAM_BOOL, 0,0, 0,0 },
+};
+
+/* Energies become the new reference, e.g. after g or L changed */
+static void pendulum_rebase_energy(void) {
+    for (int i = 0; i < PENDULUM_INTEGRATOR_COUNT; i++) {
+        const pendulum_solver_t *solver = &pendulum_solvers[i];
+        pendulum_energy0[i] = pendulum_energy(solver->theta, solver->omega, pendulum_gravity, pendulum_length);
+        pendulum_max_error[i] = 0.0;
+    }
+    pendulum_ref_gravity = pendulum_gravity;
+    pendulum_ref_length = pendulum_length;
+}
+
+/* Restart every integrator from the initial angle at rest */
+static void pendulum_reset(void) {
+    for (int i = 0; i < PENDULUM_INTEGRATOR_COUNT; i++) {
+        pendulum_solver_init(&pendulum_solvers[i], (pendulum_integrator_t)i, PENDULUM_START_ANGLE, 0.0,
+                             pow(10.0, pendulum_log_tolerance));
+    }
+    pendulum_rebase_energy();
+    pendulum_angle = (float)PENDULUM_START_ANGLE;
+    pendulum_sim_time = 0.0;
+    sim_series_init(&pendulum_angle_series, 1);
+    sim_series_init(&pendulum_energy_series, PENDULUM_INTEGRATOR_COUNT);
+
+    pendulum_ensemble_destroy(&pendulum_ens);
+    if (pendulum_mode == PENDULUM_MODE_ENSEMBLE) {
+        pendulum_ensemble_create(&pendulum_ens, pendulum_ensemble_count, pendulum_ensemble_double,
+                                 PENDULUM_ENSEMBLE_START, PENDULUM_ENSEMBLE_START, powf(10.0f, pendulum_log_spread));
+    }
+    sim_series_init(&pendulum_spread_series, 1);
+}
+
+/* One fixed timestep of every integrator */
+static void pendulum_fixed_step(double h) {
+    const double k = pendulum_gravity / pendulum_length;
+    const double scale = pendulum_gravity * pendulum_length;
+    const double sub_h = h / pendulum_substeps;
+    float errors[PENDULUM_INTEGRATOR_COUNT];
+    for (int i = 0; i < PENDULUM_INTEGRATOR_COUNT; i++) {
+        pendulum_solver_t *solver = &pendulum_solvers[i];
+        for (int s = 0; s < pendulum_substeps; s++) {
+            pendulum_solver_step(solver, k, sub_h);
+        }
+        double error = fabs(pendulum_energy(solver->theta, solver->omega, pendulum_gravity, pendulum_length) - pendulum_energy0[i]) / scale;
+        pendulum_max_error[i] = fmax(pendulum_max_error[i], error);
+        errors[i] = (float)fmax(error, 1e-16);   // Log axis: keep exact zeros visible
+    }
+    pendulum_sim_time += h;
+    sim_series_push(&pendulum_energy_series, pendulum_sim_time, errors);
+}
+
+/* Update logic: one fixed timestep of dt, which the scheduler keeps constant
+   (catch-up and time warp are its business); drawing happens once per frame
+   in render */
+void sim_pendulum_update(float dt) {
+    if (pendulum_gravity != pendulum_ref_gravity || pendulum_length != pendulum_ref_length) {
+        pendulum_rebase_energy();
+    }
+    for (int i = 0; i < PENDULUM_INTEGRATOR_COUNT; i++) {
+        pendulum_solvers[i].tolerance = pow(10.0, pendulum_log_tolerance);
+    }
+
+    const double h = dt;
+    if (pendulum_mode == PENDULUM_MODE_ENSEMBLE) {
+        // All substeps in one pass over the ensemble
+        pendulum_ensemble_step(&pendulum_ens, pendulum_gravity, pendulum_length,
+                               (float)(h / pendulum_substeps), pendulum_substeps);
+        pendulum_sim_time += h;
+        float spread = (float)fmax(pendulum_ensemble_spread(&pendulum_ens), 1e-9);
+        sim_series_push(&pendulum_spread_series, pendulum_sim_time, &spread);
+        return;
+    }
+    pendulum_fixed_step(h);
+
+    // Wrap the shown angle within [-π, π]
+    double angle = fmod(pendulum_solvers[pendulum_integrator].theta + M_PI, 2.0 * M_PI);
+    if (angle < 0)
+        angle += 2.0 * M_PI;
+    pendulum_angle = (float)(angle - M_PI);
+    sim_series_push(&pendulum_angle_series, pendulum_sim_time, &pendulum_angle);
+}
+
+sim_parameter_t *sim_pendulum_settings(int16_t *count) {
+    *count = PENDULUM_SETTING_COUNT;
+    return pendulum_settings;
+}
+
+/* Observables: simulated time, then the selected integrator's pendulum or
+   the ensemble spread */
+int sim_pendulum_observe(sim_observable_t *out) {
+    out[0] = (sim_observable_t){ "sim_time", pendulum_sim_time };
+    if (pendulum_mode == PENDULUM_MODE_ENSEMBLE) {
+        out[1] = (sim_observable_t){ "spread", pendulum_ensemble_spread(&pendulum_ens) };
+        return 2;
+    }
+    const pendulum_solver_t *solver = &pendulum_solvers[pendulum_integrator];
+    double energy = pendulum_energy(solver->theta, solver->omega, pendulum_gravity, pendulum_length);
+    out[1] = (sim_observable_t){ "angle", pendulum_angle };
+    out[2] = (sim_observable_t){ "omega", solver->omega };
+    out[3] = (sim_observable_t){ "energy_error", fabs(energy - pendulum_energy0[pendulum_integrator]) / (pendulum_gravity * pendulum_length) };
+    return 4;
+}
+
+#ifndef SIM_HEADLESS
+/* UI and drawing; compiled out of headless builds */
+static const char *pendulum_integrator_names[PENDULUM_INTEGRATOR_COUNT] = {
+    "Semi-implicit Euler", "Velocity Verlet", "RK4", "Dormand-Prince RK45"
+};
+static const char *pendulum_mode_names[PENDULUM_MODE_COUNT] = { "Single", "Ensemble" };
+static float pendulum_log_target = -6.0f;     // parameter: energy error to meet, log10
 
 #define PENDULUM_OFFSCREEN_WIDTH (256)
 #define PENDULUM_OFFSCREEN_HEIGHT (256)
@@ -60,17 +221,56 @@ typedef struct {
 } pendulum_uniforms_t;
 pendulum_uniforms_t uniforms;
 
-/* Parameter definitions */
-static sim_parameter_t pendulum_params[] = {
-    { "Gravity", &pendulum_gravity, SIM_PARAM_FLOAT, 1.0f, 20.0f, 0,0 },
-    { "Length",  &pendulum_length,  SIM_PARAM_FLOAT, 0.5f, 5.0f,  0,0 },
+// Ensemble drawing: 4 vertices per instance (pivot-bob1, bob1-bob2 as lines),
+// each carrying its joint index; theta1 and theta2 come per instance from
+// the two halves of one stream buffer. Arms point the same way as the
+// single pendulum's.
+static sg_shader pendulum_ens_shader;
+static sg_pipeline pendulum_ens_pip;
+static sg_buffer pendulum_joint_buf;
+static sg_buffer pendulum_instance_buf;
+
+typedef struct {
+    float params[4];             // Arm 1, arm 2, view scale, 1 / count
+    float color[4];              // Alpha in w
+} pendulum_ensemble_uniforms_t;
+
+static const char *pendulum_ens_vs_src =
+    "#version 300 es\n"
+    "precision highp float;\n"
+    "layout(location=0) in float joint;\n"
+    "layout(location=1) in float theta1;\n"
+    "layout(location=2) in float theta2;\n"
+    "uniform vec4 u_params;\n"
+    "uniform vec4 u_color;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "  vec2 b1 = u_params.x * vec2(sin(theta1), cos(theta1));\n"
+    "  vec2 b2 = b1 + u_params.y * vec2(sin(theta2), cos(theta2));\n"
+    "  vec2 p = joint < 0.5 ? vec2(0.0) : (joint < 1.5 ? b1 : b2);\n"
+    "  float t = float(gl_InstanceID) * u_params.w;\n"
+    "  color = vec4(0.5 + 0.5 * cos(6.2831853 * (t + vec3(0.0, 0.33, 0.67))), u_color.w);\n"
+    "  gl_Position = vec4(p * u_params.z, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *pendulum_ens_fs_src =
+    "#version 300 es\n"
+    "precision mediump float;\n"
+    "in vec4 color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "  frag_color = color;\n"
+    "}\n";
+
+/* UI-only parameter: the energy error the cheapest-integrator mark must meet */
+static sim_parameter_t pendulum_target_params[] = {
+    { "Target Energy Error (log10)", &pendulum_log_target, SIM_PARAM_FLOAT, -12.0f, -1.0f, 0,0 },
 };
 
-/* Initialize GPU Resources */
-void sim_pendulum_init(void) {
-    
+/* Create GPU resources */
+static void pendulum_gpu_create(void) {
     // Create offscreen target images for rendering
-    pendulum_color_img = sg_make_image(&(sg_image_desc){
+    pendulum_color_img = sim_gpu_image_acquire(&(sg_image_desc){
         .render_target = true,
         .width = PENDULUM_OFFSCREEN_WIDTH,
         .height = PENDULUM_OFFSCREEN_HEIGHT,
@@ -78,7 +278,7 @@ void sim_pendulum_init(void) {
         .sample_count = PENDULUM_SAMPLE_COUNT,
     });
 
-    pendulum_depth_img = sg_make_image(&(sg_image_desc){
+    pendulum_depth_img = sim_gpu_image_acquire(&(sg_image_desc){
         .render_target = true,
         .width = PENDULUM_OFFSCREEN_WIDTH,
         .height = PENDULUM_OFFSCREEN_HEIGHT,
@@ -86,7 +286,7 @@ void sim_pendulum_init(void) {
         .sample_count = PENDULUM_SAMPLE_COUNT,
     });
 
-    pendulum_attachments = sg_make_attachments(&(sg_attachments_desc){
+    pendulum_attachments = sim_gpu_attachments(&(sg_attachments_desc){
         .colors[0].image = pendulum_color_img,
         .depth_stencil.image = pendulum_depth_img,
     });
@@ -158,11 +358,11 @@ void sim_pendulum_init(void) {
         .label = "Pendulum Shader"
     };
 
-    pendulum_shader = sg_make_shader(&shader_desc);
+    pendulum_shader = sim_gpu_shader(&shader_desc);
 
     // Create pipeline
     sg_pipeline_desc pipeline_desc = {
-        .shader = sg_make_shader(&shader_desc),
+        .shader = pendulum_shader,
         .layout = {
             .attrs[0] = { .format = SG_VERTEXFORMAT_FLOAT2 }
         },
@@ -175,32 +375,83 @@ void sim_pendulum_init(void) {
         .depth.pixel_format = PENDULUM_DEPTH_FORMAT
     };
 
-    pendulum_pip = sg_make_pipeline(&pipeline_desc);
+    pendulum_pip = sim_gpu_pipeline(&pipeline_desc);
 
     // Setup bindings
     pendulum_bind.vertex_buffers[0] = pendulum_vbuf;
 
     // Optional sampler
-    pendulum_sampler = sg_make_sampler(&(sg_sampler_desc){
+    pendulum_sampler = sim_gpu_sampler(&(sg_sampler_desc){
         .min_filter = SG_FILTER_LINEAR,
         .mag_filter = SG_FILTER_LINEAR,
         .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
         .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
     });
 
-    // Reset pendulum initial conditions
-    pendulum_angle = 0.5f;
-    pendulum_angular_vel = 0.0f;
+    // Ensemble: static joint indices, angles streamed every frame
+    const float joints[4] = { 0.0f, 1.0f, 1.0f, 2.0f };
+    pendulum_joint_buf = sg_make_buffer(&(sg_buffer_desc){
+        .data = SG_RANGE(joints)
+    });
+    pendulum_instance_buf = sg_make_buffer(&(sg_buffer_desc){
+        .size = 2 * PENDULUM_ENSEMBLE_MAX * sizeof(float),
+        .usage = SG_USAGE_STREAM,
+    });
+    pendulum_ens_shader = sim_gpu_shader(&(sg_shader_desc){
+        .vertex_func = { .source = pendulum_ens_vs_src, .entry = "main" },
+        .fragment_func = { .source = pendulum_ens_fs_src, .entry = "main" },
+        .uniform_blocks[0] = {
+            .stage = SG_SHADERSTAGE_VERTEX,
+            .size = sizeof(pendulum_ensemble_uniforms_t),
+            .glsl_uniforms = {
+                [0] = { .type = SG_UNIFORMTYPE_FLOAT4, .glsl_name = "u_params" },
+                [1] = { .type = SG_UNIFORMTYPE_FLOAT4, .glsl_name = "u_color" },
+            }
+        },
+        .attrs = {
+            [0] = { .glsl_name = "joint" },
+            [1] = { .glsl_name = "theta1" },
+            [2] = { .glsl_name = "theta2" },
+        },
+        .label = "Pendulum Ensemble Shader"
+    });
+    // Additive blending: where many pendulums overlap the image saturates
+    pendulum_ens_pip = sim_gpu_pipeline(&(sg_pipeline_desc){
+        .shader = pendulum_ens_shader,
+        .layout = {
+            .buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .buffers[2].step_func = SG_VERTEXSTEP_PER_INSTANCE,
+            .attrs = {
+                [0] = { .format = SG_VERTEXFORMAT_FLOAT, .buffer_index = 0 },
+                [1] = { .format = SG_VERTEXFORMAT_FLOAT, .buffer_index = 1 },
+                [2] = { .format = SG_VERTEXFORMAT_FLOAT, .buffer_index = 2 },
+            }
+        },
+        .primitive_type = SG_PRIMITIVETYPE_LINES,
+        .depth = {
+            .compare = SG_COMPAREFUNC_ALWAYS,
+            .pixel_format = PENDULUM_DEPTH_FORMAT
+        },
+        .colors[0] = {
+            .pixel_format = PENDULUM_COLOR_FORMAT,
+            .blend = {
+                .enabled = true,
+                .src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA,
+                .dst_factor_rgb = SG_BLENDFACTOR_ONE,
+            }
+        },
+        .label = "Pendulum Ensemble Pipeline"
+    });
 }
 
-/* Destroy GPU resources */
-void sim_pendulum_destroy(void) {
-    sg_destroy_image(pendulum_color_img);
-    sg_destroy_image(pendulum_depth_img);
+/* Release GPU resources; shaders, pipelines, samplers and attachments stay
+   in the shared cache and the images go back to its pool */
+static void pendulum_gpu_destroy(void) {
+    sim_gpu_image_release(pendulum_color_img);
+    sim_gpu_image_release(pendulum_depth_img);
     sg_destroy_buffer(pendulum_vbuf);
-    sg_destroy_pipeline(pendulum_pip);
-    sg_destroy_shader(pendulum_shader);
-    sg_destroy_sampler(pendulum_sampler);
+    sg_destroy_buffer(pendulum_joint_buf);
+    sg_destroy_buffer(pendulum_instance_buf);
 
     pendulum_color_img = (sg_image){0};
     pendulum_depth_img = (sg_image){0};
@@ -208,74 +459,138 @@ void sim_pendulum_destroy(void) {
     pendulum_pip = (sg_pipeline){0};
     pendulum_shader = (sg_shader){0};
     pendulum_sampler = (sg_sampler){0};
+    pendulum_ens_pip = (sg_pipeline){0};
+    pendulum_ens_shader = (sg_shader){0};
+    pendulum_joint_buf = (sg_buffer){0};
+    pendulum_instance_buf = (sg_buffer){0};
 }
 
-/* Update logic */
-void sim_pendulum_update(float dt) {
-    float angle_acc = -(pendulum_gravity / pendulum_length) * sinf(pendulum_angle);
-    pendulum_angular_vel += angle_acc * dt;
-    pendulum_angle += pendulum_angular_vel * dt;
-
-    // Wrap pendulum_angle within [-π, π]
-    pendulum_angle = fmodf(pendulum_angle + M_PI, 2.0f * M_PI);
-    if (pendulum_angle < 0)
-        pendulum_angle += 2.0f * M_PI;
-    pendulum_angle -= M_PI;
-
-    pendulum_time_data[pendulum_data_count] = pendulum_data_count * dt;
-    pendulum_angle_data[pendulum_data_count] = pendulum_angle;
-    pendulum_data_count = (pendulum_data_count +1) % BUFFER_LEN;
-
-    // Prepare uniforms
-    uniforms.angle = pendulum_angle;
-    uniforms.length = pendulum_length;
-
-    // Offscreen pass
-    sg_begin_pass(&(sg_pass){
-        .action = pendulum_pass_action,
-        .attachments = pendulum_attachments
-    });
-    sg_apply_pipeline(pendulum_pip);
-    sg_apply_bindings(&pendulum_bind);
-    sg_apply_uniforms(0, &SG_RANGE(uniforms));
-    sg_draw(0, 2, 1);
-    sg_end_pass();
+/* Ensemble draw: upload both angle arrays at once and draw every pendulum
+   as one instance; call inside the offscreen pass */
+static void pendulum_draw_ensemble(void) {
+    const int count = pendulum_ens.count;
+    if (count == 0)
+        return;
+    sg_update_buffer(pendulum_instance_buf, &(sg_range){ pendulum_ens.angles, 2 * (size_t)count * sizeof(float) });
+
+    const float arm2 = pendulum_ens.is_double ? pendulum_length : 0.0f;
+    pendulum_ensemble_uniforms_t ens_uniforms = {
+        .params = { pendulum_length, arm2, 0.95f / (pendulum_length + arm2), 1.0f / (float)count },
+        .color = { 1.0f, 1.0f, 1.0f, fminf(1.0f, fmaxf(0.02f, 100.0f / (float)count)) },
+    };
+    sg_bindings bind = {
+        .vertex_buffers = { pendulum_joint_buf, pendulum_instance_buf, pendulum_instance_buf },
+        .vertex_buffer_offsets = { 0, 0, count * (int)sizeof(float) },
+    };
+    sg_apply_pipeline(pendulum_ens_pip);
+    sg_apply_bindings(&bind);
+    sg_apply_uniforms(0, &SG_RANGE(ens_uniforms));
+    sg_draw(0, 4, count);
 }
 
-/* Extra UI: a reset button */
+/* Extra UI: a reset button and the integrator */
 void sim_pendulum_params_ui(void) {
     igText("Angle: %.3f rad", pendulum_angle);
     if (igButton("Reset Simulation",(ImVec2){0,0})) {
-        pendulum_angle=0.5f;
-        pendulum_angular_vel=0.0f;
-        pendulum_data_count=0;
-        for (int i=0; i<BUFFER_LEN; i++){
-            pendulum_time_data[i]=0.0f;
-            pendulum_angle_data[i]=0.0f;
-        }
+        pendulum_reset();
+    }
+    if (igCombo_Str_arr("Mode", &pendulum_mode, pendulum_mode_names, PENDULUM_MODE_COUNT, -1)) {
+        pendulum_reset();
+    }
+    if (pendulum_mode == PENDULUM_MODE_ENSEMBLE) {
+        igCheckbox("Double Pendulums", &pendulum_ensemble_double);
+        simulations_draw_params(&pendulum_settings[PENDULUM_SETTING_GRAVITY], 3);          // To Substeps
+        simulations_draw_params(&pendulum_settings[PENDULUM_SETTING_ENSEMBLE_COUNT], 2);   // And Spread
+        return;
     }
+    igCombo_Str_arr("Integrator", &pendulum_integrator, pendulum_integrator_names, PENDULUM_INTEGRATOR_COUNT, -1);
 
-    simulations_draw_params(pendulum_params,2);
+    simulations_draw_params(&pendulum_settings[PENDULUM_SETTING_GRAVITY], 4);   // To RK45 Tolerance
+    simulations_draw_params(pendulum_target_params, 1);
 }
 
 /* Plot UI */
 void sim_pendulum_plot_ui(void) {
 
-    if (pendulum_data_count < 2) {
+    double min_time, max_time;
+    if (pendulum_mode == PENDULUM_MODE_ENSEMBLE) {
+        // Chaotic divergence shows as exponential growth until the spread saturates
+        if (sim_series_x_range(&pendulum_spread_series, &min_time, &max_time) &&
+            ImPlot_BeginPlot("Ensemble Spread", (ImVec2){0, 0}, ImPlotFlags_None)) {
+            ImPlot_SetupAxes("time", "RMS angle distance (rad)", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+            ImPlot_SetupAxisScale_PlotScale(ImAxis_Y1, ImPlotScale_Log10);
+            sim_series_plot_line(&pendulum_spread_series, 0, "Spread");
+            ImPlot_EndPlot();
+        }
+        return;
+    }
+    if (!sim_series_x_range(&pendulum_angle_series, &min_time, &max_time)) {
         return; // Not enough data to plot
     }
 
-    float max_time = 10.0f;
-    float min_time = 0.0f;
-
     ImPlot_SetNextAxesLimits(min_time, max_time, -pendulum_length, pendulum_length, ImPlotCond_Always);
-    // Plot setup with fixed time axis range
+    // Plot setup with the time axis covering the whole run
     if (ImPlot_BeginPlot("Pendulum Angle", (ImVec2){0, 0}, ImPlotFlags_None)) {
-        ImPlot_PlotLine_FloatPtrFloatPtr("Angle", pendulum_time_data, pendulum_angle_data, BUFFER_LEN, 0, 0, sizeof(float));
+        sim_series_plot_line(&pendulum_angle_series, 0, "Angle");
         ImPlot_EndPlot();
     }
+
+    // Every integrator on the same clock; a symplectic method's error
+    // oscillates, the others drift
+    if (ImPlot_BeginPlot("Energy Error", (ImVec2){0, 0}, ImPlotFlags_None)) {
+        ImPlot_SetupAxes("time", "|E - E0| / gL", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        ImPlot_SetupAxisScale_PlotScale(ImAxis_Y1, ImPlotScale_Log10);
+        for (int i = 0; i < PENDULUM_INTEGRATOR_COUNT; i++) {
+            sim_series_plot_line(&pendulum_energy_series, i, pendulum_integrator_names[i]);
+        }
+        double target_x[2] = {min_time, max_time};
+        double target_y[2] = {pow(10.0, pendulum_log_target), pow(10.0, pendulum_log_target)};
+        ImPlot_PlotLine_doublePtrdoublePtr("Target", target_x, target_y, 2, 0, 0, sizeof(double));
+        ImPlot_EndPlot();
+    }
+
+    // Cost in derivative evaluations per simulated second; the cheapest
+    // integrator whose worst error so far meets the target is marked
+    int cheapest = -1;
+    double cheapest_cost = 0.0;
+    const double target = pow(10.0, pendulum_log_target);
+    for (int i = 0; i < PENDULUM_INTEGRATOR_COUNT; i++) {
+        double cost = (pendulum_sim_time > 0.0) ? (double)pendulum_solvers[i].evals / pendulum_sim_time : 0.0;
+        if (pendulum_max_error[i] <= target && (cheapest < 0 || cost < cheapest_cost)) {
+            cheapest = i;
+            cheapest_cost = cost;
+        }
+    }
+    for (int i = 0; i < PENDULUM_INTEGRATOR_COUNT; i++) {
+        double cost = (pendulum_sim_time > 0.0) ? (double)pendulum_solvers[i].evals / pendulum_sim_time : 0.0;
+        igText("%s %-20s max error %.2e, %.0f evals/s", i == cheapest ? "*" : " ", pendulum_integrator_names[i],
+               pendulum_max_error[i], cost);
+    }
 }
  
+/* Offscreen pass into pendulum_color_img, once per rendered frame however
+   many steps the scheduler ran */
+static void pendulum_draw(void) {
+    // Prepare uniforms
+    uniforms.angle = pendulum_angle;
+    uniforms.length = pendulum_length;
+
+    // Offscreen pass
+    sg_begin_pass(&(sg_pass){
+        .action = pendulum_pass_action,
+        .attachments = pendulum_attachments
+    });
+    if (pendulum_mode == PENDULUM_MODE_ENSEMBLE) {
+        pendulum_draw_ensemble();
+    } else {
+        sg_apply_pipeline(pendulum_pip);
+        sg_apply_bindings(&pendulum_bind);
+        sg_apply_uniforms(0, &SG_RANGE(uniforms));
+        sg_draw(0, 2, 1);
+    }
+    sg_end_pass();
+}
+
 /* Render: apply pipeline and uniforms */
 void sim_pendulum_render(void) {
 
@@ -286,8 +601,34 @@ void sim_pendulum_render(void) {
     ImVec2 uv0 = {0,0};
     ImVec2 uv1 = {1,1};
 
+    pendulum_draw();
     ImTextureID tex_id = simgui_imtextureid_with_sampler(pendulum_color_img,pendulum_sampler);
     //igImage(simgui_imtextureid())
     igImage(tex_id, size, uv0, uv1, white,(ImVec4){0,0,0,0});
+    if (pendulum_mode == PENDULUM_MODE_ENSEMBLE) {
+        igText("Pendulums: %d %s", pendulum_ens.count, pendulum_ens.is_double ? "double" : "single");
+        igText("Spread: %.3g rad", (double)sim_series_last(&pendulum_spread_series, 0));
+        return;
+    }
     igText("Pendulum angle: %.2f rad", pendulum_angle);
 }
+
+#endif /* SIM_HEADLESS */
+
+/* Initialization: GPU resources (none in headless builds), then the
+   initial conditions */
+void sim_pendulum_init(void) {
+#ifndef SIM_HEADLESS
+    pendulum_gpu_create();
+#endif
+    // Reset pendulum initial conditions
+    pendulum_reset();
+}
+
+/* Cleanup: GPU resources and the ensemble */
+void sim_pendulum_destroy(void) {
+#ifndef SIM_HEADLESS
+    pendulum_gpu_destroy();
+#endif
+    pendulum_ensemble_destroy(&pendulum_ens);
+}
@@ -1,11 +1,18 @@
 #ifndef PENDULUM_H
 #define PENDULUM_H
 
+#include <stdint.h>
+
+struct sim_parameter_t;
+struct sim_observable_t;
+
 void sim_pendulum_init(void);
 void sim_pendulum_destroy(void);
 void sim_pendulum_update(float dt);
 void sim_pendulum_params_ui(void);
 void sim_pendulum_plot_ui(void);
 void sim_pendulum_render(void);
+struct sim_parameter_t *sim_pendulum_settings(int16_t *count);
+int sim_pendulum_observe(struct sim_observable_t *out);
 
 #endif /* PENDULUM_H */
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "pendulum_ensemble.h"
+#include "workers.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define PE_TWO_PI 6.28318530718f
+#define PE_ROUND_MAGIC 12582912.0f         // 1.5 * 2^23: adding it rounds to an integer
+
+void pendulum_ensemble_create(pendulum_ensemble_t *ens, int count, int is_double,
+                              float theta1, float theta2, float spread) {
+    if (count < 1) count = 1;
+    if (count > PENDULUM_ENSEMBLE_MAX) count = PENDULUM_ENSEMBLE_MAX;
+    count = (count + PENDULUM_ENSEMBLE_LANES - 1) / PENDULUM_ENSEMBLE_LANES * PENDULUM_ENSEMBLE_LANES;
+    ens->count = count;
+    ens->is_double = is_double;
+    ens->angles = (float*)malloc(2 * (size_t)count * sizeof(float));
+    ens->omega1 = (float*)calloc((size_t)count, sizeof(float));
+    ens->omega2 = (float*)calloc((size_t)count, sizeof(float));
+    for (int i = 0; i < count; i++) {
+        ens->angles[i] = theta1 + spread * (float)i / (float)count;
+        ens->angles[count + i] = is_double ? theta2 : 0.0f;
+    }
+}
+
+void pendulum_ensemble_destroy(pendulum_ensemble_t *ens) {
+    free(ens->angles);
+    free(ens->omega1);
+    free(ens->omega2);
+    ens->angles = ens->omega1 = ens->omega2 = NULL;
+    ens->count = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Vectorizable math: |x| < 2^22; about 1e-7 absolute error on [-pi, pi],
+// growing with |x| as float loses digits of the argument
+// -----------------------------------------------------------------------------
+static inline float pe_round(float x) {
+    return (x + PE_ROUND_MAGIC) - PE_ROUND_MAGIC;
+}
+
+static inline float pe_wrap(float x) {
+    return x - PE_TWO_PI * pe_round(x * (1.0f / PE_TWO_PI));
+}
+
+// Quadrant reduction to [-pi/4, pi/4] (pi/2 split in two for Cody-Waite),
+// then the Cephes minimax polynomials
+static inline void pe_sincos(float x, float *s, float *c) {
+    float q = pe_round(x * 0.636619772f);
+    float r = (x - q * 1.57079637f) + q * 4.37113900e-8f;
+    float r2 = r * r;
+    float sr = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    float cr = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568e-2f + r2 * (-1.388731625e-3f + r2 * 2.443315711e-5f));
+    int quadrant = (int)q;
+    int swap = quadrant & 1;
+    float sv = swap ? cr : sr;
+    float cv = swap ? sr : cr;
+    *s = (quadrant & 2) ? -sv : sv;
+    *c = ((quadrant + 1) & 2) ? -cv : cv;
+}
+
+// -----------------------------------------------------------------------------
+// Derivatives of one block
+// -----------------------------------------------------------------------------
+typedef struct pe_block_t {
+    float t1[PENDULUM_ENSEMBLE_LANES], t2[PENDULUM_ENSEMBLE_LANES];
+    float w1[PENDULUM_ENSEMBLE_LANES], w2[PENDULUM_ENSEMBLE_LANES];
+} pe_block_t;
+
+static inline void pe_deriv_single(const pe_block_t *y, pe_block_t *d, float k) {
+    for (int l = 0; l < PENDULUM_ENSEMBLE_LANES; l++) {
+        float s, c;
+        pe_sincos(y->t1[l], &s, &c);
+        d->t1[l] = y->w1[l];
+        d->w1[l] = -k * s;
+        d->t2[l] = 0.0f;
+        d->w2[l] = 0.0f;
+    }
+}
+
+// Equal masses and arms: with D = t1 - t2,
+//   w1' = (-3 g sin t1 - g sin(t1 - 2 t2) - 2 sin D (w2^2 L + w1^2 L cos D)) / (L (3 - cos 2D))
+//   w2' = 2 sin D (2 w1^2 L + 2 g cos t1 + w2^2 L cos D) / (L (3 - cos 2D))
+// where sin(t1 - 2 t2) = sin 2D cos t1 - cos 2D sin t1
+static inline void pe_deriv_double(const pe_block_t *y, pe_block_t *d, float g, float length) {
+    const float inv_length = 1.0f / length;
+    for (int l = 0; l < PENDULUM_ENSEMBLE_LANES; l++) {
+        float s1, c1, sd, cd;
+        pe_sincos(y->t1[l], &s1, &c1);
+        pe_sincos(y->t1[l] - y->t2[l], &sd, &cd);
+        float c2d = 2.0f * cd * cd - 1.0f;
+        float s2d = 2.0f * sd * cd;
+        float w1 = y->w1[l], w2 = y->w2[l];
+        float inv_den = inv_length / (3.0f - c2d);
+        float sin_t1_2t2 = s2d * c1 - c2d * s1;
+        d->t1[l] = w1;
+        d->t2[l] = w2;
+        d->w1[l] = (-3.0f * g * s1 - g * sin_t1_2t2 - 2.0f * sd * length * (w2 * w2 + w1 * w1 * cd)) * inv_den;
+        d->w2[l] = 2.0f * sd * (2.0f * length * w1 * w1 + 2.0f * g * c1 + length * w2 * w2 * cd) * inv_den;
+    }
+}
+
+// out = y + h * d
+static inline void pe_axpy(const pe_block_t *y, const pe_block_t *d, float h, pe_block_t *out) {
+    for (int l = 0; l < PENDULUM_ENSEMBLE_LANES; l++) {
+        out->t1[l] = y->t1[l] + h * d->t1[l];
+        out->t2[l] = y->t2[l] + h * d->t2[l];
+        out->w1[l] = y->w1[l] + h * d->w1[l];
+        out->w2[l] = y->w2[l] + h * d->w2[l];
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Step
+// -----------------------------------------------------------------------------
+typedef struct pe_step_ctx_t {
+    pendulum_ensemble_t *ens;
+    float gravity, length, h;
+    int steps;
+} pe_step_ctx_t;
+
+static void pe_step_task(void *arg, int task, int worker) {
+    (void)worker;
+    const pe_step_ctx_t *ctx = (const pe_step_ctx_t*)arg;
+    pendulum_ensemble_t *ens = ctx->ens;
+    const float h = ctx->h, k = ctx->gravity / ctx->length;
+    float *theta1 = ens->angles, *theta2 = ens->angles + ens->count;
+    int begin = task * PENDULUM_ENSEMBLE_TASK;
+    int end = begin + PENDULUM_ENSEMBLE_TASK;
+    if (end > ens->count) end = ens->count;
+
+    for (int base = begin; base < end; base += PENDULUM_ENSEMBLE_LANES) {
+        pe_block_t y, tmp, k1, k2, k3, k4;
+        for (int l = 0; l < PENDULUM_ENSEMBLE_LANES; l++) {
+            y.t1[l] = theta1[base + l];
+            y.t2[l] = theta2[base + l];
+            y.w1[l] = ens->omega1[base + l];
+            y.w2[l] = ens->omega2[base + l];
+        }
+        for (int s = 0; s < ctx->steps; s++) {
+            if (ens->is_double) {
+                pe_deriv_double(&y, &k1, ctx->gravity, ctx->length);
+                pe_axpy(&y, &k1, 0.5f * h, &tmp);
+                pe_deriv_double(&tmp, &k2, ctx->gravity, ctx->length);
+                pe_axpy(&y, &k2, 0.5f * h, &tmp);
+                pe_deriv_double(&tmp, &k3, ctx->gravity, ctx->length);
+                pe_axpy(&y, &k3, h, &tmp);
+                pe_deriv_double(&tmp, &k4, ctx->gravity, ctx->length);
+            } else {
+                pe_deriv_single(&y, &k1, k);
+                pe_axpy(&y, &k1, 0.5f * h, &tmp);
+                pe_deriv_single(&tmp, &k2, k);
+                pe_axpy(&y, &k2, 0.5f * h, &tmp);
+                pe_deriv_single(&tmp, &k3, k);
+                pe_axpy(&y, &k3, h, &tmp);
+                pe_deriv_single(&tmp, &k4, k);
+            }
+            const float h6 = h * (1.0f / 6.0f);
+            for (int l = 0; l < PENDULUM_ENSEMBLE_LANES; l++) {
+                y.t1[l] = pe_wrap(y.t1[l] + h6 * (k1.t1[l] + 2.0f * (k2.t1[l] + k3.t1[l]) + k4.t1[l]));
+                y.t2[l] = pe_wrap(y.t2[l] + h6 * (k1.t2[l] + 2.0f * (k2.t2[l] + k3.t2[l]) + k4.t2[l]));
+                y.w1[l] += h6 * (k1.w1[l] + 2.0f * (k2.w1[l] + k3.w1[l]) + k4.w1[l]);
+                y.w2[l] += h6 * (k1.w2[l] + 2.0f * (k2.w2[l] + k3.w2[l]) + k4.w2[l]);
+            }
+        }
+        for (int l = 0; l < PENDULUM_ENSEMBLE_LANES; l++) {
+            theta1[base + l] = y.t1[l];
+            theta2[base + l] = y.t2[l];
+            ens->omega1[base + l] = y.w1[l];
+            ens->omega2[base + l] = y.w2[l];
+        }
+    }
+}
+
+void pendulum_ensemble_step(pendulum_ensemble_t *ens, float gravity, float length, float h, int steps) {
+    if (steps < 1 || ens->count == 0) return;
+    pe_step_ctx_t ctx = { ens, gravity, length, h, steps };
+    int tasks = (ens->count + PENDULUM_ENSEMBLE_TASK - 1) / PENDULUM_ENSEMBLE_TASK;
+    sim_workers_run(pe_step_task, &ctx, tasks);
+}
+
+double pendulum_ensemble_spread(const pendulum_ensemble_t *ens) {
+    if (ens->count == 0) return 0.0;
+    const float *theta1 = ens->angles, *theta2 = ens->angles + ens->count;
+    double sum = 0.0;
+    for (int i = 0; i < ens->count; i++) {
+        float d1 = pe_wrap(theta1[i] - theta1[0]);
+        float d2 = pe_wrap(theta2[i] - theta2[0]);
+        sum += (double)(d1 * d1 + d2 * d2);
+    }
+    return sqrt(sum / ens->count);
+}
@@ -0,0 +1,50 @@
+#ifndef PENDULUM_ENSEMBLE_H
+#define PENDULUM_ENSEMBLE_H
+
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Ensemble of single or double pendulums with perturbed initial conditions
+//
+// State is stored as structure-of-arrays in float. The angles live in one
+// allocation, every theta1 followed by every theta2, so the renderer uploads
+// them with a single buffer update and binds the two halves as two instance
+// attributes; nothing is repacked per frame.
+//
+// Pendulums are stepped with RK4 in blocks of PENDULUM_ENSEMBLE_LANES side
+// by side. sin and cos come from a branch-free polynomial instead of libm,
+// so the lane loops vectorize. Angles are wrapped to [-pi, pi] after every
+// step, which keeps the argument reduction short and exact. Blocks are
+// split into tasks on the shared worker pool; pendulums are independent, so
+// the result does not depend on the thread count.
+//
+// A double pendulum has two unit masses on massless arms of equal length.
+// Pendulum i starts at (theta1 + i * spread / count, theta2) at rest, so the
+// whole ensemble starts within `spread` radians of the first one.
+// -----------------------------------------------------------------------------
+
+#define PENDULUM_ENSEMBLE_LANES 8
+#define PENDULUM_ENSEMBLE_TASK 4096        // Pendulums per worker task
+#define PENDULUM_ENSEMBLE_MAX 131072
+
+typedef struct pendulum_ensemble_t {
+    int count;                   // A multiple of PENDULUM_ENSEMBLE_LANES
+    int is_double;
+    float *angles;               // theta1[count] then theta2[count]
+    float *omega1;
+    float *omega2;
+} pendulum_ensemble_t;
+
+// count is rounded up to whole lanes and clamped to PENDULUM_ENSEMBLE_MAX
+void pendulum_ensemble_create(pendulum_ensemble_t *ens, int count, int is_double,
+                              float theta1, float theta2, float spread);
+void pendulum_ensemble_destroy(pendulum_ensemble_t *ens);
+
+// `steps` RK4 steps of size h
+void pendulum_ensemble_step(pendulum_ensemble_t *ens, float gravity, float length, float h, int steps);
+
+// RMS angular distance (both angles, wrapped) from pendulum 0: how far the
+// ensemble has spread from its unperturbed member
+double pendulum_ensemble_spread(const pendulum_ensemble_t *ens);
+
+#endif /* PENDULUM_ENSEMBLE_H */
@@ -0,0 +1,161 @@
+#include "pendulum_integrator.h"
+#include <math.h>
+
+#define PENDULUM_RK45_SAFETY 0.9
+#define PENDULUM_RK45_MIN_SCALE 0.2
+#define PENDULUM_RK45_MAX_SCALE 5.0
+#define PENDULUM_RK45_MIN_H 1e-9
+
+void pendulum_solver_init(pendulum_solver_t *solver, pendulum_integrator_t integrator,
+                          double theta, double omega, double tolerance) {
+    solver->integrator = integrator;
+    solver->theta = theta;
+    solver->omega = omega;
+    solver->tolerance = tolerance;
+    solver->rk45_h = 0.0;
+    solver->fsal_valid = 0;
+    solver->evals = 0;
+    solver->rejected = 0;
+}
+
+// (theta', omega') at a state
+static inline void pendulum_deriv(pendulum_solver_t *solver, double k, double theta, double omega, double out[2]) {
+    out[0] = omega;
+    out[1] = -k * sin(theta);
+    solver->evals++;
+}
+
+// Derivative at the current state, from the FSAL cache when still valid
+static void pendulum_first_deriv(pendulum_solver_t *solver, double k, double out[2]) {
+    if (!solver->fsal_valid || solver->fsal_k != k) {
+        pendulum_deriv(solver, k, solver->theta, solver->omega, solver->fsal);
+        solver->fsal_k = k;
+        solver->fsal_valid = 1;
+    }
+    out[0] = solver->fsal[0];
+    out[1] = solver->fsal[1];
+}
+
+// -----------------------------------------------------------------------------
+// Fixed-step methods
+// -----------------------------------------------------------------------------
+static void pendulum_step_euler(pendulum_solver_t *solver, double k, double h) {
+    solver->evals++;
+    solver->omega -= k * sin(solver->theta) * h;
+    solver->theta += solver->omega * h;
+}
+
+static void pendulum_step_verlet(pendulum_solver_t *solver, double k, double h) {
+    double d[2];
+    pendulum_first_deriv(solver, k, d);
+    double omega_half = solver->omega + 0.5 * h * d[1];
+    solver->theta += h * omega_half;
+    pendulum_deriv(solver, k, solver->theta, omega_half, solver->fsal);
+    solver->omega = omega_half + 0.5 * h * solver->fsal[1];
+    solver->fsal[0] = solver->omega;
+}
+
+static void pendulum_step_rk4(pendulum_solver_t *solver, double k, double h) {
+    double t = solver->theta, w = solver->omega;
+    double k1[2], k2[2], k3[2], k4[2];
+    pendulum_deriv(solver, k, t, w, k1);
+    pendulum_deriv(solver, k, t + 0.5 * h * k1[0], w + 0.5 * h * k1[1], k2);
+    pendulum_deriv(solver, k, t + 0.5 * h * k2[0], w + 0.5 * h * k2[1], k3);
+    pendulum_deriv(solver, k, t + h * k3[0], w + h * k3[1], k4);
+    solver->theta = t + h / 6.0 * (k1[0] + 2.0 * k2[0] + 2.0 * k3[0] + k4[0]);
+    solver->omega = w + h / 6.0 * (k1[1] + 2.0 * k2[1] + 2.0 * k3[1] + k4[1]);
+}
+
+// -----------------------------------------------------------------------------
+// Dormand-Prince 5(4)
+// -----------------------------------------------------------------------------
+static const double dp_a2[1] = { 1.0 / 5.0 };
+static const double dp_a3[2] = { 3.0 / 40.0, 9.0 / 40.0 };
+static const double dp_a4[3] = { 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0 };
+static const double dp_a5[4] = { 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0 };
+static const double dp_a6[5] = { 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0 };
+// Fifth order weights (also the last stage, FSAL); b2 is zero
+static const double dp_b[6] = { 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 };
+// Fifth minus fourth order weights, the last for the FSAL stage
+static const double dp_e[7] = { 71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0,
+                                -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0 };
+
+// Stage input y + h * sum(a[j] * k[j])
+static inline void dp_stage(double t, double w, double h, const double *a, double ks[][2], int n, double *ts, double *ws) {
+    double dt = 0.0, dw = 0.0;
+    for (int j = 0; j < n; j++) {
+        dt += a[j] * ks[j][0];
+        dw += a[j] * ks[j][1];
+    }
+    *ts = t + h * dt;
+    *ws = w + h * dw;
+}
+
+// One trial step; returns the scaled error norm (accept when <= 1)
+static double pendulum_rk45_try(pendulum_solver_t *solver, double k, double h, double *t_out, double *w_out, double k7[2]) {
+    double t = solver->theta, w = solver->omega;
+    double ks[6][2];
+    double ts, ws;
+    pendulum_first_deriv(solver, k, ks[0]);
+    dp_stage(t, w, h, dp_a2, ks, 1, &ts, &ws); pendulum_deriv(solver, k, ts, ws, ks[1]);
+    dp_stage(t, w, h, dp_a3, ks, 2, &ts, &ws); pendulum_deriv(solver, k, ts, ws, ks[2]);
+    dp_stage(t, w, h, dp_a4, ks, 3, &ts, &ws); pendulum_deriv(solver, k, ts, ws, ks[3]);
+    dp_stage(t, w, h, dp_a5, ks, 4, &ts, &ws); pendulum_deriv(solver, k, ts, ws, ks[4]);
+    dp_stage(t, w, h, dp_a6, ks, 5, &ts, &ws); pendulum_deriv(solver, k, ts, ws, ks[5]);
+    dp_stage(t, w, h, dp_b, ks, 6, t_out, w_out);
+    pendulum_deriv(solver, k, *t_out, *w_out, k7);
+
+    double et = dp_e[6] * k7[0], ew = dp_e[6] * k7[1];
+    for (int j = 0; j < 6; j++) {
+        et += dp_e[j] * ks[j][0];
+        ew += dp_e[j] * ks[j][1];
+    }
+    double st = solver->tolerance * (1.0 + fabs(t)), sw = solver->tolerance * (1.0 + fabs(w));
+    return fmax(fabs(h * et) / st, fabs(h * ew) / sw);
+}
+
+static void pendulum_step_rk45(pendulum_solver_t *solver, double k, double h) {
+    double remaining = h;
+    double step = (solver->rk45_h > 0.0) ? solver->rk45_h : h;
+    while (remaining > 0.0) {
+        // Land exactly on the end of the requested step; a step clipped to
+        // fit says nothing about the size the next one can have
+        int clipped = step >= remaining * (1.0 - 1e-9);
+        double trial = clipped ? remaining : step;
+        double t_new, w_new, k7[2];
+        double err = pendulum_rk45_try(solver, k, trial, &t_new, &w_new, k7);
+        double scale = (err > 0.0) ? PENDULUM_RK45_SAFETY * pow(err, -0.2) : PENDULUM_RK45_MAX_SCALE;
+        scale = fmin(PENDULUM_RK45_MAX_SCALE, fmax(PENDULUM_RK45_MIN_SCALE, scale));
+        if (err <= 1.0 || trial <= PENDULUM_RK45_MIN_H) {
+            solver->theta = t_new;
+            solver->omega = w_new;
+            solver->fsal[0] = k7[0];
+            solver->fsal[1] = k7[1];
+            remaining = clipped ? 0.0 : remaining - trial;
+            if (!clipped) step = trial * scale;
+        } else {
+            solver->rejected++;
+            step = trial * scale;
+        }
+    }
+    solver->rk45_h = step;
+}
+
+void pendulum_solver_step(pendulum_solver_t *solver, double k, double h) {
+    switch (solver->integrator) {
+        case PENDULUM_INTEGRATOR_EULER:
+            pendulum_step_euler(solver, k, h);
+            solver->fsal_valid = 0;
+            break;
+        case PENDULUM_INTEGRATOR_VERLET:
+            pendulum_step_verlet(solver, k, h);
+            break;
+        case PENDULUM_INTEGRATOR_RK4:
+            pendulum_step_rk4(solver, k, h);
+            solver->fsal_valid = 0;
+            break;
+        default:
+            pendulum_step_rk45(solver, k, h);
+            break;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef PENDULUM_INTEGRATOR_H
+#define PENDULUM_INTEGRATOR_H
+
+#include <math.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Integrators for the simple pendulum, theta'' = -(g / L) sin(theta)
+//
+// State is kept in double. Every solver advances by exactly the step it is
+// given, so they can all be driven by the same fixed-timestep clock and
+// compared at equal simulated times:
+//
+// - Semi-implicit Euler: first order, symplectic; the original update.
+// - Velocity Verlet (leapfrog): second order, symplectic, so the energy
+//   error stays bounded instead of drifting.
+// - RK4: classic fourth order; not symplectic, the energy drifts slowly.
+// - Dormand-Prince RK45: fifth order with an embedded fourth order error
+//   estimate. It takes as many internal steps as the tolerance needs to
+//   cover the requested step and carries its step size from call to call.
+//
+// Verlet and RK45 reuse the last derivative of a step as the first of the
+// next (FSAL), so they cost 1 and 6 derivative evaluations per step. The
+// cache is dropped when g / L changes. `evals` counts every evaluation, the
+// cost measure the UI compares integrators by.
+// -----------------------------------------------------------------------------
+
+typedef enum {
+    PENDULUM_INTEGRATOR_EULER,
+    PENDULUM_INTEGRATOR_VERLET,
+    PENDULUM_INTEGRATOR_RK4,
+    PENDULUM_INTEGRATOR_RK45,
+    PENDULUM_INTEGRATOR_COUNT
+} pendulum_integrator_t;
+
+typedef struct pendulum_solver_t {
+    pendulum_integrator_t integrator;
+    double theta;
+    double omega;
+    double tolerance;            // RK45: error allowed per internal step
+    double rk45_h;               // RK45: next internal step size, 0 to pick one
+    double fsal[2];              // Derivative at the current state
+    double fsal_k;               // g / L it was computed with
+    int fsal_valid;
+    uint64_t evals;              // Derivative evaluations so far
+    uint64_t rejected;           // RK45: internal steps redone with a smaller h
+} pendulum_solver_t;
+
+void pendulum_solver_init(pendulum_solver_t *solver, pendulum_integrator_t integrator,
+                          double theta, double omega, double tolerance);
+
+// Advance by exactly h with k = g / L
+void pendulum_solver_step(pendulum_solver_t *solver, double k, double h);
+
+// Energy per unit mass, zero at the pivot height
+static inline double pendulum_energy(double theta, double omega, double gravity, double length) {
+    return 0.5 * length * length * omega * omega - gravity * length * cos(theta);
+}
+
+#endif /* PENDULUM_INTEGRATOR_H */
@@ -0,0 +1,82 @@
+#include "rng.h"
+
+static uint64_t rng_seed = SIM_RNG_DEFAULT_SEED;
+
+uint64_t sim_rng_seed(void) {
+    return rng_seed;
+}
+
+void sim_rng_set_seed(uint64_t seed) {
+    rng_seed = seed;
+}
+
+// -----------------------------------------------------------------------------
+// Streams
+// -----------------------------------------------------------------------------
+void sim_rng_init(sim_rng_t *rng, uint64_t seed, uint64_t stream) {
+    rng->key[0] = (uint32_t)seed;
+    rng->key[1] = (uint32_t)(seed >> 32);
+    rng->stream = stream;
+    rng->block = 0;
+    rng->used = 4;               // Empty: the first draw generates block 0
+}
+
+void sim_rng_block(uint64_t seed, uint64_t stream, uint64_t index, uint32_t out[4]) {
+    out[0] = (uint32_t)index;
+    out[1] = (uint32_t)(index >> 32);
+    out[2] = (uint32_t)stream;
+    out[3] = (uint32_t)(stream >> 32);
+    sim_rng_philox(out, (uint32_t)seed, (uint32_t)(seed >> 32));
+}
+
+void sim_rng_refill(sim_rng_t *rng) {
+    uint32_t *ctr = rng->buffer;
+    ctr[0] = (uint32_t)rng->block;
+    ctr[1] = (uint32_t)(rng->block >> 32);
+    ctr[2] = (uint32_t)rng->stream;
+    ctr[3] = (uint32_t)(rng->stream >> 32);
+    sim_rng_philox(ctr, rng->key[0], rng->key[1]);
+    rng->block++;
+    rng->used = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Bulk generation: leftovers of the current block, then whole blocks straight
+// into the output, then a fresh block for the tail
+// -----------------------------------------------------------------------------
+void sim_rng_fill_u32(sim_rng_t *rng, uint32_t *out, size_t count) {
+    size_t i = 0;
+    while (i < count && rng->used < 4) {
+        out[i++] = rng->buffer[rng->used++];
+    }
+
+    const uint32_t k0 = rng->key[0], k1 = rng->key[1];
+    const uint32_t s0 = (uint32_t)rng->stream, s1 = (uint32_t)(rng->stream >> 32);
+    uint64_t block = rng->block;
+    for (; i + 4 <= count; i += 4, block++) {
+        uint32_t ctr[4] = { (uint32_t)block, (uint32_t)(block >> 32), s0, s1 };
+        sim_rng_philox(ctr, k0, k1);
+        out[i] = ctr[0];
+        out[i + 1] = ctr[1];
+        out[i + 2] = ctr[2];
+        out[i + 3] = ctr[3];
+    }
+    rng->block = block;
+
+    while (i < count) {
+        out[i++] = sim_rng_u32(rng);
+    }
+}
+
+void sim_rng_fill_float(sim_rng_t *rng, float *out, size_t count) {
+    uint32_t words[256];
+    while (count > 0) {
+        size_t n = count < 256 ? count : 256;
+        sim_rng_fill_u32(rng, words, n);
+        for (size_t i = 0; i < n; i++) {
+            out[i] = (float)(words[i] >> 8) * (1.0f / 16777216.0f);
+        }
+        out += n;
+        count -= n;
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+// Counter-based random numbers shared by all simulations
+//
+// Philox4x32-10 maps a 128-bit counter and a 64-bit key to four random
+// 32-bit words with no state carried between calls, so any draw can be
+// computed directly from (seed, stream, index): the key is the seed, the
+// counter holds the stream in its high half and the block index in its low
+// half. Distinct streams are independent, so every band, worker task or
+// lattice site can own one and results do not depend on which thread runs
+// what, or in which order.
+//
+// sim_rng_t walks one stream a block at a time for sequential draws. The fill
+// functions produce whole vectors, and their block loop carries nothing from
+// one iteration to the next. Batched kernels that consume the words right
+// away use sim_rng_philox_lanes, SIM_RNG_LANES blocks side by side in
+// structure-of-arrays form so the rounds vectorize. Kernels that keep their
+// own inner-loop generators (the Ising lanes) seed them from a stream here.
+//
+// The seed is global and set from the UI. Simulations read it when they
+// (re)initialize, so a given seed reproduces a run bit for bit.
+// -----------------------------------------------------------------------------
+
+// Stream namespaces: users of the same seed never share a stream. The low
+// bits are free for per-band, per-thread or per-site indices.
+#define SIM_RNG_STREAM_MCPI            (1ULL << 56)
+#define SIM_RNG_STREAM_GOL             (2ULL << 56)
+#define SIM_RNG_STREAM_ISING_LATTICE   (3ULL << 56)
+#define SIM_RNG_STREAM_ISING_MSC       (4ULL << 56)
+#define SIM_RNG_STREAM_ISING_CLUSTER   (5ULL << 56)
+#define SIM_RNG_STREAM_ISING_TEMPERING (6ULL << 56)
+
+#define SIM_RNG_DEFAULT_SEED 0x5EEDULL
+#define SIM_RNG_LANES 8          // Blocks generated together by sim_rng_philox_lanes
+
+typedef struct sim_rng_t {
+    uint32_t key[2];             // The seed
+    uint64_t stream;             // Counter words 2 and 3
+    uint64_t block;              // Counter words 0 and 1, next block to generate
+    uint32_t buffer[4];          // Current block
+    int used;                    // Words of buffer already handed out
+} sim_rng_t;
+
+// One Philox4x32-10 block: ctr is replaced by its four random words
+static inline void sim_rng_philox(uint32_t ctr[4], uint32_t k0, uint32_t k1) {
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)0xD2511F53u * ctr[0];
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * ctr[2];
+        uint32_t c0 = (uint32_t)(p1 >> 32) ^ ctr[1] ^ k0;
+        uint32_t c2 = (uint32_t)(p0 >> 32) ^ ctr[3] ^ k1;
+        ctr[0] = c0;
+        ctr[1] = (uint32_t)p1;
+        ctr[2] = c2;
+        ctr[3] = (uint32_t)p0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+// SIM_RNG_LANES blocks at once: lane l of ctr[0..3] is one counter, replaced
+// by its random words
+static inline void sim_rng_philox_lanes(uint32_t ctr[4][SIM_RNG_LANES], uint32_t k0, uint32_t k1) {
+    for (int round = 0; round < 10; round++) {
+        for (int l = 0; l < SIM_RNG_LANES; l++) {
+            uint64_t p0 = (uint64_t)0xD2511F53u * ctr[0][l];
+            uint64_t p1 = (uint64_t)0xCD9E8D57u * ctr[2][l];
+            uint32_t c0 = (uint32_t)(p1 >> 32) ^ ctr[1][l] ^ k0;
+            uint32_t c2 = (uint32_t)(p0 >> 32) ^ ctr[3][l] ^ k1;
+            ctr[0][l] = c0;
+            ctr[1][l] = (uint32_t)p1;
+            ctr[2][l] = c2;
+            ctr[3][l] = (uint32_t)p0;
+        }
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+// Counters for SIM_RNG_LANES consecutive blocks of a stream from `block` on
+static inline void sim_rng_lanes_counters(uint32_t ctr[4][SIM_RNG_LANES], uint64_t stream, uint64_t block) {
+    for (int l = 0; l < SIM_RNG_LANES; l++) {
+        uint64_t b = block + (uint64_t)l;
+        ctr[0][l] = (uint32_t)b;
+        ctr[1][l] = (uint32_t)(b >> 32);
+        ctr[2][l] = (uint32_t)stream;
+        ctr[3][l] = (uint32_t)(stream >> 32);
+    }
+}
+
+// Global seed, read by simulations at init
+uint64_t sim_rng_seed(void);
+void sim_rng_set_seed(uint64_t seed);
+
+// Start of a stream
+void sim_rng_init(sim_rng_t *rng, uint64_t seed, uint64_t stream);
+
+// Block `index` of a stream without any state, e.g. one block per site and step
+void sim_rng_block(uint64_t seed, uint64_t stream, uint64_t index, uint32_t out[4]);
+
+void sim_rng_refill(sim_rng_t *rng);
+
+static inline uint32_t sim_rng_u32(sim_rng_t *rng) {
+    if (rng->used == 4) {
+        sim_rng_refill(rng);
+    }
+    return rng->buffer[rng->used++];
+}
+
+static inline uint64_t sim_rng_u64(sim_rng_t *rng) {
+    uint64_t hi = sim_rng_u32(rng);
+    return (hi << 32) | sim_rng_u32(rng);
+}
+
+// Uniform in [0, 1) with 24 and 53 random bits
+static inline float sim_rng_float(sim_rng_t *rng) {
+    return (float)(sim_rng_u32(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline double sim_rng_double(sim_rng_t *rng) {
+    return (double)(sim_rng_u64(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Uniform in [0, n) by multiply-shift (bias below n / 2^32)
+static inline uint32_t sim_rng_below(sim_rng_t *rng, uint32_t n) {
+    return (uint32_t)(((uint64_t)sim_rng_u32(rng) * n) >> 32);
+}
+
+// Bulk generation; continues the stream exactly as repeated single draws would
+void sim_rng_fill_u32(sim_rng_t *rng, uint32_t *out, size_t count);
+void sim_rng_fill_float(sim_rng_t *rng, float *out, size_t count);
+
+#endif /* RNG_H */
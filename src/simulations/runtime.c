@@ -0,0 +1,112 @@
+#include "simulations.h"
+
+#include "none.h"
+#include "pendulum.h"
+#include "mcpi.h"
+#include "gol.h"
+#include "ising.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Runtime registry (see simulations.h)
+// -----------------------------------------------------------------------------
+#define X(ID,NAME,INIT,DEST,UPDATE,PARAMS_UI,PLOT_UI,RENDER,TIMESTEP,PUBLISH,SETTINGS,OBSERVE) \
+    [ID] = {#ID, NAME, INIT, DEST, UPDATE, TIMESTEP, SETTINGS, OBSERVE},
+static const sim_runtime_t g_runtimes[SIM_COUNT] = {
+    X_SIMULATIONS
+};
+#undef X
+
+static bool runtime_name_equal(const char* a, const char* b) {
+    for (; *a && *b; a++, b++) {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+            return false;
+        }
+    }
+    return *a == *b;
+}
+
+const sim_runtime_t* sim_runtime_get(simulation_id_t id) {
+    if ((int)id < 0 || id >= SIM_COUNT) {
+        return NULL;
+    }
+    return &g_runtimes[id];
+}
+
+const sim_runtime_t* sim_runtime_find(const char* name) {
+    for (int i = 0; i < SIM_COUNT; i++) {
+        if (runtime_name_equal(name, g_runtimes[i].name) || runtime_name_equal(name, g_runtimes[i].id)) {
+            return &g_runtimes[i];
+        }
+    }
+    return NULL;
+}
+
+bool sim_runtime_set(const sim_runtime_t* sim, const char* assignment, char* error, size_t error_size) {
+    const char* eq = strchr(assignment, '=');
+    if (!eq) {
+        snprintf(error, error_size, "expected NAME=VALUE, got '%s'", assignment);
+        return false;
+    }
+    char name[128];
+    size_t len = (size_t)(eq - assignment);
+    if (len >= sizeof(name)) len = sizeof(name) - 1;
+    memcpy(name, assignment, len);
+    name[len] = '\0';
+    const char* text = eq + 1;
+
+    int16_t count;
+    sim_parameter_t* params = sim->settings(&count);
+    for (int16_t i = 0; i < count; i++) {
+        sim_parameter_t* p = &params[i];
+        if (!runtime_name_equal(name, p->name)) {
+            continue;
+        }
+        char* end;
+        switch (p->type) {
+            case SIM_PARAM_FLOAT: {
+                float v = strtof(text, &end);
+                if (end == text || *end != '\0' || v < p->f_min || v > p->f_max) {
+                    snprintf(error, error_size, "%s takes a number in [%g, %g]", p->name, p->f_min, p->f_max);
+                    return false;
+                }
+                *(float*)p->value_ptr = v;
+                return true;
+            }
+            case SIM_PARAM_INT: {
+                long v = strtol(text, &end, 0);
+                if (end == text || *end != '\0' || v < p->i_min || v > p->i_max) {
+                    snprintf(error, error_size, "%s takes an integer in [%d, %d]", p->name, p->i_min, p->i_max);
+                    return false;
+                }
+                *(int*)p->value_ptr = (int)v;
+                return true;
+            }
+            case SIM_PARAM_BOOL:
+                if (runtime_name_equal(text, "1") || runtime_name_equal(text, "true") || runtime_name_equal(text, "on")) {
+                    *(bool*)p->value_ptr = true;
+                } else if (runtime_name_equal(text, "0") || runtime_name_equal(text, "false") || runtime_name_equal(text, "off")) {
+                    *(bool*)p->value_ptr = false;
+                } else {
+                    snprintf(error, error_size, "%s takes true or false", p->name);
+                    return false;
+                }
+                return true;
+        }
+    }
+    snprintf(error, error_size, "%s has no setting '%s'", sim->name, name);
+    return false;
+}
+
+double sim_observable_find(const sim_observable_t* obs, int count, const char* name, double fallback) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(obs[i].name, name) == 0) {
+            return obs[i].value;
+        }
+    }
+    return fallback;
+}
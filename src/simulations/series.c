@@ -0,0 +1,99 @@
+#include "simulations.h"
+
+// -----------------------------------------------------------------------------
+// Time series (see simulations.h); plotting is in simulations.c
+// -----------------------------------------------------------------------------
+void sim_series_init(sim_series_t *series, int channel_count) {
+    if (channel_count < 1) channel_count = 1;
+    if (channel_count > SIM_SERIES_MAX_CHANNELS) channel_count = SIM_SERIES_MAX_CHANNELS;
+    series->channel_count = channel_count;
+    sim_series_clear(series);
+}
+
+void sim_series_clear(sim_series_t *series) {
+    series->total = 0;
+    series->x_first = 0.0;
+    series->head = 0;
+    series->recent_count = 0;
+    series->bucket_count = 0;
+    series->bucket_span = 1;
+}
+
+// Fold b into a copy of a; dst may alias either
+static void series_bucket_merge(sim_series_bucket_t *dst, const sim_series_bucket_t *a,
+                                const sim_series_bucket_t *b, int channel_count) {
+    sim_series_bucket_t merged = *a;
+    merged.count += b->count;
+    for (int c = 0; c < channel_count; c++) {
+        if (b->min[c] < merged.min[c]) {
+            merged.min[c] = b->min[c];
+            merged.x_min[c] = b->x_min[c];
+        }
+        if (b->max[c] > merged.max[c]) {
+            merged.max[c] = b->max[c];
+            merged.x_max[c] = b->x_max[c];
+        }
+    }
+    *dst = merged;
+}
+
+void sim_series_push(sim_series_t *series, double x, const float *values) {
+    if (series->total == 0) {
+        series->x_first = x;
+    }
+
+    // Full-resolution ring
+    series->x[series->head] = x;
+    for (int c = 0; c < series->channel_count; c++) {
+        series->y[c][series->head] = values[c];
+    }
+    series->head = (series->head + 1) % SIM_SERIES_RECENT;
+    if (series->recent_count < SIM_SERIES_RECENT) {
+        series->recent_count++;
+    }
+
+    // Min/max tier: open a new bucket when the last one is full, halving the
+    // resolution first if there is no room left
+    sim_series_bucket_t *bucket = series->bucket_count ? &series->buckets[series->bucket_count - 1] : NULL;
+    if (bucket == NULL || bucket->count >= series->bucket_span) {
+        if (series->bucket_count == SIM_SERIES_BUCKETS) {
+            for (int i = 0; i < SIM_SERIES_BUCKETS / 2; i++) {
+                series_bucket_merge(&series->buckets[i], &series->buckets[2 * i],
+                                    &series->buckets[2 * i + 1], series->channel_count);
+            }
+            series->bucket_count = SIM_SERIES_BUCKETS / 2;
+            series->bucket_span *= 2;
+        }
+        bucket = &series->buckets[series->bucket_count++];
+        bucket->first = series->total;
+        bucket->count = 0;
+    }
+    for (int c = 0; c < series->channel_count; c++) {
+        if (bucket->count == 0 || values[c] < bucket->min[c]) {
+            bucket->min[c] = values[c];
+            bucket->x_min[c] = x;
+        }
+        if (bucket->count == 0 || values[c] > bucket->max[c]) {
+            bucket->max[c] = values[c];
+            bucket->x_max[c] = x;
+        }
+    }
+    bucket->count++;
+    series->total++;
+}
+
+float sim_series_last(const sim_series_t *series, int channel) {
+    if (series->recent_count == 0) {
+        return 0.0f;
+    }
+    return series->y[channel][(series->head + SIM_SERIES_RECENT - 1) % SIM_SERIES_RECENT];
+}
+
+int sim_series_x_range(const sim_series_t *series, double *x_min, double *x_max) {
+    if (series->total < 2) {
+        return 0;
+    }
+    *x_min = series->x_first;
+    *x_max = series->x[(series->head + SIM_SERIES_RECENT - 1) % SIM_SERIES_RECENT];
+    return 1;
+}
@@ -2,6 +2,7 @@
 #include "sokol_gfx.h"
 #include "sokol_log.h"
 #include "sokol_glue.h"
+#include "sokol_time.h"
 #ifndef CIMGUI_DEFINE_ENUMS_AND_STRUCTS
     #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #endif
@@ -16,14 +17,29 @@
 #include "mcpi.h"
 #include "gol.h"
 #include "ising.h"
+#include "workers.h"
+#include "rng.h"
+#include "gpu_cache.h"
 
+#include <assert.h>
 #include <math.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Same platforms as the worker pool (workers.c)
+#if (defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)) || (defined(_WIN32) && !defined(__MINGW32__))
+    #define SIM_THREAD_AVAILABLE 0
+#else
+    #define SIM_THREAD_AVAILABLE 1
+    #include <pthread.h>
+    #include <time.h>
+#endif
 
 #undef X
-#define X(ID,NAME,INIT,DEST,UPDATE,PARAMS_UI,PLOT_UI,RENDER) \
-    [ID] = {NAME, INIT, DEST, UPDATE, NULL, 0, PARAMS_UI, PLOT_UI, RENDER},
+#define X(ID,NAME,INIT,DEST,UPDATE,PARAMS_UI,PLOT_UI,RENDER,TIMESTEP,PUBLISH,SETTINGS,OBSERVE) \
+    [ID] = {NAME, INIT, DEST, UPDATE, NULL, 0, PARAMS_UI, PLOT_UI, RENDER, TIMESTEP, PUBLISH, OBSERVE},
 static simulation_desc_t g_simulations[SIM_COUNT] = {
     X_SIMULATIONS
 }; 
@@ -31,12 +47,449 @@ static simulation_desc_t g_simulations[SIM_COUNT] = {
 
 static int g_sim_count = SIM_COUNT;
 
+static double g_switch_ms = 0.0;       // Destroy + init time of the last switch
+
+/* Scheduler state (see simulations.h) */
+static const char* g_schedule_names[SIM_SCHEDULE_COUNT] = { "Real time", "Steps per frame", "Max speed" };
+typedef struct sim_schedule_t {
+    int mode;
+    float time_warp;                   // Real time: simulated seconds per wall second
+    int steps_per_frame;
+    float budget_ms;                   // Stepping time allowed per batch
+} sim_schedule_t;
+static sim_schedule_t g_schedule_ui = { SIM_SCHEDULE_REAL_TIME, 1.0f, 1, 12.0f }; // Edited by the UI and posted
+static struct {
+    sim_schedule_t cfg;                // Owned by the stepping thread from here on
+    double accumulator;                // Real time: simulated seconds not stepped yet
+    // Stats of the last batch, and smoothed rates over the batches between
+    // two snapshots
+    int batch_steps;
+    double batch_ms;
+    int behind;                        // Real time: the budget dropped steps
+    int pending_steps;
+    double pending_seconds;
+    double steps_per_sec;
+    double sim_seconds_per_sec;
+} g_scheduler = { .cfg = { SIM_SCHEDULE_REAL_TIME, 1.0f, 1, 12.0f } };
+
+/* Snapshot triple buffer: the producer fills g_snapshots[back] and swaps it
+   into the middle slot marked fresh; the main thread swaps a fresh middle
+   slot with its front one. Each side only ever touches its own slot. */
+#define SNAPSHOT_INDEX 3
+#define SNAPSHOT_FRESH 4
+static sim_snapshot_t g_snapshots[3];
+static int g_snapshot_back = 0;        // Producer only
+static int g_snapshot_front = 1;       // Main thread only
+static atomic_int g_snapshot_middle = 2;
+static uint64_t g_publish_count = 0;   // Producer only
+
+/* Message queue: single-producer single-consumer ring from the main thread
+   to the simulation thread */
+#define SIM_MESSAGE_QUEUE 64
+typedef struct sim_message_t {
+    sim_message_fn fn;
+    _Alignas(16) unsigned char payload[SIM_MESSAGE_PAYLOAD];
+} sim_message_t;
+static sim_message_t g_messages[SIM_MESSAGE_QUEUE];
+static atomic_uint g_message_head;     // Next slot to fill, written by the main thread
+static atomic_uint g_message_tail;     // Next slot to run, written by the simulation thread
+
+typedef struct sim_set_message_t {
+    void* target;
+    union { int i; float f; bool b; } value;
+} sim_set_message_t;
+
+/* Simulation thread */
+static struct {
+    bool enabled;                      // UI option
+    bool running;
+    const simulation_desc_t* sim;      // What it steps
+#if SIM_THREAD_AVAILABLE
+    pthread_t thread;
+#endif
+    atomic_int quit;
+    atomic_uint frames;                // Display frames, for steps per frame
+} g_thread;
+
+/* Slider values of parameter variables while the simulation thread owns them */
+#define SIM_PARAM_SHADOWS 64
+static struct {
+    void* target;
+    union { float f; int i; bool b; } value;
+} g_param_shadows[SIM_PARAM_SHADOWS];
+static int g_param_shadow_count = 0;
+
+// UI copies of the worker count and seed, posted on edit
+static int g_workers_ui = 1;
+static uint64_t g_seed_ui = 0;
+
 void simulations_init_registry(void) {
-    // If additional initialization is needed when the registry starts up, do it here.
+    // Every setting by name (the sliders draw their own subsets)
+    #define X(ID,NAME,INIT,DEST,UPDATE,PARAMS_UI,PLOT_UI,RENDER,TIMESTEP,PUBLISH,SETTINGS,OBSERVE) \
+        g_simulations[ID].params = SETTINGS(&g_simulations[ID].param_count);
+    X_SIMULATIONS
+    #undef X
+
+    // Persistent worker pool shared by the multithreaded kernels
+    sim_workers_init(sim_workers_hardware_count());
+    g_workers_ui = sim_workers_count();
+    g_seed_ui = sim_rng_seed();
 }
 
 void simulations_shutdown_registry(void) {
-    // If needed, clean up globally allocated resources here.
+    simulations_stop_thread();
+    sim_workers_shutdown();
+    sim_gpu_cache_shutdown();
+    for (int i = 0; i < 3; i++) {
+        free(g_snapshots[i].pixels);
+        g_snapshots[i] = (sim_snapshot_t){0};
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Snapshots
+// -----------------------------------------------------------------------------
+unsigned char *sim_snapshot_pixels(sim_snapshot_t *snap, int width, int height) {
+    size_t size = (size_t)width * height;
+    if (size > snap->pixel_capacity) {
+        free(snap->pixels);
+        snap->pixels = (unsigned char*)malloc(size);
+        snap->pixel_capacity = size;
+    }
+    snap->width = width;
+    snap->height = height;
+    return snap->pixels;
+}
+
+// Forget the previous simulation's snapshots; only while nothing is stepping
+static void snapshots_reset(void) {
+    for (int i = 0; i < 3; i++) {
+        g_snapshots[i].sequence = 0;
+    }
+    g_snapshot_back = 0;
+    g_snapshot_front = 1;
+    atomic_store(&g_snapshot_middle, 2);
+    g_publish_count = 0;
+}
+
+// Producer side: fill the back buffer and swap it into the middle
+static void snapshot_publish(const simulation_desc_t* sim) {
+    sim_snapshot_t* snap = &g_snapshots[g_snapshot_back];
+    snap->sequence = ++g_publish_count;
+    if (g_scheduler.pending_seconds > 0.0) {
+        double rate = g_scheduler.pending_steps / g_scheduler.pending_seconds;
+        g_scheduler.steps_per_sec = (g_scheduler.steps_per_sec > 0.0) ? 0.9 * g_scheduler.steps_per_sec + 0.1 * rate : rate;
+        g_scheduler.sim_seconds_per_sec = g_scheduler.steps_per_sec * sim->timestep;
+        g_scheduler.pending_steps = 0;
+        g_scheduler.pending_seconds = 0.0;
+    }
+    snap->batch_steps = g_scheduler.batch_steps;
+    snap->batch_ms = g_scheduler.batch_ms;
+    snap->behind = g_scheduler.behind;
+    snap->steps_per_sec = g_scheduler.steps_per_sec;
+    snap->sim_seconds_per_sec = g_scheduler.sim_seconds_per_sec;
+    if (sim->publish) sim->publish(snap);
+    int prev = atomic_exchange_explicit(&g_snapshot_middle, g_snapshot_back | SNAPSHOT_FRESH, memory_order_acq_rel);
+    g_snapshot_back = prev & SNAPSHOT_INDEX;
+}
+
+// Main thread side: take the middle buffer if something newer was published
+static void snapshot_acquire(void) {
+    if (atomic_load_explicit(&g_snapshot_middle, memory_order_relaxed) & SNAPSHOT_FRESH) {
+        int prev = atomic_exchange_explicit(&g_snapshot_middle, g_snapshot_front, memory_order_acq_rel);
+        g_snapshot_front = prev & SNAPSHOT_INDEX;
+    }
+}
+
+const sim_snapshot_t *simulations_snapshot(void) {
+    const sim_snapshot_t* snap = &g_snapshots[g_snapshot_front];
+    return snap->sequence ? snap : NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Messages
+// -----------------------------------------------------------------------------
+// Run everything queued so far; simulation thread only
+static int messages_drain(void) {
+    unsigned tail = atomic_load_explicit(&g_message_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&g_message_head, memory_order_acquire);
+    int count = 0;
+    while (tail != head) {
+        sim_message_t* msg = &g_messages[tail % SIM_MESSAGE_QUEUE];
+        msg->fn(msg->payload);
+        atomic_store_explicit(&g_message_tail, ++tail, memory_order_release);
+        count++;
+    }
+    return count;
+}
+
+#if SIM_THREAD_AVAILABLE
+static void sim_thread_sleep(double seconds) {
+    struct timespec ts = { (time_t)seconds, (long)(fmod(seconds, 1.0) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+#endif
+
+void simulations_post(sim_message_fn fn, const void* payload, size_t size) {
+    assert(size <= SIM_MESSAGE_PAYLOAD);
+    if (!g_thread.running) {
+        fn(payload);
+        return;
+    }
+#if SIM_THREAD_AVAILABLE
+    unsigned head = atomic_load_explicit(&g_message_head, memory_order_relaxed);
+    // Full: the simulation thread is inside a long step, wait for a slot
+    while (head - atomic_load_explicit(&g_message_tail, memory_order_acquire) >= SIM_MESSAGE_QUEUE) {
+        sim_thread_sleep(0.0001);
+    }
+    sim_message_t* msg = &g_messages[head % SIM_MESSAGE_QUEUE];
+    msg->fn = fn;
+    if (size > 0) memcpy(msg->payload, payload, size);
+    atomic_store_explicit(&g_message_head, head + 1, memory_order_release);
+#endif
+}
+
+static void set_int_message(const void* payload) {
+    const sim_set_message_t* msg = (const sim_set_message_t*)payload;
+    *(int*)msg->target = msg->value.i;
+}
+
+static void set_float_message(const void* payload) {
+    const sim_set_message_t* msg = (const sim_set_message_t*)payload;
+    *(float*)msg->target = msg->value.f;
+}
+
+static void set_bool_message(const void* payload) {
+    const sim_set_message_t* msg = (const sim_set_message_t*)payload;
+    *(bool*)msg->target = msg->value.b;
+}
+
+void simulations_set_int(int* target, int value) {
+    sim_set_message_t msg = { target, { .i = value } };
+    simulations_post(set_int_message, &msg, sizeof(msg));
+}
+
+void simulations_set_float(float* target, float value) {
+    sim_set_message_t msg = { target, { .f = value } };
+    simulations_post(set_float_message, &msg, sizeof(msg));
+}
+
+void simulations_set_bool(bool* target, bool value) {
+    sim_set_message_t msg = { target, { .b = value } };
+    simulations_post(set_bool_message, &msg, sizeof(msg));
+}
+
+// -----------------------------------------------------------------------------
+// Scheduler
+// -----------------------------------------------------------------------------
+// One batch of steps: wall_dt seconds of wall time (real time) or `frames`
+// display frames (steps per frame) worth, within the step budget
+static int scheduler_run(const simulation_desc_t* sim, double wall_dt, int frames) {
+    const sim_schedule_t* cfg = &g_scheduler.cfg;
+    const double timestep = sim->timestep;
+    int due;                           // Steps wanted this batch, -1 for unbounded
+    switch (cfg->mode) {
+        case SIM_SCHEDULE_STEPS_PER_FRAME:
+            due = cfg->steps_per_frame * frames;
+            break;
+        case SIM_SCHEDULE_MAX_SPEED:
+            due = -1;
+            break;
+        default:
+            g_scheduler.accumulator += wall_dt * cfg->time_warp;
+            due = (int)(g_scheduler.accumulator / timestep);
+            break;
+    }
+
+    uint64_t start = stm_now();
+    int steps = 0;
+    double ms = 0.0;
+    while (due < 0 || steps < due) {
+        sim->update((float)timestep);
+        steps++;
+        ms = stm_ms(stm_since(start));
+        if (ms >= cfg->budget_ms) break;
+    }
+
+    g_scheduler.behind = 0;
+    if (cfg->mode == SIM_SCHEDULE_REAL_TIME) {
+        g_scheduler.accumulator -= steps * timestep;
+        if (g_scheduler.accumulator >= timestep) {
+            // Over budget: drop the backlog rather than try to catch up
+            g_scheduler.behind = 1;
+            g_scheduler.accumulator = fmod(g_scheduler.accumulator, timestep);
+        }
+    }
+    g_scheduler.batch_steps = steps;
+    g_scheduler.batch_ms = ms;
+    g_scheduler.pending_steps += steps;
+    g_scheduler.pending_seconds += wall_dt;
+    return steps;
+}
+
+static void scheduler_apply_message(const void* payload) {
+    const sim_schedule_t* cfg = (const sim_schedule_t*)payload;
+    if (cfg->mode != g_scheduler.cfg.mode) {
+        g_scheduler.accumulator = 0.0;
+    }
+    g_scheduler.cfg = *cfg;
+}
+
+// -----------------------------------------------------------------------------
+// Simulation thread
+// -----------------------------------------------------------------------------
+#if SIM_THREAD_AVAILABLE
+// Wall time until the next step is due, short enough that messages and the
+// quit flag are never kept waiting long
+static double scheduler_idle_seconds(const simulation_desc_t* sim) {
+    double idle = 0.001;
+    if (g_scheduler.cfg.mode == SIM_SCHEDULE_REAL_TIME && g_scheduler.cfg.time_warp > 0.0f) {
+        idle = (sim->timestep - g_scheduler.accumulator) / g_scheduler.cfg.time_warp;
+    }
+    return fmin(fmax(idle, 0.0), 0.004);
+}
+
+static void* sim_thread_main(void* arg) {
+    const simulation_desc_t* sim = (const simulation_desc_t*)arg;
+    uint64_t last = stm_now();
+    unsigned frames_seen = atomic_load(&g_thread.frames);
+    while (!atomic_load(&g_thread.quit)) {
+        int applied = messages_drain();
+        unsigned frames = atomic_load(&g_thread.frames);
+        int steps = scheduler_run(sim, stm_sec(stm_laptime(&last)), (int)(frames - frames_seen));
+        frames_seen = frames;
+        if (steps > 0 || applied > 0) {
+            snapshot_publish(sim);
+        }
+        if (steps == 0) {
+            sim_thread_sleep(scheduler_idle_seconds(sim));
+        }
+    }
+    return NULL;
+}
+#endif
+
+static void sim_thread_start(const simulation_desc_t* sim) {
+#if SIM_THREAD_AVAILABLE
+    g_param_shadow_count = 0;
+    atomic_store(&g_thread.quit, 0);
+    g_thread.sim = sim;
+    g_thread.running = pthread_create(&g_thread.thread, NULL, sim_thread_main, (void*)sim) == 0;
+    if (!g_thread.running) {
+        g_thread.enabled = false;
+    }
+#else
+    (void)sim;
+#endif
+}
+
+void simulations_stop_thread(void) {
+#if SIM_THREAD_AVAILABLE
+    if (!g_thread.running) return;
+    atomic_store(&g_thread.quit, 1);
+    pthread_join(g_thread.thread, NULL);
+    g_thread.running = false;
+    g_thread.sim = NULL;
+    // Edits still queued belong to the simulation; the sliders read the
+    // variables directly again
+    messages_drain();
+    g_param_shadow_count = 0;
+#endif
+}
+
+void simulations_draw_thread_ui(const simulation_desc_t* sim) {
+#if SIM_THREAD_AVAILABLE
+    igCheckbox("Simulation Thread", &g_thread.enabled);
+    if (g_thread.enabled && sim && !sim->publish) {
+        igTextWrapped("%s steps on the main thread", sim->name);
+    }
+#else
+    (void)sim;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Registry
+// -----------------------------------------------------------------------------
+const simulation_desc_t* simulations_switch(const simulation_desc_t* from, simulation_id_t to) {
+    simulations_stop_thread();
+    uint64_t start = stm_now();
+    if (from && from->destroy) from->destroy();
+    const simulation_desc_t* sim = simulations_get(to);
+    if (sim && sim->init) sim->init();
+    g_switch_ms = stm_ms(stm_since(start));
+    snapshots_reset();
+    g_scheduler.accumulator = 0.0;
+    g_scheduler.pending_steps = 0;
+    g_scheduler.pending_seconds = 0.0;
+    g_scheduler.steps_per_sec = 0.0;
+    g_scheduler.sim_seconds_per_sec = 0.0;
+    return sim;
+}
+
+void simulations_run_frame(const simulation_desc_t* sim, float frame_dt) {
+    atomic_fetch_add(&g_thread.frames, 1);
+
+    // Start or stop the thread to follow the option and the current simulation
+    bool threaded = g_thread.enabled && sim && sim->publish;
+    if (g_thread.running && (!threaded || g_thread.sim != sim)) {
+        simulations_stop_thread();
+    }
+    if (threaded && !g_thread.running) {
+        sim_thread_start(sim);
+    }
+
+    if (!g_thread.running && sim && sim->update) {
+        scheduler_run(sim, frame_dt, 1);
+        snapshot_publish(sim);
+    }
+    snapshot_acquire();
+}
+
+void simulations_draw_scheduler_ui(void) {
+    bool changed = igCombo_Str_arr("Schedule", &g_schedule_ui.mode, g_schedule_names, SIM_SCHEDULE_COUNT, -1);
+    if (g_schedule_ui.mode == SIM_SCHEDULE_REAL_TIME) {
+        changed |= igSliderFloat("Time Warp", &g_schedule_ui.time_warp, 0.1f, 100.0f, "%.2fx", ImGuiSliderFlags_Logarithmic);
+    } else if (g_schedule_ui.mode == SIM_SCHEDULE_STEPS_PER_FRAME) {
+        changed |= igSliderInt("Steps per Frame", &g_schedule_ui.steps_per_frame, 1, 1000, "%d", ImGuiSliderFlags_Logarithmic);
+    }
+    changed |= igSliderFloat("Step Budget (ms)", &g_schedule_ui.budget_ms, 1.0f, 100.0f, "%.1f", ImGuiSliderFlags_None);
+    if (changed) {
+        simulations_post(scheduler_apply_message, &g_schedule_ui, sizeof(g_schedule_ui));
+    }
+    const sim_snapshot_t* snap = simulations_snapshot();
+    if (snap) {
+        igText("Steps: %d last batch (%.2f ms), %.0f/s, %.2fx real time%s", snap->batch_steps, snap->batch_ms,
+               snap->steps_per_sec, snap->sim_seconds_per_sec, snap->behind ? ", behind" : "");
+    }
+}
+
+void simulations_draw_switch_ui(void) {
+    sim_gpu_cache_stats_t stats;
+    sim_gpu_cache_stats(&stats);
+    igText("Last switch: %.2f ms", g_switch_ms);
+    igText("GPU cache: %d objects, %llu hits, %llu misses", stats.objects,
+           (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+}
+
+static void workers_set_message(const void* payload) {
+    sim_workers_set_count(*(const int*)payload);
+}
+
+void simulations_draw_workers_ui(void) {
+    if (igSliderInt("Worker Threads", &g_workers_ui, 1, sim_workers_hardware_count(), "%d", ImGuiSliderFlags_None)) {
+        simulations_post(workers_set_message, &g_workers_ui, sizeof(g_workers_ui));
+    }
+}
+
+static void seed_set_message(const void* payload) {
+    sim_rng_set_seed(*(const uint64_t*)payload);
+}
+
+void simulations_draw_seed_ui(void) {
+    if (igInputScalar("Seed", ImGuiDataType_U64, &g_seed_ui, NULL, NULL, NULL, ImGuiInputTextFlags_None)) {
+        simulations_post(seed_set_message, &g_seed_ui, sizeof(g_seed_ui));
+    }
 }
 
 const simulation_desc_t* simulations_get(simulation_id_t id) {
@@ -47,18 +500,151 @@ const simulation_desc_t* simulations_get(simulation_id_t id) {
     return NULL;
 }
 
-void simulations_draw_params(sim_parameter_t* params, int16_t count) {
+// What a slider edits: the variable itself when this thread owns it, else a
+// copy seeded from the variable the first time it is drawn
+static void* param_ui_value(sim_parameter_t* p) {
+    if (!g_thread.running) {
+        return p->value_ptr;
+    }
+    for (int i = 0; i < g_param_shadow_count; i++) {
+        if (g_param_shadows[i].target == p->value_ptr) {
+            return &g_param_shadows[i].value;
+        }
+    }
+    assert(g_param_shadow_count < SIM_PARAM_SHADOWS);
+    int slot = g_param_shadow_count++;
+    g_param_shadows[slot].target = p->value_ptr;
+    size_t size = p->type == SIM_PARAM_FLOAT ? sizeof(float) : p->type == SIM_PARAM_INT ? sizeof(int) : sizeof(bool);
+    memcpy(&g_param_shadows[slot].value, p->value_ptr, size);
+    return &g_param_shadows[slot].value;
+}
+
+bool simulations_draw_params(sim_parameter_t* params, int16_t count) {
+    bool changed = false;
     for (int16_t i = 0; i < count; i++) {
         sim_parameter_t* p = &params[i];
+        void* value = param_ui_value(p);
         switch (p->type) {
             case SIM_PARAM_FLOAT:
-                igSliderFloat(p->name, (float*)p->value_ptr, p->f_min, p->f_max, "%.3f", ImGuiSliderFlags_None);
+                if (igSliderFloat(p->name, (float*)value, p->f_min, p->f_max, "%.3f", ImGuiSliderFlags_None)) {
+                    simulations_set_float((float*)p->value_ptr, *(float*)value);
+                    changed = true;
+                }
                 break;
             case SIM_PARAM_INT:
-                igSliderInt(p->name, (int*)p->value_ptr, p->i_min, p->i_max, "%d", ImGuiSliderFlags_None);
+                if (igSliderInt(p->name, (int*)value, p->i_min, p->i_max, "%d", ImGuiSliderFlags_None)) {
+                    simulations_set_int((int*)p->value_ptr, *(int*)value);
+                    changed = true;
+                }
+                break;
+            case SIM_PARAM_BOOL:
+                if (igCheckbox(p->name, (bool*)value)) {
+                    simulations_set_bool((bool*)p->value_ptr, *(bool*)value);
+                    changed = true;
+                }
                 break;
         }
     }
+    return changed;
 }
 
+// -----------------------------------------------------------------------------
+// Time series
+// -----------------------------------------------------------------------------
+// Plotting; the rest of the series lives in series.c so headless builds
+// keep it. Scratch is shared since the UI draws one plot line at a time.
+#define SIM_SERIES_CANDIDATES (2 * SIM_SERIES_BUCKETS + SIM_SERIES_RECENT)
+static double series_cand_x[SIM_SERIES_CANDIDATES];
+static double series_cand_y[SIM_SERIES_CANDIDATES];
+static double series_plot_x[SIM_SERIES_PLOT_POINTS];
+static double series_plot_y[SIM_SERIES_PLOT_POINTS];
 
+// Largest triangle three buckets: keep the end points and, per bucket, the
+// point spanning the largest triangle with the previous pick and the mean of
+// the next bucket
+static int series_lttb(const double *x, const double *y, int n,
+                       double *out_x, double *out_y, int out_count) {
+    double every = (double)(n - 2) / (double)(out_count - 2);
+    int a = 0;
+    int k = 0;
+    out_x[k] = x[0];
+    out_y[k++] = y[0];
+    for (int i = 0; i < out_count - 2; i++) {
+        int avg_start = (int)((i + 1) * every) + 1;
+        int avg_end = (int)((i + 2) * every) + 1;
+        if (avg_end > n) avg_end = n;
+        if (avg_start >= avg_end) avg_start = avg_end - 1;
+        double avg_x = 0.0, avg_y = 0.0;
+        for (int j = avg_start; j < avg_end; j++) {
+            avg_x += x[j];
+            avg_y += y[j];
+        }
+        avg_x /= (double)(avg_end - avg_start);
+        avg_y /= (double)(avg_end - avg_start);
+
+        int start = (int)(i * every) + 1;
+        int end = (int)((i + 1) * every) + 1;
+        int best = start;
+        double best_area = -1.0;
+        for (int j = start; j < end; j++) {
+            double area = fabs((x[a] - avg_x) * (y[j] - y[a]) - (x[a] - x[j]) * (avg_y - y[a]));
+            if (area > best_area) {
+                best_area = area;
+                best = j;
+            }
+        }
+        out_x[k] = x[best];
+        out_y[k++] = y[best];
+        a = best;
+    }
+    out_x[k] = x[n - 1];
+    out_y[k++] = y[n - 1];
+    return k;
+}
+
+void sim_series_plot_line(const sim_series_t *series, int channel, const char *label) {
+    if (series->total == 0 || channel < 0 || channel >= series->channel_count) {
+        return;
+    }
+
+    // History older than the ring: each bucket's min and max in time order.
+    // The bucket straddling the ring start only contributes the extremes that
+    // fall before it, the ring has the rest at full resolution.
+    uint64_t ring_start = series->total - (uint64_t)series->recent_count;
+    int ring_first = (series->head + SIM_SERIES_RECENT - series->recent_count) % SIM_SERIES_RECENT;
+    double ring_x = series->x[ring_first];
+    int n = 0;
+    for (int i = 0; i < series->bucket_count; i++) {
+        const sim_series_bucket_t *bucket = &series->buckets[i];
+        if (bucket->first >= ring_start) {
+            break;
+        }
+        int min_first = bucket->x_min[channel] <= bucket->x_max[channel];
+        double xa = min_first ? bucket->x_min[channel] : bucket->x_max[channel];
+        double xb = min_first ? bucket->x_max[channel] : bucket->x_min[channel];
+        if (xa < ring_x) {
+            series_cand_x[n] = xa;
+            series_cand_y[n++] = min_first ? bucket->min[channel] : bucket->max[channel];
+        }
+        if (xb < ring_x && xb != xa) {
+            series_cand_x[n] = xb;
+            series_cand_y[n++] = min_first ? bucket->max[channel] : bucket->min[channel];
+        }
+    }
+
+    // Then the whole ring, oldest first
+    for (int k = 0; k < series->recent_count; k++) {
+        int slot = (ring_first + k) % SIM_SERIES_RECENT;
+        series_cand_x[n] = series->x[slot];
+        series_cand_y[n++] = series->y[channel][slot];
+    }
+
+    const double *xs = series_cand_x;
+    const double *ys = series_cand_y;
+    if (n > SIM_SERIES_PLOT_POINTS) {
+        n = series_lttb(series_cand_x, series_cand_y, n, series_plot_x, series_plot_y, SIM_SERIES_PLOT_POINTS);
+        xs = series_plot_x;
+        ys = series_plot_y;
+    }
+    ImPlot_PlotLine_doublePtrdoublePtr(label, xs, ys, n, 0, 0, sizeof(double));
+}
@@ -2,9 +2,11 @@
 #define SIMULATIONS_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 /* 
 Format of each line:
-X(ID, DisplayName, Init, Destroy, Update, ParamUI, PlotUI, Render)
+X(ID, DisplayName, Init, Destroy, Update, ParamUI, PlotUI, Render, Timestep, Publish, Settings, Observe)
 
 - ID: Enum ID for this simulation
 - DisplayName: A string shown in the combo box
@@ -14,24 +16,36 @@ X(ID, DisplayName, Init, Destroy, Update, ParamUI, PlotUI, Render)
 - ParamUI: void func() creates sliders/params in IMGUI for this sim
 - PlotUI: void func() plots simulation-specific data using ImPlot
 - Render: what to display
+- Timestep: simulated seconds per update; the scheduler calls Update with it
+- Publish: void func(sim_snapshot_t*) copies what PlotUI and Render show
+  into a snapshot, or NULL; only simulations with one can step on the
+  simulation thread (see below)
+- Settings: sim_parameter_t* func(int16_t* count) lists every setting by
+  name, choices and toggles included; values set before Init take effect
+- Observe: int func(sim_observable_t* out) fills up to SIM_MAX_OBSERVABLES
+  named values describing the current state, returns how many
+
+Init, Destroy, Update, Timestep, Settings and Observe are the runtime half
+of a simulation. Built with SIM_HEADLESS the UI half is compiled out, so the
+batch runner (batch.c) links the kernels without ImGui, ImPlot or sokol_gfx.
 */
 #define X_SIMULATIONS \
-    X(SIM_NONE,      "None",      sim_none_init,      sim_none_destroy,      sim_none_update,      sim_none_params_ui,      sim_none_plot_ui,      sim_none_render) \
-    X(SIM_PENDULUM,  "Pendulum",  sim_pendulum_init,  sim_pendulum_destroy,  sim_pendulum_update,  sim_pendulum_params_ui,  sim_pendulum_plot_ui,  sim_pendulum_render) \
-    X(SIM_MCPI,  "Monte Carlo Pi",  sim_mcpi_init,  sim_mcpi_destroy,  sim_mcpi_update,  sim_mcpi_params_ui,  sim_mcpi_plot_ui,  sim_mcpi_render) \
-    X(SIM_GOL,  "Game of Life",  sim_gol_init,  sim_gol_destroy,  sim_gol_update,  sim_gol_params_ui,  sim_gol_plot_ui,  sim_gol_render) \
-    X(SIM_ISING,  "Ising Model",  sim_ising_init,  sim_ising_destroy,  sim_ising_update,  sim_ising_params_ui,  sim_ising_plot_ui,  sim_ising_render) 
+    X(SIM_NONE,      "None",      sim_none_init,      sim_none_destroy,      sim_none_update,      sim_none_params_ui,      sim_none_plot_ui,      sim_none_render,      1.0f / 60.0f,  NULL,  sim_none_settings,  sim_none_observe) \
+    X(SIM_PENDULUM,  "Pendulum",  sim_pendulum_init,  sim_pendulum_destroy,  sim_pendulum_update,  sim_pendulum_params_ui,  sim_pendulum_plot_ui,  sim_pendulum_render,  1.0f / 120.0f,  NULL,  sim_pendulum_settings,  sim_pendulum_observe) \
+    X(SIM_MCPI,  "Monte Carlo Pi",  sim_mcpi_init,  sim_mcpi_destroy,  sim_mcpi_update,  sim_mcpi_params_ui,  sim_mcpi_plot_ui,  sim_mcpi_render,  1.0f / 60.0f,  NULL,  sim_mcpi_settings,  sim_mcpi_observe) \
+    X(SIM_GOL,  "Game of Life",  sim_gol_init,  sim_gol_destroy,  sim_gol_update,  sim_gol_params_ui,  sim_gol_plot_ui,  sim_gol_render,  1.0f / 60.0f,  sim_gol_publish,  sim_gol_settings,  sim_gol_observe) \
+    X(SIM_ISING,  "Ising Model",  sim_ising_init,  sim_ising_destroy,  sim_ising_update,  sim_ising_params_ui,  sim_ising_plot_ui,  sim_ising_render,  1.0f / 60.0f,  sim_ising_publish,  sim_ising_settings,  sim_ising_observe)
 
 
 /* Generate enum */
 typedef enum {
-    #define X(ID,NAME,INIT,DEST,UPDATE,PARAMS_UI,PLOT_UI,RENDER) ID,
+    #define X(ID,NAME,INIT,DEST,UPDATE,PARAMS_UI,PLOT_UI,RENDER,TIMESTEP,PUBLISH,SETTINGS,OBSERVE) ID,
     X_SIMULATIONS
     #undef X
     SIM_COUNT
 } simulation_id_t;
 
-typedef enum { SIM_PARAM_FLOAT, SIM_PARAM_INT } sim_param_type_t;
+typedef enum { SIM_PARAM_FLOAT, SIM_PARAM_INT, SIM_PARAM_BOOL } sim_param_type_t;
 
 typedef struct sim_parameter_t {
     const char* name;
@@ -43,6 +57,15 @@ typedef struct sim_parameter_t {
     int         i_max;
 } sim_parameter_t;
 
+#define SIM_MAX_OBSERVABLES 8
+
+typedef struct sim_observable_t {
+    const char* name;
+    double      value;
+} sim_observable_t;
+
+typedef struct sim_snapshot_t sim_snapshot_t;
+
 typedef struct simulation_desc_t {
     const char* name;
     void (*init)(void);
@@ -53,13 +76,187 @@ typedef struct simulation_desc_t {
     void (*params_ui)(void);
     void (*plot_ui)(void);
     void (*render)(void);
+    float timestep;
+    void (*publish)(sim_snapshot_t *snap);
+    int (*observe)(sim_observable_t *out);
 } simulation_desc_t;
 
+// -----------------------------------------------------------------------------
+// Runtime half of the registry: what headless tools (batch.c, bench.c) need,
+// built with or without SIM_HEADLESS
+// -----------------------------------------------------------------------------
+typedef struct sim_runtime_t {
+    const char* id;                    // Enum name, e.g. "SIM_GOL"
+    const char* name;
+    void (*init)(void);
+    void (*destroy)(void);
+    void (*update)(float dt);
+    float timestep;
+    sim_parameter_t* (*settings)(int16_t* count);
+    int (*observe)(sim_observable_t* out);
+} sim_runtime_t;
+
+const sim_runtime_t* sim_runtime_get(simulation_id_t id);
+// By display name or enum name, ignoring case; NULL when there is none
+const sim_runtime_t* sim_runtime_find(const char* name);
+// Set one of the simulation's settings from "Name=value" text (bools take
+// true/false, on/off or 1/0), range checked; returns false and describes
+// the problem in `error` otherwise
+bool sim_runtime_set(const sim_runtime_t* sim, const char* assignment, char* error, size_t error_size);
+// Value of the observable called `name`, or `fallback` when there is none
+double sim_observable_find(const sim_observable_t* obs, int count, const char* name, double fallback);
+
 void simulations_init_registry(void);
 void simulations_shutdown_registry(void);
 const simulation_desc_t* simulations_get(simulation_id_t id);
 
-void simulations_draw_params(sim_parameter_t* params, int16_t count);
+// Destroy `from` (may be NULL) and init `to`, timing both; returns `to`.
+// GPU objects come from the shared cache (gpu_cache.h), so switching back
+// to a simulation reuses what it compiled before.
+const simulation_desc_t* simulations_switch(const simulation_desc_t* from, simulation_id_t to);
+void simulations_draw_switch_ui(void);
+
+// -----------------------------------------------------------------------------
+// Scheduler: decouples simulation steps from rendered frames
+//
+// Every simulation steps at its own fixed timestep. Each frame the
+// scheduler decides how many update() calls to make:
+// - Real time: frame time times the time-warp factor goes into an
+//   accumulator and is spent in whole timesteps.
+// - Steps per frame: a fixed number of steps every frame.
+// - Max speed: steps until the frame budget is spent, rendering only at
+//   display rate.
+// In every mode stepping stops once the frame budget is spent (at least one
+// step is always taken when one is due). Real time then drops the backlog, so
+// the simulation falls behind instead of stalling the UI. On the simulation
+// thread the same rules apply per batch of steps between two snapshots.
+// -----------------------------------------------------------------------------
+typedef enum {
+    SIM_SCHEDULE_REAL_TIME,
+    SIM_SCHEDULE_STEPS_PER_FRAME,
+    SIM_SCHEDULE_MAX_SPEED,
+    SIM_SCHEDULE_COUNT
+} sim_schedule_mode_t;
+
+// Run this frame's steps of `sim`, or hand them to the simulation thread,
+// and pick up the newest snapshot; frame_dt is the wall-clock frame time
+void simulations_run_frame(const simulation_desc_t* sim, float frame_dt);
+void simulations_draw_scheduler_ui(void);
+
+// Sliders for a parameter array; returns true when one was edited
+bool simulations_draw_params(sim_parameter_t* params, int16_t count);
+void simulations_draw_workers_ui(void);
+// Global random seed (see rng.h); simulations pick it up on reset
+void simulations_draw_seed_ui(void);
+
+// -----------------------------------------------------------------------------
+// Time series for the plot panels
+//
+// Memory is constant however long a run gets. The newest samples are kept at
+// full resolution in a ring buffer; every sample also lands in a fixed set of
+// min/max buckets covering the whole run, and when those fill up adjacent
+// pairs are merged so each bucket spans twice as many samples. Plotting
+// stitches the buckets in front of the ring and reduces the result with LTTB
+// (largest triangle three buckets), so ImPlot gets at most
+// SIM_SERIES_PLOT_POINTS points per channel per frame.
+// -----------------------------------------------------------------------------
+#define SIM_SERIES_MAX_CHANNELS 4
+#define SIM_SERIES_RECENT 2048         // Newest samples at full resolution
+#define SIM_SERIES_BUCKETS 1024        // Min/max buckets over the whole run
+#define SIM_SERIES_PLOT_POINTS 1000    // Points per channel handed to ImPlot
+
+typedef struct sim_series_bucket_t {
+    uint64_t first;                    // Index of the first sample in the bucket
+    uint64_t count;
+    double x_min[SIM_SERIES_MAX_CHANNELS];   // Where each channel hit its min / max
+    double x_max[SIM_SERIES_MAX_CHANNELS];
+    float min[SIM_SERIES_MAX_CHANNELS];
+    float max[SIM_SERIES_MAX_CHANNELS];
+} sim_series_bucket_t;
+
+typedef struct sim_series_t {
+    int channel_count;
+    uint64_t total;                    // Samples pushed since the last clear
+    double x_first;
+    double x[SIM_SERIES_RECENT];
+    float y[SIM_SERIES_MAX_CHANNELS][SIM_SERIES_RECENT];
+    int head;                          // Ring slot of the next sample
+    int recent_count;
+    sim_series_bucket_t buckets[SIM_SERIES_BUCKETS];
+    int bucket_count;
+    uint64_t bucket_span;              // Samples per full bucket, doubles on merge
+} sim_series_t;
+
+void sim_series_init(sim_series_t *series, int channel_count);
+void sim_series_clear(sim_series_t *series);
+// values holds one float per channel
+void sim_series_push(sim_series_t *series, double x, const float *values);
+// Most recent value of a channel, 0 when empty
+float sim_series_last(const sim_series_t *series, int channel);
+// x of the oldest and newest sample; returns 0 when fewer than two samples
+int sim_series_x_range(const sim_series_t *series, double *x_min, double *x_max);
+// Downsampled line for one channel; call between ImPlot_BeginPlot/EndPlot
+void sim_series_plot_line(const sim_series_t *series, int channel, const char *label);
+
+// -----------------------------------------------------------------------------
+// Simulation thread
+//
+// Optionally, simulations with a Publish callback step on a dedicated thread,
+// so a slow update no longer blocks ImGui input and rendering. After every
+// batch of steps the stepping thread publishes an immutable snapshot of what
+// the UI shows (R8 pixels, the plot series and simulation-defined stats)
+// through a lock-free triple buffer: the producer always has a buffer to
+// fill, the main thread always has the newest complete one, and neither
+// waits. plot_ui and render read only simulations_snapshot(), never the live
+// state. Changes travel the other way through a single-producer queue of
+// messages that the simulation thread applies between steps;
+// simulations_draw_params() posts every edit there. Without the thread
+// (or for simulations without Publish) steps, messages and publishing all
+// run inline on the main thread, one snapshot per frame.
+//
+// Simulation state and parameter variables belong to the stepping thread.
+// UI code keeps its own copy of anything it edits and posts the change;
+// parameter sliders get theirs from the registry.
+// -----------------------------------------------------------------------------
+#define SIM_SNAPSHOT_STATS 16384       // Bytes of simulation-defined stats
+#define SIM_MESSAGE_PAYLOAD 320        // Largest message payload in bytes
+
+struct sim_snapshot_t {
+    uint64_t sequence;                 // Publish count since the last switch
+    // Scheduler stats of the batch before the snapshot
+    int batch_steps;
+    double batch_ms;
+    int behind;
+    double steps_per_sec;
+    double sim_seconds_per_sec;
+    // Filled by the simulation's Publish callback
+    int width, height;                 // R8 pixels, row-major
+    unsigned char *pixels;
+    size_t pixel_capacity;
+    sim_series_t series;
+    _Alignas(16) unsigned char stats[SIM_SNAPSHOT_STATS];
+};
+
+// Pixel buffer of the snapshot, grown to width x height bytes
+unsigned char *sim_snapshot_pixels(sim_snapshot_t *snap, int width, int height);
+
+// Newest snapshot of the current simulation, unchanged until the next
+// simulations_run_frame(); NULL until one has been published
+const sim_snapshot_t *simulations_snapshot(void);
+
+typedef void (*sim_message_fn)(const void *payload);
+// Call fn with a copy of `size` bytes of payload on the thread stepping the
+// simulation: queued for the simulation thread, at once without it
+void simulations_post(sim_message_fn fn, const void *payload, size_t size);
+// Write a parameter variable the same way
+void simulations_set_int(int *target, int value);
+void simulations_set_float(float *target, float value);
+void simulations_set_bool(bool *target, bool value);
+
+// Join the simulation thread, if running, and apply what is still queued;
+// call before destroying the current simulation outside simulations_switch
+void simulations_stop_thread(void);
+void simulations_draw_thread_ui(const simulation_desc_t* sim);
 
 #endif
 
@@ -0,0 +1,152 @@
+#include "workers.h"
+
+#if (defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)) || (defined(_WIN32) && !defined(__MINGW32__))
+    #define SIM_WORKERS_THREADED 0
+#else
+    #define SIM_WORKERS_THREADED 1
+#endif
+
+#if SIM_WORKERS_THREADED
+#include <pthread.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+static struct {
+    int count;                       // Workers including the calling thread
+    pthread_t threads[SIM_WORKERS_MAX];
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned long job;               // Incremented for every sim_workers_run
+    int quit;
+    int busy;                        // Helpers still inside the current job
+
+    sim_task_fn fn;
+    void *ctx;
+    int task_count;
+    atomic_int next_task;
+} workers;
+
+static void workers_drain(int worker) {
+    for (;;) {
+        int task = atomic_fetch_add(&workers.next_task, 1);
+        if (task >= workers.task_count) break;
+        workers.fn(workers.ctx, task, worker);
+    }
+}
+
+static void *workers_main(void *arg) {
+    int worker = (int)(intptr_t)arg;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&workers.lock);
+    for (;;) {
+        while (workers.job == seen && !workers.quit) {
+            pthread_cond_wait(&workers.wake, &workers.lock);
+        }
+        if (workers.quit) break;
+        seen = workers.job;
+        pthread_mutex_unlock(&workers.lock);
+
+        workers_drain(worker);
+
+        pthread_mutex_lock(&workers.lock);
+        if (--workers.busy == 0) {
+            pthread_cond_signal(&workers.done);
+        }
+    }
+    pthread_mutex_unlock(&workers.lock);
+    return NULL;
+}
+
+static void workers_start(int count) {
+    if (count < 1) count = 1;
+    if (count > SIM_WORKERS_MAX) count = SIM_WORKERS_MAX;
+    workers.count = count;
+    workers.quit = 0;
+    workers.job = 0;
+    for (int i = 1; i < count; i++) {
+        pthread_create(&workers.threads[i], NULL, workers_main, (void*)(intptr_t)i);
+    }
+}
+
+static void workers_stop(void) {
+    pthread_mutex_lock(&workers.lock);
+    workers.quit = 1;
+    pthread_cond_broadcast(&workers.wake);
+    pthread_mutex_unlock(&workers.lock);
+    for (int i = 1; i < workers.count; i++) {
+        pthread_join(workers.threads[i], NULL);
+    }
+    workers.count = 1;
+}
+
+void sim_workers_init(int count) {
+    pthread_mutex_init(&workers.lock, NULL);
+    pthread_cond_init(&workers.wake, NULL);
+    pthread_cond_init(&workers.done, NULL);
+    workers_start(count);
+}
+
+void sim_workers_shutdown(void) {
+    workers_stop();
+    pthread_cond_destroy(&workers.done);
+    pthread_cond_destroy(&workers.wake);
+    pthread_mutex_destroy(&workers.lock);
+}
+
+void sim_workers_set_count(int count) {
+    if (count == workers.count) return;
+    workers_stop();
+    workers_start(count);
+}
+
+int sim_workers_count(void) {
+    return workers.count;
+}
+
+int sim_workers_hardware_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) return 1;
+    return (n > SIM_WORKERS_MAX) ? SIM_WORKERS_MAX : (int)n;
+}
+
+void sim_workers_run(sim_task_fn fn, void *ctx, int task_count) {
+    if (workers.count <= 1 || task_count <= 1) {
+        for (int task = 0; task < task_count; task++) fn(ctx, task, 0);
+        return;
+    }
+    pthread_mutex_lock(&workers.lock);
+    workers.fn = fn;
+    workers.ctx = ctx;
+    workers.task_count = task_count;
+    atomic_store(&workers.next_task, 0);
+    workers.busy = workers.count - 1;
+    workers.job++;
+    pthread_cond_broadcast(&workers.wake);
+    pthread_mutex_unlock(&workers.lock);
+
+    // The calling thread works too
+    workers_drain(0);
+
+    pthread_mutex_lock(&workers.lock);
+    while (workers.busy > 0) {
+        pthread_cond_wait(&workers.done, &workers.lock);
+    }
+    pthread_mutex_unlock(&workers.lock);
+}
+
+#else
+
+// Single-threaded fallback: tasks run in order on the calling thread
+void sim_workers_init(int count) { (void)count; }
+void sim_workers_shutdown(void) {}
+void sim_workers_set_count(int count) { (void)count; }
+int sim_workers_count(void) { return 1; }
+int sim_workers_hardware_count(void) { return 1; }
+
+void sim_workers_run(sim_task_fn fn, void *ctx, int task_count) {
+    for (int task = 0; task < task_count; task++) fn(ctx, task, 0);
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+// -----------------------------------------------------------------------------
+// Persistent worker pool shared by all simulations
+//
+// sim_workers_run() hands out task indices [0, task_count) to the pool and
+// the calling thread, and returns once every task has finished. Tasks are
+// claimed dynamically, so anything that must be deterministic should be
+// accumulated per task (not per worker) and reduced in task order.
+// Builds without thread support run every task on the calling thread.
+// -----------------------------------------------------------------------------
+
+#define SIM_WORKERS_MAX 64
+
+typedef void (*sim_task_fn)(void *ctx, int task, int worker);
+
+void sim_workers_init(int count);
+void sim_workers_shutdown(void);
+
+// Resize the pool; count includes the calling thread
+void sim_workers_set_count(int count);
+int sim_workers_count(void);
+
+// Number of hardware threads (1 when threads are unavailable)
+int sim_workers_hardware_count(void);
+
+void sim_workers_run(sim_task_fn fn, void *ctx, int task_count);
+
+#endif /* WORKERS_H */
@@ -16,6 +16,7 @@
 #include "../lib/sokol/sokol_gfx.h"
 #include "../lib/sokol/sokol_log.h"
 #include "../lib/sokol/sokol_glue.h"
+#include "../lib/sokol/sokol_time.h"
 #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #include "../lib/cimgui/cimgui.h"
 #define SOKOL_IMGUI_IMPL
@@ -0,0 +1,4 @@
+// sokol_time implementation alone, for targets without sokol_app and
+// sokol_gfx (see batch.c)
+#define SOKOL_IMPL
+#include "../lib/sokol/sokol_time.h"